@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "CpuFeatures.h"
+
+namespace ThunderVision
+{
+/**
+* Computes the path costs L_r(p, d) of one pixel from the path costs of its predecessor along the path:
+* L_r(p, d) = C(p, d) + min(L_r(p-r, d), L_r(p-r, d-1) + P1, L_r(p-r, d+1) + P1, min_k L_r(p-r, k) + P2) - min_k L_r(p-r, k)
+* The path costs are written to current and added to aggregated. The return value is min_d L_r(p, d), so the minimum
+* of the predecessor never has to be searched for separately.
+* The costs have to be smaller or equal to UINT16_MAX - P2, in this case all path costs fit into 16 bit.
+* With 16 bit aggregated costs the sum over all paths saturates at UINT16_MAX.
+*/
+template <typename TAggregated>
+using AggregationStepKernel = uint16_t (*)(const uint16_t *costs, const uint16_t *previous, const uint16_t previousMin, uint16_t *current, TAggregated *aggregated, const size_t nrDisparities, const uint16_t P1, const uint16_t P2);
+
+/**
+* Starts a path at the image border: L_r(p, d) = C(p, d). Returns min_d L_r(p, d).
+*/
+template <typename TAggregated>
+using AggregationStartKernel = uint16_t (*)(const uint16_t *costs, uint16_t *current, TAggregated *aggregated, const size_t nrDisparities);
+
+template <typename TAggregated>
+struct AggregationKernels
+{
+	AggregationStepKernel<TAggregated> step;
+	AggregationStartKernel<TAggregated> start;
+	SimdLevel level;
+};
+
+/**
+* Selects the fastest kernels available on the executing CPU for the given number of disparities. The SIMD kernels
+* need a disparity count that is a multiple of their vector width, otherwise the next smaller kernel is used.
+* maxLevel allows to restrict the selection, e.g. to compare against the portable implementation.
+* Kernels are available for unsigned int and uint16_t aggregated costs.
+*/
+template <typename TAggregated>
+AggregationKernels<TAggregated> SelectAggregationKernels(const size_t nrDisparities, const SimdLevel maxLevel = SimdLevel::AVX2);
+} // namespace ThunderVision
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+#include "Tensor.h"
+#include "TensorView.h"
+#include "Exceptions.h"
+#include "ThreadPool.h"
+#include "CpuFeatures.h"
+#include "ColorspaceConversion.h"
+
+namespace ThunderVision
+{
+/**
+* Window sizes as width x height. All windows fit into a 64 bit vector.
+*/
+enum class CensusWindow
+{
+	W5x5,
+	W7x7,
+	W9x7
+};
+
+/**
+* Dense compares every pixel of the window with the center pixel, bit y_t * width + x_t is set if the center is
+* smaller than the pixel at (x_t, y_t). CenterSymmetric compares the pixels of the first half of the window in row
+* major order with their point reflection at the center, which halves the number of bits.
+*/
+enum class CensusType
+{
+	Dense,
+	CenterSymmetric
+};
+
+class CensusTransform
+{
+  public:
+	CensusTransform(CensusWindow window = CensusWindow::W5x5, CensusType type = CensusType::Dense);
+
+	size_t GetWindowWidth() const;
+	size_t GetWindowHeight() const;
+	size_t GetNrBits() const;
+	CensusWindow GetWindow() const;
+	CensusType GetType() const;
+
+	/**
+	* Value of the pixels closer to the image border than the window radius.
+	*/
+	void SetInvalidValue(uint64_t invalidValue);
+	uint64_t GetInvalidValue() const;
+
+	/**
+	* Pixel pairs of the CENSUS vectors of 8 bit rows which are rowStride elements apart, bit k is set if
+	* pixel[smaller[k]] < pixel[greater[k]], and the SIMD level of the row kernel. Prepared once per image, the rows
+	* of the image share it.
+	*/
+	struct RowContext
+	{
+		std::array<int64_t, 64> smaller;
+		std::array<int64_t, 64> greater;
+		size_t nrBits;
+		bool dense;
+		int64_t rowStride;
+		SimdLevel level;
+	};
+
+	RowContext PrepareRows(const int64_t rowStride, const SimdLevel maxLevel = SimdLevel::AVX512) const;
+
+	/**
+	* Computes the CENSUS vectors of a rank 2 image into census, which is resized if necessary. The rows are distributed
+	* over the threads of the pool, maxLevel allows to restrict the instruction set of the 8 bit rows.
+	*/
+	template <typename T>
+	void Compute(const Tensor<T> &image, Tensor<uint64_t> &census, ThreadPool &pool = ThreadPool::GetDefault(), SimdLevel maxLevel = SimdLevel::AVX512) const
+	{
+		Compute(TensorView<const T>(image), census, pool, maxLevel);
+	}
+
+	template <typename T>
+	void Compute(const TensorView<const T> &image, Tensor<uint64_t> &census, ThreadPool &pool = ThreadPool::GetDefault(), SimdLevel maxLevel = SimdLevel::AVX512) const
+	{
+		if (image.GetRank() != 2)
+			throw new ThunderException("The CENSUS transform requires a 2D grayscale image (rank 2 tensor).");
+
+		const size_t height = image.GetDimension(0);
+		const size_t width = image.GetDimension(1);
+		if (census.GetRank() != 2 || census.GetDimension(0) != height || census.GetDimension(1) != width)
+			census.Resize({height, width});
+
+		const RowContext context = PrepareRows(image.GetStride(0), maxLevel);
+		pool.ParallelFor(0, static_cast<int64_t>(height), [&](int64_t begin, int64_t end, size_t) {
+			for (int64_t y = begin; y < end; y++)
+			{
+				ComputeRow(image, static_cast<size_t>(y), context, census.Data() + y * width);
+			}
+		});
+	}
+
+	/**
+	* Computes the CENSUS vectors of the grayscale image of an 8 bit RGB image, without storing the grayscale image.
+	* Each thread converts the rows of its chunk once into a ring of window rows, so the results equal Compute of
+	* ColorspaceConversion::ConvertToGrayscale.
+	*/
+	void ComputeFromRGB(const TensorView<const uint8_t> &rgb, Tensor<uint64_t> &census, GrayscaleWeights weights = GrayscaleWeights::Average,
+						ThreadPool &pool = ThreadPool::GetDefault(), SimdLevel maxLevel = SimdLevel::AVX512) const;
+
+	/**
+	* Computes the CENSUS vectors of row y of a rank 2 image, context is prepared for the row stride of the image.
+	*/
+	template <typename T>
+	void ComputeRow(const TensorView<const T> &image, const size_t y, const RowContext &context, uint64_t *census) const
+	{
+		const size_t height = image.GetDimension(0);
+		const size_t width = image.GetDimension(1);
+		const int64_t rowStride = image.GetStride(0);
+		const int64_t pixelStride = image.GetStride(1);
+
+		std::fill(census, census + width, _invalidValue);
+		if (y < _radiusY || y + _radiusY >= height || width <= 2 * _radiusX)
+			return;
+
+		const T *row = image.Data() + static_cast<int64_t>(y) * rowStride;
+		if constexpr (std::is_same<T, uint8_t>::value)
+		{
+			if (pixelStride == 1 && rowStride == context.rowStride)
+			{
+				ComputeRowU8(row, width, context, census);
+				return;
+			}
+		}
+
+		for (size_t x = _radiusX; x < width - _radiusX; x++)
+		{
+			census[x] = ComputeVector(row + static_cast<int64_t>(x) * pixelStride, rowStride, pixelStride);
+		}
+	}
+
+  private:
+	CensusWindow _window;
+	CensusType _type;
+	size_t _windowWidth;
+	size_t _windowHeight;
+	size_t _radiusX;
+	size_t _radiusY;
+	uint64_t _invalidValue = UINT16_MAX;
+
+	void ComputeRowU8(const uint8_t *row, const size_t width, const RowContext &context, uint64_t *census) const;
+
+	// Element k of the window in row major order, relative to the center pixel
+	inline int64_t WindowOffset(const size_t k, const int64_t rowStride, const int64_t pixelStride) const
+	{
+		const int64_t windowY = static_cast<int64_t>(k / _windowWidth) - static_cast<int64_t>(_radiusY);
+		const int64_t windowX = static_cast<int64_t>(k % _windowWidth) - static_cast<int64_t>(_radiusX);
+		return windowY * rowStride + windowX * pixelStride;
+	}
+
+	template <typename T>
+	inline uint64_t ComputeVector(const T *center, const int64_t rowStride, const int64_t pixelStride) const
+	{
+		const size_t windowSize = _windowWidth * _windowHeight;
+
+		uint64_t vector = 0;
+		if (_type == CensusType::Dense)
+		{
+			const T basePixel = *center;
+			for (size_t k = 0; k < windowSize; k++)
+			{
+				vector |= static_cast<uint64_t>(basePixel < center[WindowOffset(k, rowStride, pixelStride)]) << k;
+			}
+			return vector;
+		}
+
+		const size_t nrBits = (windowSize - 1) / 2;
+		for (size_t k = 0; k < nrBits; k++)
+		{
+			vector |= static_cast<uint64_t>(center[WindowOffset(k, rowStride, pixelStride)] < center[WindowOffset(windowSize - 1 - k, rowStride, pixelStride)]) << k;
+		}
+		return vector;
+	}
+};
+} // namespace ThunderVision
@@ -1,9 +1,26 @@
 #pragma once
 
+#include <cstdint>
+
 #include "Tensor.h"
+#include "TensorView.h"
+#include "CpuFeatures.h"
+#include "ThreadPool.h"
 
 namespace ThunderVision
 {
+/**
+* Weights of the 8 bit grayscale conversion. Average is (r + g + b) / 3 truncated, like the float conversion. The
+* luma weights of BT.601 (0.299, 0.587, 0.114) and BT.709 (0.2126, 0.7152, 0.0722) are applied in 8 bit fixed point
+* ((77, 150, 29) and (54, 183, 19) / 256) and rounded.
+*/
+enum class GrayscaleWeights
+{
+	Average,
+	BT601,
+	BT709
+};
+
 class ColorspaceConversion
 {
   public:
@@ -22,5 +39,19 @@ class ColorspaceConversion
 		}
 		return result;
 	}
+
+	/**
+	* Converts an 8 bit RGB image {height, width, 3} (or RGBA, the fourth channel is ignored) into the rank 2
+	* grayscale image, which is only resized if its dimensions differ, so it can be passed to the stereo matching
+	* as is. Interleaved RGB rows are converted with SIMD integer arithmetic, the rows are distributed over the pool.
+	*/
+	static void ConvertToGrayscale(const TensorView<const uint8_t> &rgb, Tensor<uint8_t> &grayscale, GrayscaleWeights weights = GrayscaleWeights::Average,
+								   ThreadPool &pool = ThreadPool::GetDefault(), SimdLevel maxLevel = SimdLevel::AVX512);
+
+	/**
+	* Converts row y of an 8 bit RGB image into width grayscale pixels.
+	*/
+	static void ConvertRowToGrayscale(const TensorView<const uint8_t> &rgb, size_t y, uint8_t *grayscale, GrayscaleWeights weights = GrayscaleWeights::Average,
+									  SimdLevel maxLevel = SimdLevel::AVX512);
 };
-} // namespace ThunderVision
\ No newline at end of file
+} // namespace ThunderVision
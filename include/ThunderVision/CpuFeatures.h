@@ -0,0 +1,75 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define THUNDER_X86
+#endif
+
+#ifdef THUNDER_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit SIMD instructions for functions explicitly marked for the target ISA,
+// MSVC allows the intrinsics everywhere.
+#if defined(THUNDER_X86) && (defined(__GNUC__) || defined(__clang__))
+#define THUNDER_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define THUNDER_TARGET_AVX2 __attribute__((target("avx2")))
+#define THUNDER_TARGET_AVX512 __attribute__((target("avx2,avx512f,avx512bw,avx512vpopcntdq")))
+#else
+#define THUNDER_TARGET_SSE41
+#define THUNDER_TARGET_AVX2
+#define THUNDER_TARGET_AVX512
+#endif
+
+namespace ThunderVision
+{
+enum class SimdLevel
+{
+	Portable = 0,
+	SSE41 = 1,
+	AVX2 = 2,
+	// AVX-512 F, BW and VPOPCNTDQ
+	AVX512 = 3
+};
+
+/**
+* Returns the best instruction set extension supported by the executing CPU.
+*/
+inline SimdLevel GetSupportedSimdLevel()
+{
+#if defined(THUNDER_X86) && (defined(__GNUC__) || defined(__clang__))
+	static const SimdLevel level = []() {
+		if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vpopcntdq"))
+			return SimdLevel::AVX512;
+		return __builtin_cpu_supports("avx2") ? SimdLevel::AVX2 : (__builtin_cpu_supports("sse4.1") ? SimdLevel::SSE41 : SimdLevel::Portable);
+	}();
+	return level;
+#elif defined(THUNDER_X86) && defined(_MSC_VER)
+	static const SimdLevel level = []() {
+		int info[4];
+		__cpuid(info, 0);
+		const int nrIds = info[0];
+		__cpuid(info, 1);
+		const bool sse41 = (info[2] & (1 << 19)) != 0;
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx2 = false;
+		bool avx512 = false;
+		if (nrIds >= 7 && osxsave && (_xgetbv(0) & 0x6) == 0x6)
+		{
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+			// The OS has to save the opmask and zmm registers as well
+			avx512 = avx2 && (_xgetbv(0) & 0xE6) == 0xE6 && (info[1] & (1 << 16)) != 0 && (info[1] & (1 << 30)) != 0 && (info[2] & (1 << 14)) != 0;
+		}
+		if (avx512)
+			return SimdLevel::AVX512;
+		return avx2 ? SimdLevel::AVX2 : (sse41 ? SimdLevel::SSE41 : SimdLevel::Portable);
+	}();
+	return level;
+#else
+	return SimdLevel::Portable;
+#endif
+}
+} // namespace ThunderVision
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "Tensor.h"
+
+namespace ThunderVision
+{
+/**
+* Layout of a compact cost volume with a disparity range [minimum, minimum + count) per pixel. The costs of pixel i
+* start at GetOffsets()[i] of the volume, the stored number of disparities is the count padded to a multiple of
+* Granularity, so the SIMD aggregation kernels apply to every pixel. The padded disparities carry error costs and are
+* skipped by the disparity selection. Empty ranges have a count of 0 and invalid disparities, but they keep one block
+* of padded error costs, so every aggregation path stays connected.
+*/
+class DisparityRanges
+{
+  public:
+	static constexpr size_t Granularity = 16;
+
+	/**
+	* Resizes the tables to (height, width), the ranges have to be set again.
+	*/
+	void Resize(const size_t width, const size_t height);
+
+	/**
+	* Sets the range of the pixel to [minimum, maximum), which may be empty.
+	*/
+	void Set(const size_t pixel, const int32_t minimum, const int32_t maximum)
+	{
+		_minima[pixel] = minimum;
+		_counts[pixel] = static_cast<uint16_t>(maximum > minimum ? maximum - minimum : 0);
+	}
+
+	/**
+	* Computes the cost offsets from the ranges, has to be called after the last Set.
+	*/
+	void UpdateOffsets();
+
+	// Number of stored costs of a pixel, at least Granularity for empty ranges
+	static size_t PadCount(const size_t count)
+	{
+		return count == 0 ? Granularity : (count + Granularity - 1) / Granularity * Granularity;
+	}
+
+	size_t GetWidth() const;
+	size_t GetHeight() const;
+	// Number of stored costs of all pixels
+	size_t GetTotalSize() const;
+	// Largest padded count of a pixel
+	size_t GetMaxCount() const;
+
+	const int32_t *GetMinima() const;
+	const uint16_t *GetCounts() const;
+	const size_t *GetOffsets() const;
+
+  private:
+	size_t _width = 0;
+	size_t _height = 0;
+	size_t _totalSize = 0;
+	size_t _maxCount = 0;
+	Tensor<int32_t> _minima;
+	Tensor<uint16_t> _counts;
+	Tensor<size_t> _offsets;
+};
+} // namespace ThunderVision
@@ -1,15 +1,168 @@
 #pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
 #include <vector>
 
 #include "Tensor.h"
+#include "TensorView.h"
+#include "SeparableFilter.h"
 
 namespace ThunderVision
 {
 class FilterUtil
 {
   public:
+	/**
+	* Reflects index into [0, size) with pixel -1 mapped to 0 and pixel size to size - 1, repeatedly for kernels
+	* larger than the image.
+	*/
+	static inline int64_t Reflect(int64_t index, const int64_t size)
+	{
+		while (index < 0 || index >= size)
+		{
+			index = index < 0 ? -index - 1 : 2 * size - 1 - index;
+		}
+		return index;
+	}
+
+	/**
+	* Maps index into [0, size) according to the border mode, -1 for BorderMode::Constant outside the image.
+	*/
+	static inline int64_t BorderIndex(const int64_t index, const int64_t size, const BorderMode border)
+	{
+		if (index >= 0 && index < size)
+			return index;
+		if (border == BorderMode::Replicate)
+			return index < 0 ? 0 : size - 1;
+		if (border == BorderMode::Constant)
+			return -1;
+		return Reflect(index, size);
+	}
+
+	/**
+	* Converts a filter result to T, integers are rounded to the nearest value and saturated.
+	*/
+	template <typename T>
+	static inline T RoundAndSaturate(const float value)
+	{
+		if constexpr (std::is_integral<T>::value)
+		{
+			const float rounded = std::nearbyint(value);
+			if (rounded <= static_cast<float>(std::numeric_limits<T>::min()))
+				return std::numeric_limits<T>::min();
+			if (rounded >= static_cast<float>(std::numeric_limits<T>::max()))
+				return std::numeric_limits<T>::max();
+			return static_cast<T>(rounded);
+		}
+		else
+		{
+			return static_cast<T>(value);
+		}
+	}
+
+	/**
+	* Converts a row of filter results like RoundAndSaturate, with the SIMD kernels for uint8_t and uint16_t.
+	*/
+	template <typename T>
+	static inline void RoundAndSaturate(const SeparableFilterKernels &kernels, const float *values, const size_t length, T *out)
+	{
+		if constexpr (std::is_same<T, uint8_t>::value)
+		{
+			kernels.roundUint8(values, length, out);
+		}
+		else if constexpr (std::is_same<T, uint16_t>::value)
+		{
+			kernels.roundUint16(values, length, out);
+		}
+		else
+		{
+			for (size_t i = 0; i < length; i++)
+			{
+				out[i] = RoundAndSaturate<T>(values[i]);
+			}
+		}
+	}
+
+	/**
+	* Convolves with a separable kernel pair, see SeparableFilter for the supported types and the arithmetic.
+	*/
+	template <typename TOut, typename TIn>
+	void ApplySeparable(const TensorView<const TIn> &input, const Tensor<double> &kernelX, const Tensor<double> &kernelY, Tensor<TOut> &output,
+						const BorderMode border = BorderMode::Reflect, const double borderValue = 0.0)
+	{
+		separableFilter.Apply(input, kernelX, kernelY, output, border, borderValue);
+	}
+
+	/**
+	* Convolves with a 2D kernel of shape (kernelHeight, kernelWidth).
+	*/
+	template <typename TOut, typename TIn>
+	void Apply2D(const TensorView<const TIn> &input, const Tensor<double> &kernel, Tensor<TOut> &output, const BorderMode border = BorderMode::Reflect,
+				 const double borderValue = 0.0)
+	{
+		separableFilter.Apply2D(input, kernel, output, border, borderValue);
+	}
+
+	enum class DerivativeKernel
+	{
+		Sobel,
+		Scharr
+	};
+
+	/**
+	* First derivative along x (X = 1, Y = 0) or y (X = 0, Y = 1) with the 3x3 Sobel or Scharr kernel, positive where
+	* the intensity grows. uint8_t images to int16_t are exact.
+	*/
+	template <int X, int Y, typename TOut, typename TIn>
+	void ApplyDerivative(const TensorView<const TIn> &input, Tensor<TOut> &output, const DerivativeKernel type = DerivativeKernel::Sobel,
+						 const BorderMode border = BorderMode::Reflect, const double borderValue = 0.0)
+	{
+		static_assert((X == 1 && Y == 0) || (X == 0 && Y == 1), "Only first derivatives along x or y are supported");
+
+		const double side = type == DerivativeKernel::Sobel ? 1.0 : 3.0;
+		const double center = type == DerivativeKernel::Sobel ? 2.0 : 10.0;
+		Tensor<double> derivative({3});
+		Tensor<double> smoothing({3});
+		derivative[0] = -1.0;
+		derivative[1] = 0.0;
+		derivative[2] = 1.0;
+		smoothing[0] = side;
+		smoothing[1] = center;
+		smoothing[2] = side;
+		if (X == 1)
+			separableFilter.Apply(input, derivative, smoothing, output, border, borderValue);
+		else
+			separableFilter.Apply(input, smoothing, derivative, output, border, borderValue);
+	}
+
+	/**
+	* Box filter of Size x Size pixels, the mean if normalize is set and the sum otherwise.
+	*/
+	template <size_t Size, typename TOut, typename TIn>
+	void ApplyBoxFilter(const TensorView<const TIn> &input, Tensor<TOut> &output, const bool normalize = true, const BorderMode border = BorderMode::Reflect,
+						const double borderValue = 0.0)
+	{
+		static_assert(Size % 2 == 1, "The box size has to be uneven");
+
+		Tensor<double> box({Size});
+		for (size_t i = 0; i < Size; i++)
+		{
+			box[i] = normalize ? 1.0 / Size : 1.0;
+		}
+		separableFilter.Apply(input, box, box, output, border, borderValue);
+	}
+
 	template <int X, int Y, typename TOut, typename TIn, typename TMask>
 	Tensor<TOut> ApplyFilter(const Tensor<TIn> &input, const Tensor<TMask> &mask)
+	{
+		return ApplyFilter<X, Y, TOut>(TensorView<const TIn>(input), mask);
+	}
+
+	template <int X, int Y, typename TOut, typename TIn, typename TMask>
+	Tensor<TOut> ApplyFilter(const TensorView<const TIn> &input, const Tensor<TMask> &mask)
 	{
 		static_assert(X >= 0, "X has to be greater or equal to zero");
 		static_assert(Y >= 0, "Y has to be greater or equal to zero");
@@ -28,6 +181,10 @@ class FilterUtil
 		const int64_t width = static_cast<int64_t>(input.GetDimension(1));
 		const int64_t channels = input.GetRank() == 3 ? static_cast<int64_t>(input.GetDimension(2)) : 1;
 
+		const int64_t strideY = input.GetStride(0);
+		const int64_t strideX = input.GetStride(1);
+		const int64_t strideC = input.GetRank() == 3 ? input.GetStride(2) : 0;
+
 		Tensor<TOut> blurred({input.GetDimension(0), input.GetDimension(1), static_cast<size_t>(channels)});
 
 		size_t pos = 0;
@@ -35,8 +192,9 @@ class FilterUtil
 		{
 			for (int64_t x = 0; x < width; x++)
 			{
-				for (size_t c = 0; c < channels; c++, pos++)
+				for (int64_t c = 0; c < channels; c++, pos++)
 				{
+					const TIn *pixel = input.Data() + y * strideY + x * strideX + c * strideC;
 					double value = 0.0;
 					for (int64_t i = 0; i < maskSize; i++)
 					{
@@ -57,7 +215,7 @@ class FilterUtil
 							}
 							else if (target_x >= width)
 							{
-								target_x = width + maskSizeHalf - i;
+								target_x = 2 * width - 1 - target_x;
 								offset_x = target_x - x;
 							}
 						}
@@ -71,11 +229,11 @@ class FilterUtil
 							}
 							else if (target_y >= height)
 							{
-								target_y = height + maskSizeHalf - i;
+								target_y = 2 * height - 1 - target_y;
 								offset_y = target_y - y;
 							}
 						}
-						value += mask[i] * input[pos + static_cast<size_t>((offset_y * width + offset_x) * channels)];
+						value += mask[i] * pixel[offset_y * strideY + offset_x * strideX];
 					}
 					blurred[pos] = static_cast<TOut>(value);
 				}
@@ -83,5 +241,8 @@ class FilterUtil
 		}
 		return blurred;
 	}
+
+  private:
+	SeparableFilter separableFilter;
 };
 } // namespace ThunderVision
\ No newline at end of file
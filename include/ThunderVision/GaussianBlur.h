@@ -1,7 +1,12 @@
 #pragma once
 
+#include <cmath>
+
 #include "Tensor.h"
+#include "TensorView.h"
 #include "FilterUtil.h"
+#include "SeparableFilter.h"
+#include "RecursiveGaussian.h"
 
 namespace ThunderVision
 {
@@ -11,6 +16,34 @@ class GaussianBlur
 	template <typename T>
 	Tensor<T> ApplyGaussian(const Tensor<T> &tensor, const double sigma)
 	{
+		return ApplyGaussian(TensorView<const T>(tensor), sigma);
+	}
+
+	template <typename T>
+	Tensor<T> ApplyGaussian(const Tensor<T> &tensor, const double sigma, const int filterSize)
+	{
+		return ApplyGaussian(TensorView<const T>(tensor), sigma, filterSize);
+	}
+
+	/**
+	* Sigma from which ApplyGaussian(tensor, sigma) uses the recursive filter for float, uint8_t and uint16_t images.
+	* Its cost does not grow with sigma, below the threshold the FIR kernel is faster.
+	*/
+	static constexpr double RecursiveSigmaThreshold = 8.0;
+
+	template <typename T>
+	Tensor<T> ApplyGaussian(const TensorView<const T> &tensor, const double sigma)
+	{
+		if constexpr (SeparableFilter::IsSupported<T>())
+		{
+			if (sigma >= RecursiveSigmaThreshold)
+			{
+				Tensor<T> blurred;
+				recursiveGaussian.Apply(tensor, sigma, blurred);
+				return blurred;
+			}
+		}
+
 		int size = static_cast<int>(2.0 * sigma);
 		int filterSize = 2 * size;
 		if (filterSize % 2 == 0)
@@ -19,7 +52,7 @@ class GaussianBlur
 	}
 
 	template <typename T>
-	Tensor<T> ApplyGaussian(const Tensor<T> &tensor, const double sigma, const int filterSize)
+	Tensor<T> ApplyGaussian(const TensorView<const T> &tensor, const double sigma, const int filterSize)
 	{
 		if (filterSize % 2 != 1)
 		{
@@ -27,12 +60,23 @@ class GaussianBlur
 		}
 		auto mask = generateGaussianMask1D<double>(sigma, filterSize);
 
-		auto filteredX = filterUtility.ApplyFilter<1, 0, double>(tensor, mask);
-		return filterUtility.ApplyFilter<0, 1, T>(filteredX, mask);
+		if constexpr (SeparableFilter::IsSupported<T>())
+		{
+			Tensor<T> blurred;
+			separableFilter.Apply(tensor, mask, mask, blurred);
+			return blurred;
+		}
+		else
+		{
+			auto filteredX = filterUtility.ApplyFilter<1, 0, double>(tensor, mask);
+			return filterUtility.ApplyFilter<0, 1, T>(filteredX, mask);
+		}
 	}
 
   private:
 	FilterUtil filterUtility;
+	SeparableFilter separableFilter;
+	RecursiveGaussian recursiveGaussian;
 
 	template <typename T>
 	Tensor<T> generateGaussianMask1D(const double sigma, const size_t filterSize)
@@ -62,7 +106,7 @@ class GaussianBlur
 
 		T factor = 1.0 / sumOfValues;
 
-		for (int i = 0; i < filterSize; ++i)
+		for (size_t i = 0; i < filterSize; ++i)
 		{
 			filter[i] = factor * filter[i];
 		}
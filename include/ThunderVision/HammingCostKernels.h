@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "CpuFeatures.h"
+
+namespace ThunderVision
+{
+/**
+* Computes the Hamming distances of base to a run of CENSUS vectors: costs[d] = popcount(base ^ vectors[d]) for the
+* forward and costs[d] = popcount(base ^ vectors[-d]) for the backward kernel, d < count.
+*/
+using HammingCostKernel = void (*)(const uint64_t base, const uint64_t *vectors, const size_t count, uint16_t *costs);
+
+struct HammingCostKernels
+{
+	HammingCostKernel forward;
+	HammingCostKernel backward;
+	SimdLevel level;
+};
+
+/**
+* Selects the fastest kernels available on the executing CPU. The AVX-512 kernels use VPOPCNTQ, the AVX2 kernels a
+* nibble lookup table. maxLevel allows to restrict the selection, e.g. to compare against the portable implementation.
+*/
+HammingCostKernels SelectHammingCostKernels(const SimdLevel maxLevel = SimdLevel::AVX512);
+} // namespace ThunderVision
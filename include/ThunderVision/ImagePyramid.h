@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Tensor.h"
+#include "TensorView.h"
+#include "ThreadPool.h"
+#include "GaussianBlur.h"
+#include "ImageResizing.h"
+
+namespace ThunderVision
+{
+/**
+* Image pyramid of images with shape (height, width) or (height, width, channels). Level 0 is the input image, every
+* further level has half the width and height of its predecessor, rounded up, and is its area average (2x2 pixels
+* for even sizes). An optional Gaussian smoothing suppresses aliasing further before each halving. The level tensors
+* are reused by the next Build with the same image size. Supports uint8_t, uint16_t and float.
+*/
+template <typename T>
+class ImagePyramid
+{
+  public:
+	ImagePyramid(const SimdLevel maxLevel = SimdLevel::AVX512);
+
+	/**
+	* Builds nrLevels levels including the input image, which has to stay valid while the levels are used.
+	*/
+	void Build(const TensorView<const T> &image, const size_t nrLevels, ThreadPool &pool = ThreadPool::GetDefault());
+
+	/**
+	* Standard deviation of the Gaussian applied before each halving, 0 (the default) only averages.
+	*/
+	void SetSmoothing(const double sigma);
+	double GetSmoothing() const;
+
+	size_t GetNrLevels() const;
+
+	/**
+	* Level of the same rank as the input image.
+	*/
+	TensorView<const T> GetLevel(const size_t level) const;
+
+  private:
+	ImageResizing _resizing;
+	GaussianBlur _gaussianBlur;
+	double _sigma = 0.0;
+	TensorView<const T> _image;
+	std::vector<Tensor<T>> _levels;
+};
+} // namespace ThunderVision
@@ -1,70 +1,129 @@
 #pragma once
 #include "Tensor.h"
+#include "TensorView.h"
+#include "ThreadPool.h"
+#include "SeparableFilterKernels.h"
 
 #include <iostream>
+#include <type_traits>
 
 namespace ThunderVision
 {
+	/**
+	* Bilinear samples output pixel (x, y) at input position (x * width / outputWidth, y * height / outputHeight) with
+	* the last row and column repeated. Area averages the input pixels covered by the output pixel weighted by their
+	* coverage, which is the right choice for large downscale factors.
+	*/
+	enum class ResizeMode
+	{
+		Bilinear,
+		Area
+	};
+
+	/**
+	* Resizes images of shape (height, width) or (height, width, channels). Resize precomputes the source indices and
+	* weights of every output column and row, blends the source rows of an output row with the SIMD filter kernels
+	* and gathers the output columns from the blended row, so there are no per pixel bounds checks. The output rows
+	* are split across the threads of the pool. Integer results are rounded and saturated.
+	*/
 	class ImageResizing
 	{
 	public:
+		ImageResizing(const SimdLevel maxLevel = SimdLevel::AVX512);
+
+		template<typename T> static constexpr bool IsSupported()
+		{
+			return std::is_same<T, float>::value || std::is_same<T, uint8_t>::value || std::is_same<T, uint16_t>::value;
+		}
+
+		/**
+		* Writes the resized image to output, which is resized to (outputHeight, outputWidth, channels) if necessary.
+		* Supports float, uint8_t and uint16_t input and output, downscaling and upscaling.
+		*/
+		template<typename TIn, typename TOut> void Resize(const TensorView<const TIn>& input, const size_t outputWidth, const size_t outputHeight, Tensor<TOut>& output,
+			const ResizeMode mode = ResizeMode::Bilinear, ThreadPool& pool = ThreadPool::GetDefault());
+
 		template<typename TIn, typename TOut> Tensor<TOut> DownscaleImage(const Tensor<TIn>& input, const size_t outputWidth, const size_t outputHeight)
+		{
+			return DownscaleImage<TIn, TOut>(TensorView<const TIn>(input), outputWidth, outputHeight);
+		}
+
+		/**
+		* Bilinear resize to a new tensor, any size is allowed despite the name.
+		*/
+		template<typename TIn, typename TOut> Tensor<TOut> DownscaleImage(const TensorView<const TIn>& input, const size_t outputWidth, const size_t outputHeight)
 		{
 			if (input.GetRank() != 3 && input.GetRank() != 2)
 				throw new ThunderException("Only images (tensors with two or three dimensions) are supported");
-			if (outputWidth > input.GetDimension(1) || outputHeight > input.GetDimension(0))
-				throw new ThunderException("The output size must be smaller than the input size");
 
-			const size_t channels = input.GetRank() == 3 ? input.GetDimension(2) : 1;
-			const int64_t width = static_cast<int64_t>(input.GetDimension(1));
-			const int64_t height = static_cast<int64_t>(input.GetDimension(0));
+			if constexpr (IsSupported<TIn>() && IsSupported<TOut>())
+			{
+				Tensor<TOut> resized;
+				Resize(input, outputWidth, outputHeight, resized);
+				return resized;
+			}
+			else
+			{
+				// Other types keep the direct bilinear sampling
+				const size_t channels = input.GetRank() == 3 ? input.GetDimension(2) : 1;
+				const int64_t width = static_cast<int64_t>(input.GetDimension(1));
+				const int64_t height = static_cast<int64_t>(input.GetDimension(0));
 
-			const float scaleX = static_cast<float>(width) / outputWidth;
-			const float scaleY = static_cast<float>(height) / outputHeight;
+				const float scaleX = static_cast<float>(width) / outputWidth;
+				const float scaleY = static_cast<float>(height) / outputHeight;
 
-			Tensor<TOut> result({ outputHeight, outputWidth, channels });
+				Tensor<TOut> result({ outputHeight, outputWidth, channels });
 
-			size_t outIndex = 0;
-			for (int64_t y_out = 0; y_out < outputHeight; y_out++)
-			{
-				for (int64_t x_out = 0; x_out < outputWidth; x_out++)
+				size_t outIndex = 0;
+				for (size_t y_out = 0; y_out < outputHeight; y_out++)
 				{
-					float y = scaleY * y_out;
-					float x = scaleX * x_out;
-
-					for (size_t c = 0; c < channels; c++, outIndex++)
+					for (size_t x_out = 0; x_out < outputWidth; x_out++)
 					{
-						result[outIndex] = static_cast<TOut>(GetValue(input, x, y, c));
+						float y = scaleY * y_out;
+						float x = scaleX * x_out;
+
+						for (size_t c = 0; c < channels; c++, outIndex++)
+						{
+							result[outIndex] = static_cast<TOut>(GetValue(input, x, y, c));
+						}
 					}
 				}
+				return result;
 			}
-			return result;
 		}
 
 	private:
-		template<typename TIn> inline float GetValue(const Tensor<TIn>& input, const float x, const float y, const size_t c)
+		SeparableFilterKernels _kernels;
+		Tensor<int32_t> _columnIndices;
+		Tensor<float> _columnWeights;
+		Tensor<int32_t> _rowIndices;
+		Tensor<float> _rowWeights;
+		Tensor<float> _buffer;
+
+		template<typename TIn> inline float GetValue(const TensorView<const TIn>& input, const float x, const float y, const size_t c)
 		{
 			int64_t x_p = (int64_t)x;
 			int64_t y_p = (int64_t)y;
 
-			const size_t channels = input.GetRank() == 2 ? 1 : input.GetDimension(2);
+			const int64_t strideY = input.GetStride(0);
+			const int64_t strideX = input.GetStride(1);
+			const int64_t strideC = input.GetRank() == 2 ? 0 : input.GetStride(2);
 
-			const size_t width = input.GetDimension(1);
-			size_t basePos = (y_p * width + x_p)* channels + c;
-			auto pix00 = input[basePos];
+			const TIn* base = input.Data() + y_p * strideY + x_p * strideX + static_cast<int64_t>(c) * strideC;
+			auto pix00 = base[0];
 
 			auto pix10 = pix00;
 			auto pix01 = pix00;
 			auto pix11 = pix00;
 
-			if (x_p + 1 < input.GetDimension(1))
+			if (x_p + 1 < static_cast<int64_t>(input.GetDimension(1)))
 			{
-				pix10 = input[basePos + channels];
+				pix10 = base[strideX];
 
-				if (y_p + 1 < input.GetDimension(0))
+				if (y_p + 1 < static_cast<int64_t>(input.GetDimension(0)))
 				{
-					pix01 = input[basePos + width * channels];
-					pix11 = input[basePos + width * channels + channels];
+					pix01 = base[strideY];
+					pix11 = base[strideY + strideX];
 				}
 			}
 
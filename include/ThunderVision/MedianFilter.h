@@ -2,8 +2,14 @@
 #define NOMINMAX
 #include <cassert>
 #include <algorithm>
+#include <array>
+#include <limits>
+#include <type_traits>
 
 #include "Tensor.h"
+#include "TensorView.h"
+#include "MedianKernels.h"
+#include "ThreadPool.h"
 
 namespace ThunderVision
 {
@@ -13,7 +19,21 @@ namespace ThunderVision
 		MedianFilter() {  }
 		~MedianFilter() {}
 
-		template<size_t filtersize_x, size_t filtersize_y, typename T> Tensor<T> ApplyMedianFilter(const Tensor<T>& input)
+		template<size_t filtersize_x, size_t filtersize_y, typename T> Tensor<T> ApplyMedianFilter(const Tensor<T>& input, ThreadPool& pool = ThreadPool::GetDefault())
+		{
+			return ApplyMedianFilter<filtersize_x, filtersize_y>(TensorView<const T>(input), pool);
+		}
+
+		template<size_t filtersize_x, size_t filtersize_y, typename T> Tensor<T> ApplyMedianFilter(const TensorView<const T>& input, ThreadPool& pool = ThreadPool::GetDefault())
+		{
+			Tensor<T> result;
+			ApplyMedianFilter<filtersize_x, filtersize_y>(input, result, pool);
+			return result;
+		}
+
+		// Writes the filtered image to result, which is only resized if its dimensions differ. The rows of the interior
+		// are distributed over the pool.
+		template<size_t filtersize_x, size_t filtersize_y, typename T> void ApplyMedianFilter(const TensorView<const T>& input, Tensor<T>& result, ThreadPool& pool = ThreadPool::GetDefault())
 		{
 			static_assert(filtersize_x % 2 == 1, "Median filtersize has to be uneven.");
 			static_assert(filtersize_y % 2 == 1, "Median filtersize has to be uneven.");
@@ -22,34 +42,56 @@ namespace ThunderVision
 			const size_t height = input.GetDimension(0);
 			const size_t width = input.GetDimension(1);
 			const size_t channels = input.GetRank() == 2 ? 1 : input.GetDimension(2);
-	
-			const int width_i = static_cast<int>(width);
+
+			const int64_t strideY = input.GetStride(0);
+			const int64_t strideX = input.GetStride(1);
+			const int64_t strideC = input.GetRank() == 2 ? 0 : input.GetStride(2);
 
 			const size_t filtersize_x_h = (filtersize_x - 1) / 2;
 			const size_t filtersize_y_h = (filtersize_y - 1) / 2;
 
-			std::vector<T> mask(filtersize_x * filtersize_y);
-			Tensor<T> result({ height, width, channels });
+			std::array<T, filtersize_x * filtersize_y> mask;
+			if (result.GetDimensions() != std::vector<size_t>{ height, width, channels })
+				result.Resize({ height, width, channels });
+
+			// Windows which do not touch the border are computed by the fast kernels, the border keeps the reference
+			// code below since its error values depend on the processing order.
+			const size_t interiorXBegin = filtersize_x_h;
+			const size_t interiorXEnd = width > 2 * filtersize_x_h ? width - filtersize_x_h : 0;
+			const size_t interiorYBegin = filtersize_y_h;
+			const size_t interiorYEnd = height > 2 * filtersize_y_h ? height - filtersize_y_h : 0;
+			const bool interior = interiorXBegin < interiorXEnd && interiorYBegin < interiorYEnd &&
+				ApplyFastMedianFilter(input, filtersize_x_h, filtersize_y_h, interiorXBegin, interiorXEnd, interiorYBegin, interiorYEnd, result, pool);
 
 			auto error_value = std::numeric_limits<T>::max() - 1;//TODO: std::min(std::numeric_limits<T>::max(), std::abs(std::numeric_limits<T>::min()));
 
 			for (size_t c = 0; c < channels; c++)
 			{
-				int pos = c;
+				size_t pos = c;
 				for (size_t y = 0; y < height; y++)
 				{
+					const bool interiorRow = interior && y >= interiorYBegin && y < interiorYEnd;
 					for (size_t x = 0; x < width; x++, pos+=channels)
 					{
-						int basePos = pos - (static_cast<int>(filtersize_y_h * width) + static_cast<int>(filtersize_x_h)) * channels;
+						if (interiorRow && x == interiorXBegin)
+						{
+							pos += (interiorXEnd - interiorXBegin) * channels;
+							x = interiorXEnd;
+							if (x == width)
+								break;
+						}
+
+						// Top left element of the window, it is only dereferenced inside of the image
+						const T* window = input.Data() + (static_cast<int64_t>(y) - static_cast<int64_t>(filtersize_y_h)) * strideY + (static_cast<int64_t>(x) - static_cast<int64_t>(filtersize_x_h)) * strideX + static_cast<int64_t>(c) * strideC;
 						size_t targetPos = 0;
 
-						for (size_t y_t = 0; y_t < filtersize_x; y_t++)
+						for (size_t y_t = 0; y_t < filtersize_y; y_t++)
 						{
-							for (size_t x_t = 0; x_t < filtersize_y; x_t++, targetPos++)
+							for (size_t x_t = 0; x_t < filtersize_x; x_t++, targetPos++)
 							{
-								if (x + x_t >= filtersize_x_h && y + y_t >= filtersize_y_h && x + x_t < width && y + y_t < height)
+								if (x + x_t >= filtersize_x_h && y + y_t >= filtersize_y_h && x + x_t < width + filtersize_x_h && y + y_t < height + filtersize_y_h)
 								{
-									mask[targetPos] = input[basePos + x_t*channels];
+									mask[targetPos] = window[static_cast<int64_t>(y_t) * strideY + static_cast<int64_t>(x_t) * strideX];
 								}
 								else
 								{
@@ -57,7 +99,6 @@ namespace ThunderVision
 									error_value *= -1;
 								}
 							}
-							basePos += width_i * channels;
 						}
 
 
@@ -65,14 +106,51 @@ namespace ThunderVision
 					}
 				}
 			}
-			return result;
 		}
 
 	private:
-		template<typename T> inline T GetMedian(std::vector<T>& mask)
+		template<typename T, size_t size> inline T GetMedian(std::array<T, size>& mask)
 		{
-			std::sort(mask.begin(), mask.end());
-			return mask[(mask.size() - 1) / 2];
+			auto median = mask.begin() + (mask.size() - 1) / 2;
+			std::nth_element(mask.begin(), median, mask.end());
+			return *median;
+		}
+
+		// Computes the interior medians of every channel with ComputeMedians, false if there is no fast kernel for the type
+		template<typename T> bool ApplyFastMedianFilter(const TensorView<const T>& input, size_t radiusX, size_t radiusY, size_t xBegin, size_t xEnd, size_t yBegin, size_t yEnd, Tensor<T>& result, ThreadPool& pool)
+		{
+			if constexpr (std::is_same<T, float>::value || std::is_same<T, uint8_t>::value || std::is_same<T, uint16_t>::value)
+			{
+				const size_t height = input.GetDimension(0);
+				const size_t width = input.GetDimension(1);
+				const size_t channels = input.GetRank() == 2 ? 1 : input.GetDimension(2);
+
+				if (channels == 1 && input.GetStride(1) == 1)
+					return ComputeMedians(input.Data(), input.GetStride(0), radiusX, radiusY, xBegin, xEnd, yBegin, yEnd, result.Data(), static_cast<int64_t>(width), pool);
+
+				Tensor<T> plane;
+				Tensor<T> medians({ height, width });
+				for (size_t c = 0; c < channels; c++)
+				{
+					const TensorView<const T> channel = input.GetRank() == 2 ? input : input.Slice(2, c);
+					channel.CopyTo(plane);
+					if (!ComputeMedians(plane.Data(), static_cast<int64_t>(width), radiusX, radiusY, xBegin, xEnd, yBegin, yEnd, medians.Data(), static_cast<int64_t>(width), pool))
+						return false;
+
+					for (size_t y = yBegin; y < yEnd; y++)
+					{
+						for (size_t x = xBegin; x < xEnd; x++)
+						{
+							result[(y * width + x) * channels + c] = medians[y * width + x];
+						}
+					}
+				}
+				return true;
+			}
+			else
+			{
+				return false;
+			}
 		}
 	};
 }
\ No newline at end of file
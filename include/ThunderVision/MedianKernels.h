@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "CpuFeatures.h"
+#include "ThreadPool.h"
+
+namespace ThunderVision
+{
+/**
+* Computes the medians of the (2 radiusX + 1) x (2 radiusY + 1) windows centered at the pixels [xBegin, xEnd) x
+* [yBegin, yEnd) of a single channel image and writes them to medians[y * medianRowStride + x]. All windows have to
+* lie inside of the image. The pixels of a row have to be contiguous, rows are rowStride elements apart.
+*
+* 3x3 and 5x5 windows are computed by sorting networks on SIMD registers (the 3x3 network shares the sorted columns
+* between neighbouring windows). Larger 8 bit windows use the constant time histogram median of Perreault and
+* Hebert, larger 16 bit windows a sliding two level histogram (Huang). The rows are distributed over the pool.
+*
+* Implemented for float, uint8_t and uint16_t. Returns false without computing anything if there is no fast
+* implementation for the window size, e.g. float windows larger than 5x5.
+*/
+template <typename T>
+bool ComputeMedians(const T *image, const int64_t rowStride, const size_t radiusX, const size_t radiusY, const size_t xBegin, const size_t xEnd,
+					const size_t yBegin, const size_t yEnd, T *medians, const int64_t medianRowStride, ThreadPool &pool, const SimdLevel maxLevel = SimdLevel::AVX512);
+} // namespace ThunderVision
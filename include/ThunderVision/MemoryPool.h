@@ -0,0 +1,169 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+
+namespace ThunderVision
+{
+/**
+* Alignment of all tensor buffers, one cache line and the width of an AVX-512 register.
+*/
+constexpr size_t TensorAlignment = 64;
+
+struct HeapAllocationCounters
+{
+	size_t allocations = 0;
+	size_t deallocations = 0;
+	size_t allocatedBytes = 0;
+};
+
+/**
+* Allocates aligned memory from the system heap. All tensor allocators use these functions, so the counters show
+* every heap allocation of tensor storage, e.g. to verify that a steady state video pipeline does not allocate.
+*/
+void *AllocateAligned(size_t bytes);
+void DeallocateAligned(void *pointer, size_t bytes);
+HeapAllocationCounters GetHeapAllocationCounters();
+
+struct MemoryPoolStatistics
+{
+	// Requests served from cached buffers and requests which had to allocate from the heap
+	size_t reusedAllocations = 0;
+	size_t heapAllocations = 0;
+	size_t cachedBuffers = 0;
+	size_t cachedBytes = 0;
+};
+
+/**
+* Thread safe cache of aligned buffers. Requests are rounded up to size classes, four per power of two, so at most
+* 25% of a buffer are unused. Returned buffers are kept in a free list of their class and handed out again for
+* requests of the same class, e.g. the result tensors of the next frame. Buffers which would exceed the cache limit
+* are returned to the heap.
+*/
+class MemoryPool
+{
+  public:
+	explicit MemoryPool(size_t maxCachedBytes = 256 * 1024 * 1024);
+	~MemoryPool();
+
+	MemoryPool(const MemoryPool &) = delete;
+	MemoryPool &operator=(const MemoryPool &) = delete;
+
+	void *Allocate(size_t bytes);
+	void Deallocate(void *pointer, size_t bytes);
+
+	/**
+	* Returns all cached buffers to the heap.
+	*/
+	void Trim();
+
+	void SetMaxCachedBytes(size_t maxCachedBytes);
+	size_t GetMaxCachedBytes() const;
+
+	MemoryPoolStatistics GetStatistics() const;
+
+	/**
+	* Pool used by PoolAllocator, the default allocator of Tensor.
+	*/
+	static MemoryPool &GetDefault();
+
+  private:
+	// Free buffers are linked through their first bytes
+	struct FreeBuffer
+	{
+		FreeBuffer *next;
+	};
+
+	static constexpr size_t NrSizeClasses = 256;
+
+	std::array<FreeBuffer *, NrSizeClasses> _freeLists{};
+	size_t _maxCachedBytes;
+	MemoryPoolStatistics _statistics;
+	mutable std::mutex _mutex;
+
+	static size_t GetSizeClass(size_t bytes, size_t &classBytes);
+};
+
+/**
+* 64 byte aligned allocator which recycles its buffers through MemoryPool::GetDefault().
+*/
+template <typename T>
+class PoolAllocator
+{
+  public:
+	using value_type = T;
+	using is_always_equal = std::true_type;
+
+	PoolAllocator() noexcept {}
+
+	template <typename U>
+	PoolAllocator(const PoolAllocator<U> &) noexcept
+	{
+	}
+
+	T *allocate(size_t n)
+	{
+		return static_cast<T *>(MemoryPool::GetDefault().Allocate(n * sizeof(T)));
+	}
+
+	void deallocate(T *pointer, size_t n) noexcept
+	{
+		MemoryPool::GetDefault().Deallocate(pointer, n * sizeof(T));
+	}
+
+	template <typename U>
+	bool operator==(const PoolAllocator<U> &) const noexcept
+	{
+		return true;
+	}
+
+	template <typename U>
+	bool operator!=(const PoolAllocator<U> &) const noexcept
+	{
+		return false;
+	}
+};
+
+/**
+* 64 byte aligned allocator without caching, for buffers which live as long as the application.
+*/
+template <typename T>
+class AlignedAllocator
+{
+  public:
+	using value_type = T;
+	using is_always_equal = std::true_type;
+
+	AlignedAllocator() noexcept {}
+
+	template <typename U>
+	AlignedAllocator(const AlignedAllocator<U> &) noexcept
+	{
+	}
+
+	T *allocate(size_t n)
+	{
+		return static_cast<T *>(AllocateAligned(n * sizeof(T)));
+	}
+
+	void deallocate(T *pointer, size_t n) noexcept
+	{
+		DeallocateAligned(pointer, n * sizeof(T));
+	}
+
+	template <typename U>
+	bool operator==(const AlignedAllocator<U> &) const noexcept
+	{
+		return true;
+	}
+
+	template <typename U>
+	bool operator!=(const AlignedAllocator<U> &) const noexcept
+	{
+		return false;
+	}
+};
+} // namespace ThunderVision
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ThunderVision
+{
+/**
+* A measured scope. name points to a string literal, the times are nanoseconds since the start of the process.
+*/
+struct ProfileRecord
+{
+	const char *name;
+	size_t thread;
+	uint64_t begin;
+	uint64_t end;
+};
+
+/**
+* Number of records and their durations in milliseconds per stage.
+*/
+struct ProfileSummary
+{
+	std::string name;
+	size_t count;
+	double total;
+	double minimum;
+	double maximum;
+};
+
+/**
+* Collects the scopes measured by ScopedTimer. Every thread writes to its own ring buffer of RingSize records, so
+* recording does not contend with other threads and old records are overwritten. The library measures its stages
+* with THUNDER_PROFILE_SCOPE, which only expands to a timer if THUNDER_PROFILING is defined (the CMake option
+* THUNDER_PROFILING), otherwise it compiles to nothing.
+*/
+class Profiler
+{
+  public:
+	static constexpr size_t RingSize = 4096;
+
+	/**
+	* True if the library was compiled with THUNDER_PROFILING.
+	*/
+	static bool IsCompiled();
+
+	/**
+	* Recording can be switched off at runtime, it is enabled by default.
+	*/
+	static void SetEnabled(bool enabled);
+	static bool IsEnabled();
+
+	static uint64_t Now();
+	static void Record(const char *name, uint64_t begin, uint64_t end);
+
+	/**
+	* Records of all threads ordered by their begin.
+	*/
+	static std::vector<ProfileRecord> GetRecords();
+	static std::vector<ProfileSummary> Summarize();
+
+	/**
+	* Writes the records as complete events of the Chrome trace event format (chrome://tracing, Perfetto).
+	*/
+	static void WriteChromeTrace(std::ostream &stream);
+
+	static void Clear();
+};
+
+class ScopedTimer
+{
+  public:
+	explicit ScopedTimer(const char *name);
+	~ScopedTimer();
+
+	ScopedTimer(const ScopedTimer &) = delete;
+	ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+  private:
+	const char *_name;
+	uint64_t _begin;
+};
+} // namespace ThunderVision
+
+#ifdef THUNDER_PROFILING
+#define THUNDER_PROFILE_CONCAT_IMPL(a, b) a##b
+#define THUNDER_PROFILE_CONCAT(a, b) THUNDER_PROFILE_CONCAT_IMPL(a, b)
+#define THUNDER_PROFILE_SCOPE(...) ThunderVision::ScopedTimer THUNDER_PROFILE_CONCAT(profileScope, __LINE__)(__VA_ARGS__)
+#else
+#define THUNDER_PROFILE_SCOPE(...) ((void)0)
+#endif
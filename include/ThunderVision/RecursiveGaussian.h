@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Tensor.h"
+#include "TensorView.h"
+#include "ThreadPool.h"
+#include "SeparableFilterKernels.h"
+
+namespace ThunderVision
+{
+/**
+* Gaussian blur with the third order recursive filter of Young and van Vliet ("Recursive implementation of the
+* Gaussian filter", 1995). The filter runs forward and backward along every row and column, so the cost per pixel
+* does not depend on sigma. Every line is extended by 4 sigma reflected pixels, like the borders of the FIR filter.
+*
+* The rows are filtered in blocks which are stored interleaved, the columns in blocks of neighbouring columns, so
+* the SIMD registers hold independent lines. Supports float, uint8_t and uint16_t, sigma has to be at least 0.5.
+*/
+class RecursiveGaussian
+{
+  public:
+	RecursiveGaussian(const SimdLevel maxLevel = SimdLevel::AVX512);
+
+	/**
+	* Writes the blurred image to output, which is resized to (height, width, channels) if necessary.
+	*/
+	template <typename T>
+	void Apply(const TensorView<const T> &input, const double sigma, Tensor<T> &output, ThreadPool &pool = ThreadPool::GetDefault());
+
+  private:
+	SeparableFilterKernels _kernels;
+	Tensor<float> _intermediate;
+	Tensor<float> _lines;
+};
+} // namespace ThunderVision
@@ -1,24 +1,24 @@
 #pragma once
 
 #include <algorithm>
-#include "ext/libpopcnt.h"
 #include <cmath>
+#include <functional>
+#include <memory>
+#include <tuple>
 
 #include "Tensor.h"
+#include "TensorView.h"
 #include "MedianFilter.h"
 #include "Exceptions.h"
-
-#define TIME_MEASUREMENT
-
-#ifdef TIME_MEASUREMENT
-#include <chrono>
-#include <iostream>
-#endif // TIME_MEASUREMENT
-
-//#define OPEN_MP
-#ifdef OPEN_MP
-#include <omp.h>
-#endif
+#include "AggregationKernels.h"
+#include "WinnerTakesAllKernels.h"
+#include "HammingCostKernels.h"
+#include "ThreadPool.h"
+#include "CensusTransform.h"
+#include "ColorspaceConversion.h"
+#include "ImagePyramid.h"
+#include "DisparityRanges.h"
+#include "Profiler.h"
 
 namespace ThunderVision
 {
@@ -40,6 +40,29 @@ enum class CostFunction
 	CENSUS
 };
 
+/**
+* Storage of the aggregated costs. UInt16Saturated halves the memory and bandwidth of the aggregation, the sum over
+* all paths saturates at UINT16_MAX. Path costs of valid pixels are bounded by the CENSUS cost plus P2, so only
+* disparities with invalid matching costs saturate.
+*/
+enum class CostStorage
+{
+	UInt32,
+	UInt16Saturated
+};
+
+/**
+* Computation of the right disparities for the consistency check. Diagonal selects them from the aggregated costs of
+* the left image, right pixel x takes the minimum of the diagonal aggregatedCosts[y, x + d, d], so the costs are
+* computed and aggregated once. Recompute matches the right image against the left one with a second pass over
+* cost computation, aggregation and median. The compact and the hierarchical modes always recompute.
+*/
+enum class ConsistencyMode
+{
+	Diagonal,
+	Recompute
+};
+
 class SemiGlobalMatching
 {
   public:
@@ -48,58 +71,196 @@ class SemiGlobalMatching
 
 	void Prepare(size_t width, size_t height);
 
+	void SetCostStorage(CostStorage storage);
+	CostStorage GetCostStorage() const;
+
+	/**
+	* Highest instruction set used by the kernels of the matching costs, the aggregation and the winner takes all,
+	* limited by the CPU. Lower levels select the same results, e.g. for comparisons with the portable kernels.
+	*/
+	void SetMaxSimdLevel(SimdLevel level);
+	SimdLevel GetMaxSimdLevel() const;
+
+	/**
+	* Number of threads used for the aggregation. 0 selects the shared pool with one thread per hardware thread.
+	*/
+	void SetNrThreads(size_t nrThreads);
+	size_t GetNrThreads() const;
+
+	/**
+	* Row streaming computes the CENSUS vectors and matching costs row by row while aggregating. The paths coming from
+	* the top are aggregated in a downward pass, the paths coming from the bottom in an upward pass which also selects
+	* the disparities (Hirschmueller, Gehrig). Neither the CENSUS images nor the cost volume are stored, only row
+	* buffers of size width x maxDisparity and the aggregated costs.
+	*/
+	void SetRowStreaming(bool enabled);
+	bool GetRowStreaming() const;
+
+	/**
+	* Window and type of the CENSUS transform used for the matching costs, the default is a dense 5x5 window.
+	*/
+	void SetCensusTransform(CensusWindow window, CensusType type);
+	const CensusTransform &GetCensusTransform() const;
+
+	/**
+	* Coarse-to-fine search over image pyramids of nrLevels levels, 1 (the default) searches the full range at the full
+	* resolution. The coarsest level searches the full disparity range scaled to its resolution, every finer level only
+	* a band of disparityBand disparities per pixel around the upsampled disparities of the coarser level, so the cost
+	* volume, the aggregation and their memory shrink by maxDisparity / disparityBand. The band is rounded up to a
+	* multiple of 16. Supports uint8_t, uint16_t and float images, row streaming is not used in this mode.
+	*/
+	void SetHierarchical(size_t nrLevels, size_t disparityBand = 32);
+	size_t GetHierarchicalLevels() const;
+	size_t GetDisparityBand() const;
+
+	/**
+	* The compact cost volume stores a disparity range per pixel instead of maxDisparity disparities, pixels near the
+	* left border only keep the disparities whose matching pixel lies inside of the right image. The memory and the
+	* aggregation scale with the number of valid disparities. Row streaming is not used in this mode.
+	*/
+	void SetCompactCostVolume(bool enabled);
+	bool GetCompactCostVolume() const;
+
+	/**
+	* Restricts the disparities of left pixel (y, x) to [minima(y, x), maxima(y, x)) within [0, maxDisparity), e.g. to
+	* the range of a road plane prior, and enables the compact cost volume. Empty tensors select the full range. With
+	* the consistency check the ranges of the right image cover the ranges of all left pixels seen at a right pixel.
+	*/
+	void SetDisparityRanges(const Tensor<int32_t> &minima, const Tensor<int32_t> &maxima);
+
+	/**
+	* Subpixel refinement of the selected disparities, None (the default) keeps integer disparities.
+	*/
+	void SetSubpixelRefinement(SubpixelMode mode);
+	SubpixelMode GetSubpixelRefinement() const;
+
+	/**
+	* Invalidates disparities whose second best cost, ignoring the two neighbours, is below best * (1 + ratio), see
+	* WinnerTakesAllParameters. 0 (the default) disables the check. Invalid disparities are
+	* std::numeric_limits<float>::max(), as for the consistency check.
+	*/
+	void SetUniquenessRatio(float ratio);
+	float GetUniquenessRatio() const;
+
+	void SetConsistencyMode(ConsistencyMode mode);
+	ConsistencyMode GetConsistencyMode() const;
+
+	/**
+	* Conversion of 8 bit RGB input images {height, width, 3}, the default is the average of the channels. The dense
+	* and the compact cost volume compute the CENSUS vectors directly from the RGB rows, see
+	* CensusTransform::ComputeFromRGB, the hierarchical and the row streaming mode convert the images first.
+	*/
+	void SetGrayscaleWeights(GrayscaleWeights weights);
+	GrayscaleWeights GetGrayscaleWeights() const;
+
+	/**
+	* Disparities of CENSUS images computed with GetCensusTransform(), written to disparities which is only resized if
+	* its dimensions differ. All buffers are kept between calls, so a sequence of frames of the same size does not
+	* allocate. Supports the dense cost volume without row streaming, see StereoSession.
+	*/
+	void ComputeDisparitiesFromCensus(const Tensor<uint64_t> &censusLeft, const Tensor<uint64_t> &censusRight, Tensor<float> &disparities);
+
 	template <typename T>
 	Tensor<float> ComputeDisparities(const Tensor<T> &leftImage, const Tensor<T> &rightImage)
 	{
+		return ComputeDisparities(TensorView<const T>(leftImage), TensorView<const T>(rightImage));
+	}
+
+	/**
+	* Disparities in unsigned fixed point with DisparityFractionBits fractional bits (Q4), invalid disparities are
+	* UINT16_MAX. Useful with subpixel refinement, the values are rounded to 1/16 pixel.
+	*/
+	template <typename T>
+	Tensor<uint16_t> ComputeFixedPointDisparities(const Tensor<T> &leftImage, const Tensor<T> &rightImage)
+	{
+		return ComputeFixedPointDisparities(TensorView<const T>(leftImage), TensorView<const T>(rightImage));
+	}
+
+	template <typename T>
+	Tensor<uint16_t> ComputeFixedPointDisparities(const TensorView<const T> &leftImage, const TensorView<const T> &rightImage)
+	{
+		Tensor<uint16_t> fixedDisparities;
+		ToFixedPoint(ComputeDisparities(leftImage, rightImage), fixedDisparities);
+		return fixedDisparities;
+	}
+
+	/**
+	* Accepts views, e.g. crops or single channels of larger images or wrapped external buffers, without copying them.
+	* 8 bit images may also be RGB, see SetGrayscaleWeights.
+	*/
+	template <typename T>
+	Tensor<float> ComputeDisparities(const TensorView<const T> &leftImage, const TensorView<const T> &rightImage)
+	{
+		if constexpr (std::is_same<T, uint8_t>::value)
+		{
+			if (leftImage.GetRank() == 3 && rightImage.GetRank() == 3)
+				return ComputeColorDisparities(leftImage, rightImage);
+		}
 		if (leftImage.GetRank() != 2 || rightImage.GetRank() != 2)
 		{
-			throw new ThunderException("The input images have to be 2D grayscale images (rank 2 tensors).");
+			throw new ThunderException("The input images have to be 2D grayscale images (rank 2 tensors) or 8 bit RGB images.");
+		}
+		if (leftImage.GetDimension(0) != rightImage.GetDimension(0) || leftImage.GetDimension(1) != rightImage.GetDimension(1))
+		{
+			throw new ThunderException("The left and the right image have to be of the same size.");
 		}
 
-		if (!prepared || leftImage.GetDimension(0) != censusLeft.GetDimension(0) || leftImage.GetDimension(1) != censusRight.GetDimension(1))
+		if (!prepared || leftImage.GetDimension(0) != _height || leftImage.GetDimension(1) != _width)
 		{
 			Prepare(leftImage.GetDimension(1), leftImage.GetDimension(0));
 		}
 
-#ifdef TIME_MEASUREMENT
-		auto start_census = std::chrono::high_resolution_clock::now();
-#endif
-		ComputeCENSUSVectors<5, 5, uint64_t>(leftImage, censusLeft);
-		ComputeCENSUSVectors<5, 5, uint64_t>(rightImage, censusRight);
-
-#ifdef TIME_MEASUREMENT
-		auto end_census = std::chrono::high_resolution_clock::now();
-		std::cout << "Time for CENSUS computation (5x5): " << std::chrono::duration_cast<std::chrono::milliseconds>(end_census - start_census).count() << "ms (" << std::chrono::duration_cast<std::chrono::microseconds>(end_census - start_census).count() << " \xE6s)" << std::endl;
-#endif
+		if (_hierarchicalLevels > 1)
+		{
+			return ComputeHierarchicalDisparities(leftImage, rightImage);
+		}
 
-		if (!_consistencyCheck)
+		if (_compactCostVolume)
 		{
-			return ComputeMinimalMatchingCostImage<MatchingDirection::lr>(censusLeft, censusRight, _maxDisparity, true);
+			{
+				THUNDER_PROFILE_SCOPE("Census");
+				_censusTransform.Compute(leftImage, censusLeft, GetThreadPool(), _maxSimdLevel);
+				_censusTransform.Compute(rightImage, censusRight, GetThreadPool(), _maxSimdLevel);
+			}
+			return ComputeCompactDisparities();
 		}
 
-#ifndef OPEN_MP
-		auto matchingLeft = ComputeMinimalMatchingCostImage<MatchingDirection::lr>(censusLeft, censusRight, _maxDisparity, false);
-		auto matchingRight = ComputeMinimalMatchingCostImage<MatchingDirection::rl>(censusLeft, censusRight, _maxDisparity, false);
-		return LeftToRightConsistencyCheck(matchingLeft, matchingRight, 1.1f);
-#else
-		std::vector<Tensor<float>> matchings(2);
-#pragma omp parallel num_threads(2)
-#pragma omp for
-		for (int i = 0; i < 2; i++)
+		if (_rowStreaming)
 		{
-			if (i == 0)
+			if (!_consistencyCheck)
 			{
-				auto matchingLeft = ComputeMinimalMatchingCostImage<MatchingDirection::lr>(censusLeft, censusRight, false);
-				matchings[i] = matchingLeft;
+				return ComputeStreamingMatchingCostImage<MatchingDirection::lr>(leftImage, rightImage);
 			}
-			else
+			if (_consistencyMode == ConsistencyMode::Diagonal)
 			{
-				auto matchingRight = ComputeMinimalMatchingCostImage<MatchingDirection::rl>(censusLeft, censusRight, false);
-				matchings[i] = matchingRight;
+				auto matchingLeft = ComputeStreamingMatchingCostImage<MatchingDirection::lr>(leftImage, rightImage);
+				return LeftToRightConsistencyCheck(matchingLeft, _medianFilter.ApplyMedianFilter<3, 3>(rightDisparities, GetThreadPool()), 1.1f);
 			}
+
+			auto matchingLeft = ComputeStreamingMatchingCostImage<MatchingDirection::lr>(leftImage, rightImage);
+			auto matchingRight = ComputeStreamingMatchingCostImage<MatchingDirection::rl>(leftImage, rightImage);
+			return LeftToRightConsistencyCheck(matchingLeft, matchingRight, 1.1f);
+		}
+
+		{
+			THUNDER_PROFILE_SCOPE("Census");
+			_censusTransform.Compute(leftImage, censusLeft, GetThreadPool(), _maxSimdLevel);
+			_censusTransform.Compute(rightImage, censusRight, GetThreadPool(), _maxSimdLevel);
 		}
-		return LeftToRightConsistencyCheck(matchings[0], matchings[1], 1.1f);
-#endif
+
+		if (!_consistencyCheck)
+		{
+			return ComputeMinimalMatchingCostImage<MatchingDirection::lr>(censusLeft, censusRight, _maxDisparity);
+		}
+		if (_consistencyMode == ConsistencyMode::Diagonal)
+		{
+			auto matchingLeft = ComputeMinimalMatchingCostImage<MatchingDirection::lr>(censusLeft, censusRight, _maxDisparity);
+			return LeftToRightConsistencyCheck(matchingLeft, _medianFilter.ApplyMedianFilter<3, 3>(rightDisparities, GetThreadPool()), 1.1f);
+		}
+
+		auto matchingLeft = ComputeMinimalMatchingCostImage<MatchingDirection::lr>(censusLeft, censusRight, _maxDisparity);
+		auto matchingRight = ComputeMinimalMatchingCostImage<MatchingDirection::rl>(censusLeft, censusRight, _maxDisparity);
+		return LeftToRightConsistencyCheck(matchingLeft, matchingRight, 1.1f);
 	}
 
   private:
@@ -117,137 +278,243 @@ class SemiGlobalMatching
 	float btNormalizationValue = (UINT16_MAX - P2 - 10.0f) / UINT16_MAX;
 
 	AggregationDirections _aggregationDirections;
+	CostStorage _costStorage = CostStorage::UInt32;
+	SimdLevel _maxSimdLevel = SimdLevel::AVX512;
+	bool _rowStreaming = false;
+	size_t _hierarchicalLevels = 1;
+	size_t _disparityBand = 32;
+	bool _compactCostVolume = false;
+	WinnerTakesAllParameters _winnerTakesAllParameters;
+	ConsistencyMode _consistencyMode = ConsistencyMode::Diagonal;
+	GrayscaleWeights _grayscaleWeights = GrayscaleWeights::Average;
 
 	MedianFilter _medianFilter;
+	CensusTransform _censusTransform;
 
 	//Class memory buffers
 	bool prepared = false;
+	size_t _width = 0;
+	size_t _height = 0;
 	Tensor<uint64_t> censusLeft;
 	Tensor<uint64_t> censusRight;
+	// Grayscale images of RGB input for the hierarchical and the row streaming mode
+	Tensor<uint8_t> grayscaleLeft;
+	Tensor<uint8_t> grayscaleRight;
 	Tensor<unsigned int> aggregatedCosts;
-	Tensor<unsigned int> tempBuffer;
+	Tensor<uint16_t> aggregatedCosts16;
+	// Per thread path costs of the previous and the current pixel of a path (or of a row of paths) {2, width, maxDisparity}.
+	// Path costs are bounded by errorPixelValue + P2 = UINT16_MAX, see AggregationStepKernel
+	std::vector<Tensor<uint16_t>> pathBuffers;
+	// Per thread minima of the path costs stored in pathBuffers {2, width}
+	std::vector<Tensor<uint16_t>> pathMinimaBuffers;
+	std::shared_ptr<ThreadPool> _threadPool;
+	// Row streaming buffers: CENSUS rows {2, width}, matching costs of a row {width, maxDisparity},
+	// path costs of the three directions with a predecessor in the neighbouring row {3, 2, width, maxDisparity}
+	// and their minima {3, 2, width}
+	Tensor<uint64_t> censusRows;
+	Tensor<uint16_t> costRow;
+	Tensor<uint16_t> streamingPathBuffers;
+	Tensor<uint16_t> streamingPathMinima;
+	AggregationKernels<unsigned int> _aggregationKernels;
+	AggregationKernels<uint16_t> _aggregationKernels16;
+	WinnerTakesAllKernels<unsigned int> _winnerTakesAllKernels;
+	WinnerTakesAllKernels<uint16_t> _winnerTakesAllKernels16;
+	HammingCostKernels _hammingKernels;
 	Tensor<uint16_t> costVolume;
 	Tensor<float> minimalDisparities;
+	// Right disparities selected from the aggregated costs of the left image {height, width} and the per thread
+	// buffers of the selection {threads, 2 * (width + maxDisparity)}, see RightWinnerTakesAllKernel
+	Tensor<float> rightDisparities;
+	// Median filtered disparities of both images before the consistency check of ComputeDisparitiesFromCensus
+	Tensor<float> filteredLeft;
+	Tensor<float> filteredRight;
+	Tensor<unsigned int> rightSelectionBuffers;
+	Tensor<uint16_t> rightSelectionBuffers16;
+	// Hierarchical mode: pyramids of the supported image types
+	std::tuple<ImagePyramid<uint8_t>, ImagePyramid<uint16_t>, ImagePyramid<float>> leftPyramids;
+	std::tuple<ImagePyramid<uint8_t>, ImagePyramid<uint16_t>, ImagePyramid<float>> rightPyramids;
+	// Compact cost volume: the ranges requested by SetDisparityRanges {height, width}, the layouts of the left and the
+	// right volume and the layout aggregated at the moment (nullptr for the dense volume)
+	Tensor<int32_t> _rangeMinima;
+	Tensor<int32_t> _rangeMaxima;
+	DisparityRanges leftRanges;
+	DisparityRanges rightRanges;
+	const DisparityRanges *_ranges = nullptr;
 
 	/* Methods implemented in .cpp*/
-	void AggregateCosts(const Tensor<uint16_t> &costVolume, const bool internalParallel, Tensor<unsigned int> &aggregatedCosts, Tensor<unsigned int> &tempBuffer);
+	ThreadPool &GetThreadPool();
+
+	void AggregateCosts(const Tensor<uint16_t> &costVolume, Tensor<unsigned int> &aggregatedCosts);
+	void AggregateCosts(const Tensor<uint16_t> &costVolume, Tensor<uint16_t> &aggregatedCosts);
+
+	template <typename TAggregated>
+	void AggregateCosts(const Tensor<uint16_t> &costVolume, const AggregationKernels<TAggregated> &kernels, Tensor<TAggregated> &aggregatedCosts);
 
-	inline void AggregatePositionCost(const Tensor<uint16_t> &costVolume, Tensor<unsigned int> &aggregatedCosts, Tensor<unsigned int> &temp, const int64_t maxDisp, const int64_t pos, const int64_t direction);
-	inline void CopyCostsToAggregation(const Tensor<uint16_t> &costVolume, Tensor<unsigned int> &aggregatedCosts, Tensor<unsigned int> &temp, const int64_t maxDisp, const int64_t pos);
 	/**
 	* X>0 means iteration is applied from left to right, Y > 0 means iteration is applied from top to bottom. X=0 or Y=0 means path is not applied in this direction.
+	* The independent paths of a direction (rows, columns or diagonals) are distributed over the threads.
 	*/
-	template <int X, int Y>
-	void AggregateCosts(const Tensor<uint16_t> &costVolume, Tensor<unsigned int> &aggregatedCosts, Tensor<unsigned int> &tempBuffer);
+	template <int X, int Y, typename TAggregated>
+	void AggregateCosts(const Tensor<uint16_t> &costVolume, const AggregationKernels<TAggregated> &kernels, Tensor<TAggregated> &aggregatedCosts);
 
-	void ComputeMinimalDisparity(const Tensor<unsigned int> &costVolume, Tensor<float> &minimalDisparities);
+	void AggregateStreaming(const std::function<void(size_t, uint16_t *)> &computeCostRow, Tensor<unsigned int> &aggregatedCosts, Tensor<float> &minimalDisparities);
+	void AggregateStreaming(const std::function<void(size_t, uint16_t *)> &computeCostRow, Tensor<uint16_t> &aggregatedCosts, Tensor<float> &minimalDisparities);
 
-	Tensor<float> LeftToRightConsistencyCheck(const Tensor<float> &leftDisparityImage, const Tensor<float> &rightDisparityImage, const float epsilon);
-	/******************************/
+	template <typename TAggregated>
+	void AggregateStreaming(const std::function<void(size_t, uint16_t *)> &computeCostRow, const AggregationKernels<TAggregated> &kernels, Tensor<TAggregated> &aggregatedCosts, Tensor<float> &minimalDisparities);
 
-	template <MatchingDirection direction>
-	Tensor<float> ComputeMinimalMatchingCostImage(const Tensor<uint64_t> &censusLeft, const Tensor<uint64_t> &censusRight, const size_t maxDisp, bool internalParallel)
-	{
-#ifdef TIME_MEASUREMENT
-		auto start_cost_volume = std::chrono::high_resolution_clock::now();
-#endif
-
-		ComputeMatchingCostsCENSUS<direction>(censusLeft, censusRight, maxDisp, costVolume);
+	/**
+	* Aggregates one row of a direction in the row streaming mode. For Y != 0 the predecessors are read from the path costs of
+	* the previous row of the pass, for Y == 0 the row is walked in X direction.
+	*/
+	template <int X, int Y, typename TAggregated>
+	void AggregateStreamingRow(const uint16_t *costs, const AggregationKernels<TAggregated> &kernels, const bool firstRow, const size_t parity, TAggregated *aggregated);
 
-#ifdef TIME_MEASUREMENT
-		auto end_cost_volume = std::chrono::high_resolution_clock::now();
-		std::cout << "Time for cost volume computation: " << std::chrono::duration_cast<std::chrono::milliseconds>(end_cost_volume - start_cost_volume).count() << "ms (" << std::chrono::duration_cast<std::chrono::microseconds>(end_cost_volume - start_cost_volume).count() << " \xE6s)" << std::endl;
-		auto start_aggregation = std::chrono::high_resolution_clock::now();
-#endif
+	template <typename TAggregated>
+	void ComputeMinimalDisparityRow(const TAggregated *aggregated, const size_t width, const size_t maxDisp, float *minimalDisparities);
 
-		AggregateCosts(costVolume, internalParallel, aggregatedCosts, tempBuffer);
+	void ComputeMinimalDisparity(const Tensor<unsigned int> &costVolume, Tensor<float> &minimalDisparities);
+	void ComputeMinimalDisparity(const Tensor<uint16_t> &costVolume, Tensor<float> &minimalDisparities);
 
-#ifdef TIME_MEASUREMENT
-		auto end_aggregation = std::chrono::high_resolution_clock::now();
-		std::cout << "Time for cost aggregation: " << std::chrono::duration_cast<std::chrono::milliseconds>(end_aggregation - start_aggregation).count() << "ms (" << std::chrono::duration_cast<std::chrono::microseconds>(end_aggregation - start_aggregation).count() << " \xE6s)" << std::endl;
-		auto start_minimal_comp = std::chrono::high_resolution_clock::now();
-#endif
+	template <typename TAggregated>
+	void ComputeMinimalDisparityImpl(const Tensor<TAggregated> &costVolume, Tensor<float> &minimalDisparities);
 
-		ComputeMinimalDisparity(aggregatedCosts, minimalDisparities);
+	/**
+	* Winner takes all over the disparity ranges of a compact volume.
+	*/
+	template <typename TAggregated>
+	void ComputeMinimalDisparity(const Tensor<TAggregated> &aggregatedCosts, const DisparityRanges &ranges, Tensor<float> &minimalDisparities);
 
-#ifdef TIME_MEASUREMENT
-		auto end_minimal_comp = std::chrono::high_resolution_clock::now();
-		std::cout << "Time for cost minimization: " << std::chrono::duration_cast<std::chrono::milliseconds>(end_minimal_comp - start_minimal_comp).count() << "ms (" << std::chrono::duration_cast<std::chrono::microseconds>(end_minimal_comp - start_minimal_comp).count() << " \xE6s)" << std::endl;
-		auto start_median = std::chrono::high_resolution_clock::now();
-#endif
+	/**
+	* Selects rightDisparities from the diagonals of the aggregated costs of the left image, see ConsistencyMode.
+	*/
+	template <typename TAggregated>
+	void ComputeRightDisparities(const Tensor<TAggregated> &aggregatedCosts);
 
-		auto l_minimalDisparities = _medianFilter.ApplyMedianFilter<3, 3>(minimalDisparities);
+	void ToFixedPoint(const Tensor<float> &disparities, Tensor<uint16_t> &fixedDisparities) const;
 
-#ifdef TIME_MEASUREMENT
-		auto end_median = std::chrono::high_resolution_clock::now();
-		std::cout << "Time for median computation: " << std::chrono::duration_cast<std::chrono::milliseconds>(end_median - start_median).count() << "ms (" << std::chrono::duration_cast<std::chrono::microseconds>(end_median - start_median).count() << " \xE6s)" << std::endl;
-#endif
-		return l_minimalDisparities;
-	}
+	Tensor<float> LeftToRightConsistencyCheck(const Tensor<float> &leftDisparityImage, const Tensor<float> &rightDisparityImage, const float epsilon);
+	void LeftToRightConsistencyCheck(const Tensor<float> &leftDisparityImage, const Tensor<float> &rightDisparityImage, const float epsilon, Tensor<float> &consistencyCheckedImage);
 
-	template <uint32_t filtersize_x, uint32_t filtersize_y, typename TVector, typename T>
-	void ComputeCENSUSVectors(const Tensor<T> &image, Tensor<TVector> &censusImage)
-	{
-		static_assert(filtersize_x % 2 == 1, "The CENSUS mask width has to be uneven.");
-		static_assert(filtersize_y % 2 == 1, "The CENSUS mask height has to be uneven.");
+	/**
+	* Disparities of the full resolution CENSUS images within the ranges requested by SetDisparityRanges.
+	*/
+	Tensor<float> ComputeCompactDisparities();
+	Tensor<float> ComputeColorDisparities(const TensorView<const uint8_t> &leftImage, const TensorView<const uint8_t> &rightImage);
 
-		const size_t width = image.GetDimension(1);
+	/**
+	* Computes the disparities of the pyramid level whose CENSUS images are in censusLeft and censusRight. Without
+	* coarser disparities the full range is searched, otherwise the bands around the upsampled coarser disparities.
+	*/
+	Tensor<float> ComputeBandedDisparities(const Tensor<float> &coarseDisparities, const bool finestLevel);
 
-		constexpr size_t size_x_h = (filtersize_x - 1) / 2;
-		constexpr size_t size_y_h = (filtersize_y - 1) / 2;
+	/**
+	* Disparities of the left image within leftRanges, with the consistency check against the right image.
+	*/
+	Tensor<float> ComputeRangeDisparities(const bool consistencyCheck);
 
-		const size_t endIndex_y = image.GetDimension(0) - size_y_h;
-		const size_t endIndex_x = width - size_x_h;
+	/**
+	* Matching costs, aggregation and winner takes all of one direction for a compact cost volume.
+	*/
+	template <MatchingDirection direction>
+	Tensor<float> ComputeCompactMatchingCostImage(const DisparityRanges &ranges);
+	/******************************/
 
-		censusImage.Fill(invalid_census_value);
-		for (size_t y = size_y_h; y < endIndex_y; y++)
+	template <typename T>
+	Tensor<float> ComputeHierarchicalDisparities(const TensorView<const T> &leftImage, const TensorView<const T> &rightImage)
+	{
+		if constexpr (!ImageResizing::IsSupported<T>())
 		{
-			for (size_t x = size_x_h; x < endIndex_x; x++)
+			throw new ThunderException("The hierarchical mode supports uint8_t, uint16_t and float images.");
+		}
+		else
+		{
+			ImagePyramid<T> &leftPyramid = std::get<ImagePyramid<T>>(leftPyramids);
+			ImagePyramid<T> &rightPyramid = std::get<ImagePyramid<T>>(rightPyramids);
+			{
+				THUNDER_PROFILE_SCOPE("Pyramid");
+				leftPyramid.Build(leftImage, _hierarchicalLevels, GetThreadPool());
+				rightPyramid.Build(rightImage, _hierarchicalLevels, GetThreadPool());
+			}
+
+			Tensor<float> disparities;
+			for (size_t level = _hierarchicalLevels; level-- > 0;)
 			{
-				size_t pos = y * width + x;
-				censusImage[pos] = ComputeCENSUSVector<filtersize_x, filtersize_y, TVector>(image, pos);
+				{
+					THUNDER_PROFILE_SCOPE("Census");
+					_censusTransform.Compute(leftPyramid.GetLevel(level), censusLeft, GetThreadPool(), _maxSimdLevel);
+					_censusTransform.Compute(rightPyramid.GetLevel(level), censusRight, GetThreadPool(), _maxSimdLevel);
+				}
+				disparities = ComputeBandedDisparities(disparities, level == 0);
 			}
+			return disparities;
 		}
 	}
 
-	template <uint32_t filtersize_x, uint32_t filtersize_y, typename TVector, typename T>
-	TVector ComputeCENSUSVector(const Tensor<T> &image, size_t pos)
+	template <MatchingDirection direction>
+	Tensor<float> ComputeMinimalMatchingCostImage(const Tensor<uint64_t> &censusLeft, const Tensor<uint64_t> &censusRight, const size_t maxDisp)
 	{
-		static_assert(filtersize_x % 2 == 1, "The CENSUS mask width has to be uneven.");
-		static_assert(filtersize_y % 2 == 1, "The CENSUS mask width has to be uneven.");
-
-		const T basePixel = image[pos];
-		const size_t width = image.GetDimension(1);
+		Tensor<float> disparities;
+		ComputeMinimalMatchingCostImage<direction>(censusLeft, censusRight, maxDisp, disparities);
+		return disparities;
+	}
 
-		constexpr size_t size_x_h = (filtersize_x - 1) / 2;
-		constexpr size_t size_y_h = (filtersize_y - 1) / 2;
+	template <MatchingDirection direction>
+	void ComputeMinimalMatchingCostImage(const Tensor<uint64_t> &censusLeft, const Tensor<uint64_t> &censusRight, const size_t maxDisp, Tensor<float> &disparities)
+	{
+		{
+			THUNDER_PROFILE_SCOPE("CostVolume");
+			ComputeMatchingCostsCENSUS<direction>(censusLeft, censusRight, maxDisp, costVolume);
+		}
 
-		//Compute base position as beeing half y over pos and half x to the left
-		size_t basePos = pos - (size_y_h * width) - size_x_h;
+		if (_costStorage == CostStorage::UInt16Saturated)
+			AggregateCosts(costVolume, aggregatedCosts16);
+		else
+			AggregateCosts(costVolume, aggregatedCosts);
 
-		size_t x_t;
-		TVector vector = 0;
-		TVector posEncoding = 1;
-		for (size_t y_t = 0; y_t < filtersize_y; y_t++)
+		if (_costStorage == CostStorage::UInt16Saturated)
+			ComputeMinimalDisparity(aggregatedCosts16, minimalDisparities);
+		else
+			ComputeMinimalDisparity(aggregatedCosts, minimalDisparities);
+		if (direction == MatchingDirection::lr && _consistencyCheck && _consistencyMode == ConsistencyMode::Diagonal)
 		{
-			for (x_t = 0; x_t < filtersize_x; x_t++)
-			{
-				//Write a one to the bit vector if current pixel is large than the base pixel
-				if (basePixel < image[basePos + x_t])
-				{
-					vector |= posEncoding;
-				}
-				//Shift the bit vector to new position
-				posEncoding <<= 1;
-			}
-			basePos += width;
+			if (_costStorage == CostStorage::UInt16Saturated)
+				ComputeRightDisparities(aggregatedCosts16);
+			else
+				ComputeRightDisparities(aggregatedCosts);
 		}
-		return vector;
+
+		THUNDER_PROFILE_SCOPE("Median");
+		_medianFilter.ApplyMedianFilter<3, 3>(TensorView<const float>(minimalDisparities), disparities, GetThreadPool());
 	}
 
-	inline uint16_t computeHammingDistance(const uint64_t x1, const uint64_t x2)
+	template <MatchingDirection direction, typename T>
+	Tensor<float> ComputeStreamingMatchingCostImage(const TensorView<const T> &leftImage, const TensorView<const T> &rightImage)
 	{
-		return static_cast<uint16_t>(popcnt64(x1 ^ x2));
+		uint64_t *censusRowLeft = censusRows.Data();
+		uint64_t *censusRowRight = censusRowLeft + _width;
+		const CensusTransform::RowContext leftContext = _censusTransform.PrepareRows(leftImage.GetStride(0), _maxSimdLevel);
+		const CensusTransform::RowContext rightContext = _censusTransform.PrepareRows(rightImage.GetStride(0), _maxSimdLevel);
+		auto computeCostRow = [&](size_t y, uint16_t *costs) {
+			_censusTransform.ComputeRow(leftImage, y, leftContext, censusRowLeft);
+			_censusTransform.ComputeRow(rightImage, y, rightContext, censusRowRight);
+			ComputeMatchingCostsCENSUSRow<direction>(censusRowLeft, censusRowRight, _width, _maxDisparity, costs);
+		};
+
+		if (_costStorage == CostStorage::UInt16Saturated)
+			AggregateStreaming(computeCostRow, aggregatedCosts16, minimalDisparities);
+		else
+			AggregateStreaming(computeCostRow, aggregatedCosts, minimalDisparities);
+		if (direction == MatchingDirection::lr && _consistencyCheck && _consistencyMode == ConsistencyMode::Diagonal)
+		{
+			if (_costStorage == CostStorage::UInt16Saturated)
+				ComputeRightDisparities(aggregatedCosts16);
+			else
+				ComputeRightDisparities(aggregatedCosts);
+		}
+
+		THUNDER_PROFILE_SCOPE("Median");
+		return _medianFilter.ApplyMedianFilter<3, 3>(minimalDisparities, GetThreadPool());
 	}
 
 	template <MatchingDirection direction>
@@ -256,34 +523,36 @@ class SemiGlobalMatching
 		const size_t width = censusLeft.GetDimension(1);
 		const size_t height = censusLeft.GetDimension(0);
 
-		uint64_t baseVector;
-		size_t x, d = 0;
-		size_t pos = 0;
-		size_t costPos = 0;
+		GetThreadPool().ParallelFor(0, static_cast<int64_t>(height), [&](int64_t begin, int64_t end, size_t) {
+			for (int64_t y = begin; y < end; y++)
+			{
+				ComputeMatchingCostsCENSUSRow<direction>(censusLeft.Data() + y * width, censusRight.Data() + y * width, width, maxDisp, costVolume.Data() + y * width * maxDisp);
+			}
+		});
+	}
 
-		costVolume.Fill(errorPixelValue);
-		for (size_t y = 0; y < height; y++)
+	template <MatchingDirection direction>
+	void ComputeMatchingCostsCENSUSRow(const uint64_t *censusLeft, const uint64_t *censusRight, const size_t width, const size_t maxDisp, uint16_t *costs)
+	{
+		for (size_t x = 0; x < width; x++, costs += maxDisp)
 		{
-			for (x = 0; x < width; x++, pos++, costPos += maxDisp)
+			// Disparities whose matching pixel lies outside of the image keep the error value
+			size_t count = std::min(maxDisp, direction == MatchingDirection::lr ? x + 1 : width - x);
+			if constexpr (direction == MatchingDirection::lr)
 			{
-				if ((direction == MatchingDirection::lr) ? censusLeft[pos] == invalid_census_value : censusRight[pos] == invalid_census_value)
-				{
-					continue;
-				}
-
-				baseVector = (direction == MatchingDirection::lr) ? censusLeft[pos] : censusRight[pos];
-				for (d = 0; d < maxDisp && (direction == MatchingDirection::lr ? x >= d : x + d < width); d++)
-				{
-					if (direction == MatchingDirection::lr)
-					{
-						costVolume[costPos + d] = computeHammingDistance(baseVector, censusRight[pos - d]);
-					}
-					else
-					{
-						costVolume[costPos + d] = computeHammingDistance(baseVector, censusLeft[pos + d]);
-					}
-				}
+				if (censusLeft[x] == invalid_census_value)
+					count = 0;
+				else
+					_hammingKernels.backward(censusLeft[x], censusRight + x, count, costs);
+			}
+			else
+			{
+				if (censusRight[x] == invalid_census_value)
+					count = 0;
+				else
+					_hammingKernels.forward(censusRight[x], censusLeft + x, count, costs);
 			}
+			std::fill(costs + count, costs + maxDisp, errorPixelValue);
 		}
 	}
 };
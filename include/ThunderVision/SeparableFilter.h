@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "Tensor.h"
+#include "TensorView.h"
+#include "ThreadPool.h"
+#include "SeparableFilterKernels.h"
+
+namespace ThunderVision
+{
+/**
+* Extension of the image at its borders: Reflect maps pixel -1 to 0 and pixel width to width - 1, Replicate
+* repeats the outermost pixel and Constant uses a fixed value.
+*/
+enum class BorderMode
+{
+	Reflect,
+	Replicate,
+	Constant
+};
+
+/**
+* Convolves images of shape (height, width) or (height, width, channels) with a horizontal and a vertical 1D kernel
+* or a 2D kernel of uneven sizes. The kernels are correlated with the image, out(x) = sum_k w[k] * in(x + k - radius).
+*
+* Every thread filters a strip of rows horizontally into a ring buffer of kernelY.size rows and computes the output
+* rows from it, so both passes work on memory which stays in the cache. The rows are padded with the border pixels
+* before the row kernels run, hence the SIMD kernels work on whole rows without border branches. 2D kernels run one
+* horizontal pass per kernel row on a ring of padded rows and sum the results. The buffers are members and reused by
+* the next call with the same image size.
+*
+* float and uint16_t images are filtered in float. uint8_t images use
+* - the 16 bit fixed point kernels for a uint8_t output if the weights are smaller than 1 and the result can not
+*   overflow (e.g. blurring),
+* - exact 16 bit integer arithmetic for integer weights with 255 * sum |w| < 2^15 (Sobel, Scharr, box sums),
+* - float otherwise.
+* Integer results are rounded to the nearest value and saturated to the output type.
+*/
+class SeparableFilter
+{
+  public:
+	SeparableFilter(const SimdLevel maxLevel = SimdLevel::AVX512);
+
+	template <typename T>
+	static constexpr bool IsSupported()
+	{
+		return std::is_same<T, float>::value || std::is_same<T, uint8_t>::value || std::is_same<T, uint16_t>::value;
+	}
+
+	/**
+	* Output types besides the supported input types, e.g. int16_t for derivatives of uint8_t images.
+	*/
+	template <typename T>
+	static constexpr bool IsSupportedOutput()
+	{
+		return IsSupported<T>() || std::is_same<T, int16_t>::value;
+	}
+
+	/**
+	* Writes the filtered image to output, which is resized to (height, width, channels) if necessary. borderValue is
+	* the value of the pixels outside the image for BorderMode::Constant, converted to the input type.
+	*/
+	template <typename TIn, typename TOut>
+	void Apply(const TensorView<const TIn> &input, const Tensor<double> &kernelX, const Tensor<double> &kernelY, Tensor<TOut> &output,
+			   const BorderMode border = BorderMode::Reflect, const double borderValue = 0.0, ThreadPool &pool = ThreadPool::GetDefault());
+
+	/**
+	* Convolves with a 2D kernel of shape (kernelHeight, kernelWidth), output like Apply.
+	*/
+	template <typename TIn, typename TOut>
+	void Apply2D(const TensorView<const TIn> &input, const Tensor<double> &kernel, Tensor<TOut> &output, const BorderMode border = BorderMode::Reflect,
+				 const double borderValue = 0.0, ThreadPool &pool = ThreadPool::GetDefault());
+
+	SimdLevel GetSimdLevel() const
+	{
+		return _kernels.level;
+	}
+
+  private:
+	SeparableFilterKernels _kernels;
+	Tensor<float> _floatBuffer;
+	Tensor<int16_t> _fixedBuffer;
+};
+} // namespace ThunderVision
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "CpuFeatures.h"
+
+namespace ThunderVision
+{
+/**
+* The kernels are specialized at compile time for 3, 5 and 7 taps (Sobel, Scharr, box and small Gaussian kernels).
+*
+* Filters a row along x: out[j] = sum_k weights[k] * row[j + k * step] for j < length. The row has to be padded by
+* (taps - 1) * step elements, step is the distance of neighbouring pixels (the number of interleaved channels).
+*/
+using HorizontalFilterKernelFloat = void (*)(const float *row, const size_t length, const float *weights, const size_t taps, const size_t step, float *out);
+
+/**
+* Filters along y: out[j] = sum_k weights[k] * rows[k][j] for j < length.
+*/
+using VerticalFilterKernelFloat = void (*)(const float *const *rows, const float *weights, const size_t taps, const size_t length, float *out);
+
+/**
+* 16 bit fixed point variants for 8 bit images. The pixels are stored with 6 fractional bits, the weights with 15
+* fractional bits and every product is rounded to 6 fractional bits (PMULHRSW). The vertical kernel rounds the result
+* to the nearest integer and saturates it to [0, 255].
+*/
+using HorizontalFilterKernelFixed = void (*)(const int16_t *row, const size_t length, const int16_t *weights, const size_t taps, const size_t step, int16_t *out);
+using VerticalFilterKernelFixed = void (*)(const int16_t *const *rows, const int16_t *weights, const size_t taps, const size_t length, uint8_t *out);
+
+/**
+* Exact 16 bit integer variants for integer weights, e.g. Sobel or unnormalized box kernels. The caller guarantees
+* that no sum overflows int16_t.
+*/
+using HorizontalFilterKernelInt = void (*)(const int16_t *row, const size_t length, const int16_t *weights, const size_t taps, const size_t step, int16_t *out);
+using VerticalFilterKernelInt = void (*)(const int16_t *const *rows, const int16_t *weights, const size_t taps, const size_t length, int16_t *out);
+
+/**
+* Runs a third order recursive filter forward and backward along lines stored interleaved: element n of line l is
+* lines[n * lanes + l], so neighbouring lines fill the SIMD registers. coefficients = {B, a1, a2, a3} with
+* w[n] = B x[n] + a1 w[n - 1] + a2 w[n - 2] + a3 w[n - 3], the lines are continued with their first and last values.
+*/
+using RecursiveFilterKernel = void (*)(float *lines, const size_t length, const size_t lanes, const float *coefficients);
+
+/**
+* Resamples a row with per output value taps: out[i] = sum_k weights[k * length + i] * row[indices[k * length + i]].
+* The taps are stored planar, so the SIMD kernels load the weights of neighbouring outputs and gather the pixels.
+*/
+using ResampleKernelFloat = void (*)(const float *row, const int32_t *indices, const float *weights, const size_t taps, const size_t length, float *out);
+
+/**
+* Rounds filter results to the nearest integer and saturates them, identical to FilterUtil::RoundAndSaturate.
+*/
+using RoundKernelUint8 = void (*)(const float *values, const size_t length, uint8_t *out);
+using RoundKernelUint16 = void (*)(const float *values, const size_t length, uint16_t *out);
+
+constexpr int FilterFixedPixelBits = 6;
+constexpr int FilterFixedWeightBits = 15;
+
+struct SeparableFilterKernels
+{
+	HorizontalFilterKernelFloat horizontalFloat;
+	VerticalFilterKernelFloat verticalFloat;
+	HorizontalFilterKernelFixed horizontalFixed;
+	VerticalFilterKernelFixed verticalFixed;
+	HorizontalFilterKernelInt horizontalInt;
+	VerticalFilterKernelInt verticalInt;
+	RecursiveFilterKernel recursive;
+	ResampleKernelFloat resample;
+	RoundKernelUint8 roundUint8;
+	RoundKernelUint16 roundUint16;
+	SimdLevel level;
+};
+
+/**
+* Selects the fastest kernels available on the executing CPU. The fixed point results do not depend on the selection,
+* the float results may differ in the last bit since the AVX-512 kernels are compiled with fused multiply adds.
+*/
+SeparableFilterKernels SelectSeparableFilterKernels(const SimdLevel maxLevel = SimdLevel::AVX512);
+} // namespace ThunderVision
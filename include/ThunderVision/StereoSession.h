@@ -0,0 +1,156 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+#include "Tensor.h"
+#include "TensorView.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+#include "SemiGlobalMatching.h"
+
+namespace ThunderVision
+{
+/**
+* Stereo matching of a sequence of frames in a two stage pipeline. A CENSUS thread transforms the images of a frame
+* while a matching thread computes the costs, the aggregation and the disparities of the previous frame, so the
+* throughput is bounded by the slower stage. Each stage keeps its buffers between frames and the disparities are
+* written to tensors of the caller.
+*
+* Two frames are in flight at most, Submit blocks until a slot is free. The images of a frame and its output tensor
+* have to stay valid and unchanged until Poll or Wait reports the frame as completed. The matcher is configured with
+* GetMatcher before the first Submit, its thread pool is used by the matching stage and a separate pool of
+* nrCensusThreads by the CENSUS stage. 8 bit RGB frames are transformed without a grayscale copy, see
+* SemiGlobalMatching::SetGrayscaleWeights. Hierarchical, compact and row streaming matchers run the whole frame in
+* the matching stage.
+*/
+class StereoSession
+{
+  public:
+	StereoSession(size_t maxDisparity, bool consistencyCheck, AggregationDirections nrAggregations, size_t nrCensusThreads = 1);
+	~StereoSession();
+
+	StereoSession(const StereoSession &) = delete;
+	StereoSession &operator=(const StereoSession &) = delete;
+
+	SemiGlobalMatching &GetMatcher();
+
+	/**
+	* Queues a frame and returns its number, frames are numbered consecutively from 0. disparities is only resized if
+	* its dimensions differ from the previous frame written to it.
+	*/
+	template <typename T>
+	uint64_t Submit(const TensorView<const T> &leftImage, const TensorView<const T> &rightImage, Tensor<float> &disparities)
+	{
+		const bool color = std::is_same<T, uint8_t>::value && leftImage.GetRank() == 3;
+		if (leftImage.GetRank() != rightImage.GetRank() || (leftImage.GetRank() != 2 && !color))
+			throw new ThunderException("The input images have to be 2D grayscale images (rank 2 tensors) or 8 bit RGB images.");
+		if (leftImage.GetDimensions() != rightImage.GetDimensions())
+			throw new ThunderException("The left and the right image have to be of the same size.");
+
+		Frame frame;
+		frame.disparities = &disparities;
+		if (_matcher.GetHierarchicalLevels() > 1 || _matcher.GetCompactCostVolume() || _matcher.GetRowStreaming())
+		{
+			frame.census = [](Slot &) {};
+			frame.match = [this, leftImage, rightImage](Slot &slot) { *slot.frame.disparities = _matcher.ComputeDisparities(leftImage, rightImage); };
+		}
+		else
+		{
+			frame.census = [this, leftImage, rightImage, color](Slot &slot) {
+				THUNDER_PROFILE_SCOPE("Census");
+				if constexpr (std::is_same<T, uint8_t>::value)
+				{
+					if (color)
+					{
+						const CensusTransform &census = _matcher.GetCensusTransform();
+						census.ComputeFromRGB(leftImage, slot.censusLeft, _matcher.GetGrayscaleWeights(), _censusPool, _matcher.GetMaxSimdLevel());
+						census.ComputeFromRGB(rightImage, slot.censusRight, _matcher.GetGrayscaleWeights(), _censusPool, _matcher.GetMaxSimdLevel());
+						return;
+					}
+				}
+				_matcher.GetCensusTransform().Compute(leftImage, slot.censusLeft, _censusPool, _matcher.GetMaxSimdLevel());
+				_matcher.GetCensusTransform().Compute(rightImage, slot.censusRight, _censusPool, _matcher.GetMaxSimdLevel());
+			};
+			frame.match = [this](Slot &slot) { _matcher.ComputeDisparitiesFromCensus(slot.censusLeft, slot.censusRight, *slot.frame.disparities); };
+		}
+		return Enqueue(std::move(frame));
+	}
+
+	template <typename T>
+	uint64_t Submit(const Tensor<T> &leftImage, const Tensor<T> &rightImage, Tensor<float> &disparities)
+	{
+		return Submit(TensorView<const T>(leftImage), TensorView<const T>(rightImage), disparities);
+	}
+
+	/**
+	* True if the frame is completed. Exceptions of the frame are rethrown once, by Poll or Wait.
+	*/
+	bool Poll(uint64_t frame);
+
+	/**
+	* Blocks until the frame is completed.
+	*/
+	void Wait(uint64_t frame);
+
+	/**
+	* Blocks until all submitted frames are completed.
+	*/
+	void Flush();
+
+  private:
+	enum class SlotState
+	{
+		Free,
+		Submitted,
+		Transformed
+	};
+
+	struct Slot;
+
+	struct Frame
+	{
+		Tensor<float> *disparities = nullptr;
+		std::function<void(Slot &)> census;
+		std::function<void(Slot &)> match;
+	};
+
+	// Frame n uses slot n % 2, so the CENSUS images of one frame are computed while the other slot is matched
+	struct Slot
+	{
+		SlotState state = SlotState::Free;
+		Frame frame;
+		Tensor<uint64_t> censusLeft;
+		Tensor<uint64_t> censusRight;
+		std::exception_ptr exception;
+	};
+
+	SemiGlobalMatching _matcher;
+	ThreadPool _censusPool;
+	std::array<Slot, 2> _slots;
+
+	std::mutex _mutex;
+	std::condition_variable _changed;
+	bool _stopping = false;
+	// Frames below _submitted have been queued, frames below _completed are done
+	uint64_t _submitted = 0;
+	uint64_t _transformed = 0;
+	uint64_t _completed = 0;
+	std::map<uint64_t, std::exception_ptr> _exceptions;
+
+	std::thread _censusThread;
+	std::thread _matchingThread;
+
+	uint64_t Enqueue(Frame frame);
+	void CensusLoop();
+	void MatchingLoop();
+	void RethrowException(uint64_t frame);
+};
+} // namespace ThunderVision
@@ -2,15 +2,21 @@
 
 #include <vector>
 #include <stdexcept>
+#include <type_traits>
 
 //#define MEM_CHECK
 #include "Exceptions.h"
+#include "MemoryPool.h"
 
 #include <iostream>
 
 namespace ThunderVision
 {
-template <typename T>
+/**
+* The storage is allocated by TAllocator. The default PoolAllocator aligns it to 64 bytes and recycles the buffers
+* of destroyed tensors, so tensors of the same size created per frame do not allocate heap memory.
+*/
+template <typename T, typename TAllocator = PoolAllocator<T>>
 class Tensor
 {
   public:
@@ -52,12 +58,13 @@ class Tensor
 
 	void Reshape(std::vector<size_t> dimensions)
 	{
-		auto totalSize = computeTotalSize(_dimensions);
+		auto totalSize = computeTotalSize(dimensions);
 		if (totalSize != _totalSize)
 		{
 			throw new ThunderException("The overall size of the tensor may not be changed by reshape");
 		}
 		_dimensions = dimensions;
+		updateStrides();
 	}
 
 	/*For size_t*/
@@ -83,6 +90,16 @@ class Tensor
 		return _data[index];
 	}
 
+	inline T *Data()
+	{
+		return _data.data();
+	}
+
+	inline const T *Data() const
+	{
+		return _data.data();
+	}
+
 	inline T &At(std::initializer_list<size_t> position)
 	{
 		return _data[computeIndex(position)];
@@ -93,6 +110,22 @@ class Tensor
 		return _data[computeIndex(position)];
 	}
 
+	/**
+	* Element at the given coordinates, e.g. At(y, x, c). Trailing dimensions may be omitted like for At({...}).
+	* The index is computed without temporaries, so this costs the same as the manual index arithmetic.
+	*/
+	template <typename... TIndices>
+	inline T &At(TIndices... indices)
+	{
+		return _data[computeIndexOf(indices...)];
+	}
+
+	template <typename... TIndices>
+	inline const T &At(TIndices... indices) const
+	{
+		return _data[computeIndexOf(indices...)];
+	}
+
 	inline size_t GetDimension(size_t index) const
 	{
 #ifdef MEM_CHECK
@@ -102,6 +135,11 @@ class Tensor
 		return _dimensions[index];
 	}
 
+	inline const std::vector<size_t> &GetDimensions() const
+	{
+		return _dimensions;
+	}
+
 	inline size_t GetRank() const
 	{
 		return _dimensions.size();
@@ -155,7 +193,7 @@ class Tensor
 	}
 
 	template <typename TOut>
-	Tensor<TOut> AsType()
+	Tensor<TOut> AsType() const
 	{
 		Tensor<TOut> result(_dimensions);
 		for (size_t i = 0; i < _totalSize; i++)
@@ -178,30 +216,53 @@ class Tensor
 
   protected:
 	std::vector<size_t> _dimensions;
-	std::vector<T> _data;
-	size_t _totalSize;
+	std::vector<T, TAllocator> _data;
+	size_t _totalSize = 0;
 
 	std::vector<size_t> _dimensionStrides;
 
-	inline size_t computeIndex(std::vector<size_t> position) const
+	inline size_t computeIndex(const std::vector<size_t> &position) const
+	{
+		return computeIndex(position.data(), position.size());
+	}
+
+	inline size_t computeIndex(std::initializer_list<size_t> position) const
 	{
-		if (position.size() > _dimensions.size())
+		return computeIndex(position.begin(), position.size());
+	}
+
+	inline size_t computeIndex(const size_t *position, size_t rank) const
+	{
+		if (rank > _dimensions.size())
 		{
 			throw new ThunderException("The given position has to be of the same dimensionality as the tensor");
 		}
 
 		size_t positionIndex = 0;
-		for (size_t i = 0; i < position.size(); i++)
+		for (size_t i = 0; i < rank; i++)
 		{
 			positionIndex += position[i] * _dimensionStrides[i];
 		}
 		return positionIndex;
 	}
 
-	inline size_t computeIndex(std::initializer_list<size_t> pos) const
+	template <typename... TIndices>
+	inline size_t computeIndexOf(TIndices... indices) const
 	{
-		auto position = std::vector<size_t>(pos);
-		return computeIndex(position);
+		static_assert(sizeof...(TIndices) > 0, "At least one coordinate has to be given");
+		static_assert((std::is_integral<TIndices>::value && ...), "The coordinates have to be integers");
+#ifdef MEM_CHECK
+		if (sizeof...(TIndices) > _dimensions.size())
+		{
+			throw new ThunderException("The given position has to be of the same dimensionality as the tensor");
+		}
+#endif // MEM_CHECK
+
+		const size_t *strides = _dimensionStrides.data();
+		size_t positionIndex = 0;
+		size_t i = 0;
+		((positionIndex += static_cast<size_t>(indices) * strides[i++]), ...);
+		return positionIndex;
 	}
 
 	inline void updateStrides()
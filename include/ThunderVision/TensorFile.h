@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Exceptions.h"
+#include "Tensor.h"
+#include "TensorView.h"
+
+namespace ThunderVision
+{
+enum class TensorDataType : uint32_t
+{
+	UInt8,
+	Int8,
+	UInt16,
+	Int16,
+	UInt32,
+	Int32,
+	UInt64,
+	Int64,
+	Float32,
+	Float64
+};
+
+template <typename T>
+constexpr TensorDataType GetTensorDataType()
+{
+	if constexpr (std::is_same<T, uint8_t>::value)
+		return TensorDataType::UInt8;
+	else if constexpr (std::is_same<T, int8_t>::value)
+		return TensorDataType::Int8;
+	else if constexpr (std::is_same<T, uint16_t>::value)
+		return TensorDataType::UInt16;
+	else if constexpr (std::is_same<T, int16_t>::value)
+		return TensorDataType::Int16;
+	else if constexpr (std::is_same<T, uint32_t>::value)
+		return TensorDataType::UInt32;
+	else if constexpr (std::is_same<T, int32_t>::value)
+		return TensorDataType::Int32;
+	else if constexpr (std::is_same<T, uint64_t>::value)
+		return TensorDataType::UInt64;
+	else if constexpr (std::is_same<T, int64_t>::value)
+		return TensorDataType::Int64;
+	else if constexpr (std::is_same<T, float>::value)
+		return TensorDataType::Float32;
+	else if constexpr (std::is_same<T, double>::value)
+		return TensorDataType::Float64;
+	else
+		static_assert(sizeof(T) == 0, "The element type cannot be stored in a tensor file");
+}
+
+/**
+* Raw tensor files store the elements exactly as they are in memory, so a file is opened without parsing. The header
+* holds the magic "THTENSOR", the version, the data type, the rank, the element size, the offset of the data, the
+* dimensions and the strides in elements, all little endian 64 bit except the 32 bit fields after the magic. The data
+* starts at a multiple of DataAlignment bytes, which keeps mapped data as aligned as the pool allocated tensors.
+*/
+class TensorFile
+{
+  public:
+	static constexpr size_t DataAlignment = TensorAlignment;
+	static constexpr uint32_t Version = 1;
+
+	/**
+	* Writes the viewed elements row major, so crops and transposes are stored contiguously.
+	*/
+	template <typename T>
+	static void Write(const std::string &path, const TensorView<const T> &view)
+	{
+		Tensor<T> contiguous;
+		const T *data = view.Data();
+		if (!view.IsContiguous())
+		{
+			view.CopyTo(contiguous);
+			data = contiguous.Data();
+		}
+		Write(path, GetTensorDataType<T>(), sizeof(T), view.GetDimensions(), data);
+	}
+
+	template <typename T, typename TAllocator>
+	static void Write(const std::string &path, const Tensor<T, TAllocator> &tensor)
+	{
+		Write(path, TensorView<const T>(tensor));
+	}
+
+	/**
+	* Copies a file into a tensor, which is resized if its dimensions differ.
+	*/
+	template <typename T, typename TAllocator>
+	static void Read(const std::string &path, Tensor<T, TAllocator> &tensor);
+
+	static void Write(const std::string &path, TensorDataType type, size_t elementSize, const std::vector<size_t> &dimensions, const void *data);
+};
+
+/**
+* Read only memory mapping of a raw tensor file. GetView returns a view of the mapped elements without copying them,
+* the pages are loaded by the operating system on first access. The views have to be released before the mapping.
+*/
+class MappedTensorFile
+{
+  public:
+	MappedTensorFile() {}
+	explicit MappedTensorFile(const std::string &path);
+	~MappedTensorFile();
+
+	MappedTensorFile(const MappedTensorFile &) = delete;
+	MappedTensorFile &operator=(const MappedTensorFile &) = delete;
+	MappedTensorFile(MappedTensorFile &&other) noexcept;
+	MappedTensorFile &operator=(MappedTensorFile &&other) noexcept;
+
+	void Open(const std::string &path);
+	void Close();
+
+	bool IsOpen() const
+	{
+		return _mapping != nullptr;
+	}
+
+	TensorDataType GetDataType() const
+	{
+		return _type;
+	}
+
+	const std::vector<size_t> &GetDimensions() const
+	{
+		return _dimensions;
+	}
+
+	const std::vector<int64_t> &GetStrides() const
+	{
+		return _strides;
+	}
+
+	template <typename T>
+	TensorView<const T> GetView() const
+	{
+		if (_mapping == nullptr)
+			throw new ThunderException("The tensor file is not open");
+		if (GetTensorDataType<T>() != _type)
+			throw new ThunderException("The requested element type does not match the data type of the tensor file");
+		return TensorView<const T>(reinterpret_cast<const T *>(_data), _dimensions, _strides);
+	}
+
+  private:
+	void *_mapping = nullptr;
+	size_t _size = 0;
+	const uint8_t *_data = nullptr;
+	TensorDataType _type = TensorDataType::UInt8;
+	std::vector<size_t> _dimensions;
+	std::vector<int64_t> _strides;
+};
+
+template <typename T, typename TAllocator>
+void TensorFile::Read(const std::string &path, Tensor<T, TAllocator> &tensor)
+{
+	MappedTensorFile file(path);
+	file.GetView<T>().CopyTo(tensor);
+}
+} // namespace ThunderVision
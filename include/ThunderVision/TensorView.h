@@ -0,0 +1,294 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Tensor.h"
+#include "Exceptions.h"
+
+namespace ThunderVision
+{
+/**
+* Non-owning view of tensor data described by a base pointer, the dimensions and a stride per dimension in elements.
+* Slices, crops and transposes only change this description, the data is never copied, so the viewed memory has to
+* outlive the view. TensorView<const T> is a read only view, a view of a const tensor has to be read only.
+*/
+template <typename T>
+class TensorView
+{
+  public:
+	using ValueType = typename std::remove_const<T>::type;
+
+	TensorView() {}
+
+	/**
+	* Wraps a row major buffer without padding, e.g. memory filled by a camera driver.
+	*/
+	TensorView(T *data, std::vector<size_t> dimensions)
+		: _data(data), _dimensions(std::move(dimensions)), _strides(ContiguousStrides(_dimensions))
+	{
+	}
+
+	/**
+	* Wraps a buffer with arbitrary strides, element (i_0, ..., i_n) is data[offset + i_0 * strides[0] + ... + i_n * strides[n]].
+	* Row padding of an image is expressed by a row stride greater than width * channels.
+	*/
+	TensorView(T *data, std::vector<size_t> dimensions, std::vector<int64_t> strides, int64_t offset = 0)
+		: _data(data + offset), _dimensions(std::move(dimensions)), _strides(std::move(strides))
+	{
+		if (_strides.size() != _dimensions.size())
+			throw new ThunderException("A stride has to be given for every dimension of the view");
+	}
+
+	template <typename TAllocator>
+	TensorView(Tensor<ValueType, TAllocator> &tensor)
+		: TensorView(tensor.Data(), tensor.GetDimensions())
+	{
+	}
+
+	template <typename TAllocator, typename U = T, typename std::enable_if<std::is_const<U>::value, int>::type = 0>
+	TensorView(const Tensor<ValueType, TAllocator> &tensor)
+		: TensorView(tensor.Data(), tensor.GetDimensions())
+	{
+	}
+
+	/**
+	* A writable view can be used wherever a read only view is expected.
+	*/
+	template <typename U, typename std::enable_if<std::is_const<T>::value && std::is_same<const U, T>::value && !std::is_same<U, T>::value, int>::type = 0>
+	TensorView(const TensorView<U> &view)
+		: _data(view.Data()), _dimensions(view.GetDimensions()), _strides(view.GetStrides())
+	{
+	}
+
+	inline T *Data() const
+	{
+		return _data;
+	}
+
+	inline size_t GetRank() const
+	{
+		return _dimensions.size();
+	}
+
+	inline size_t GetDimension(size_t index) const
+	{
+		return _dimensions[index];
+	}
+
+	inline const std::vector<size_t> &GetDimensions() const
+	{
+		return _dimensions;
+	}
+
+	inline int64_t GetStride(size_t index) const
+	{
+		return _strides[index];
+	}
+
+	inline const std::vector<int64_t> &GetStrides() const
+	{
+		return _strides;
+	}
+
+	size_t GetTotalSize() const
+	{
+		size_t totalSize = 1;
+		for (const auto &dim : _dimensions)
+		{
+			totalSize *= dim;
+		}
+		return totalSize;
+	}
+
+	/**
+	* True if the elements are stored row major without gaps, i.e. the view can be processed like a tensor of the same shape.
+	*/
+	bool IsContiguous() const
+	{
+		return _strides == ContiguousStrides(_dimensions);
+	}
+
+	inline T &At(std::initializer_list<size_t> position) const
+	{
+		int64_t index = 0;
+		size_t i = 0;
+		for (const auto &pos : position)
+		{
+			index += static_cast<int64_t>(pos) * _strides[i++];
+		}
+		return _data[index];
+	}
+
+	/**
+	* Element at the given coordinates, e.g. At(y, x, c), without temporaries.
+	*/
+	template <typename... TIndices>
+	inline T &At(TIndices... indices) const
+	{
+		static_assert(sizeof...(TIndices) > 0, "At least one coordinate has to be given");
+		static_assert((std::is_integral<TIndices>::value && ...), "The coordinates have to be integers");
+
+		const int64_t *strides = _strides.data();
+		int64_t index = 0;
+		size_t i = 0;
+		((index += static_cast<int64_t>(indices) * strides[i++]), ...);
+		return _data[index];
+	}
+
+	/**
+	* Fixes dimension to index and removes it, e.g. Slice(2, c) selects channel c of an image and Slice(0, y) row y.
+	*/
+	TensorView<T> Slice(size_t dimension, size_t index) const
+	{
+		CheckDimension(dimension);
+		if (index >= _dimensions[dimension])
+			throw new ThunderException("The slice index is outside of the tensor range");
+
+		TensorView<T> result(*this);
+		result._data += static_cast<int64_t>(index) * _strides[dimension];
+		result._dimensions.erase(result._dimensions.begin() + dimension);
+		result._strides.erase(result._strides.begin() + dimension);
+		return result;
+	}
+
+	/**
+	* Restricts dimension to [begin, begin + size).
+	*/
+	TensorView<T> Crop(size_t dimension, size_t begin, size_t size) const
+	{
+		CheckDimension(dimension);
+		if (begin + size > _dimensions[dimension])
+			throw new ThunderException("The crop is outside of the tensor range");
+
+		TensorView<T> result(*this);
+		result._data += static_cast<int64_t>(begin) * _strides[dimension];
+		result._dimensions[dimension] = size;
+		return result;
+	}
+
+	/**
+	* Region of interest of an image (rank 2 or 3 with the channels last).
+	*/
+	TensorView<T> Crop(size_t y, size_t x, size_t height, size_t width) const
+	{
+		return Crop(0, y, height).Crop(1, x, width);
+	}
+
+	TensorView<T> Transpose(size_t first, size_t second) const
+	{
+		CheckDimension(first);
+		CheckDimension(second);
+
+		TensorView<T> result(*this);
+		std::swap(result._dimensions[first], result._dimensions[second]);
+		std::swap(result._strides[first], result._strides[second]);
+		return result;
+	}
+
+	/**
+	* Removes all dimensions of size 1.
+	*/
+	TensorView<T> Squeeze() const
+	{
+		TensorView<T> result(*this);
+		result._dimensions.clear();
+		result._strides.clear();
+		for (size_t i = 0; i < _dimensions.size(); i++)
+		{
+			if (_dimensions[i] != 1)
+			{
+				result._dimensions.push_back(_dimensions[i]);
+				result._strides.push_back(_strides[i]);
+			}
+		}
+		return result;
+	}
+
+	/**
+	* Copies the viewed elements into a contiguous tensor, which is resized if necessary.
+	*/
+	template <typename TAllocator>
+	void CopyTo(Tensor<ValueType, TAllocator> &target) const
+	{
+		if (target.GetDimensions() != _dimensions)
+			target.Resize(_dimensions);
+
+		ValueType *out = target.Data();
+		ForEachRow([&out](const T *row, size_t length, int64_t stride) {
+			for (size_t i = 0; i < length; i++, out++)
+			{
+				*out = row[i * stride];
+			}
+		});
+	}
+
+	Tensor<ValueType> ToTensor() const
+	{
+		Tensor<ValueType> result;
+		CopyTo(result);
+		return result;
+	}
+
+  private:
+	template <typename U>
+	friend class TensorView;
+
+	T *_data = nullptr;
+	std::vector<size_t> _dimensions;
+	std::vector<int64_t> _strides;
+
+	static std::vector<int64_t> ContiguousStrides(const std::vector<size_t> &dimensions)
+	{
+		std::vector<int64_t> strides(dimensions.size());
+		int64_t stride = 1;
+		for (size_t i = dimensions.size(); i > 0; i--)
+		{
+			strides[i - 1] = stride;
+			stride *= static_cast<int64_t>(dimensions[i - 1]);
+		}
+		return strides;
+	}
+
+	inline void CheckDimension(size_t dimension) const
+	{
+		if (dimension >= _dimensions.size())
+			throw new ThunderException("The given dimension is greater than the available number of dimensions");
+	}
+
+	// Calls function(rowStart, length, stride) for every line along the last dimension in row major order
+	template <typename TFunction>
+	void ForEachRow(TFunction function) const
+	{
+		if (_dimensions.empty())
+		{
+			function(_data, 1, 1);
+			return;
+		}
+		if (GetTotalSize() == 0)
+			return;
+
+		const size_t last = _dimensions.size() - 1;
+		std::vector<size_t> position(last, 0);
+		while (true)
+		{
+			int64_t offset = 0;
+			for (size_t i = 0; i < last; i++)
+			{
+				offset += static_cast<int64_t>(position[i]) * _strides[i];
+			}
+			function(_data + offset, _dimensions[last], _strides[last]);
+
+			size_t i = last;
+			while (i > 0 && ++position[i - 1] == _dimensions[i - 1])
+			{
+				position[--i] = 0;
+			}
+			if (i == 0)
+				return;
+		}
+	}
+};
+} // namespace ThunderVision
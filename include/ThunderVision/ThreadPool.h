@@ -0,0 +1,52 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace ThunderVision
+{
+/**
+* Fixed set of worker threads. The calling thread of ParallelFor takes part in the work, so a pool of size n
+* computes with n threads in total and n - 1 workers.
+*/
+class ThreadPool
+{
+  public:
+	explicit ThreadPool(size_t nrThreads);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	size_t GetNrThreads() const;
+
+	/**
+	* Calls function(chunkBegin, chunkEnd, threadIndex) for consecutive chunks of [begin, end) and returns when all
+	* chunks are processed. threadIndex is smaller than GetNrThreads() and unique among the chunks of this ParallelFor
+	* that run at the same time, the calling thread has index 0. Concurrent ParallelFor calls on the same pool reuse
+	* the indices, so per thread buffers must not be shared between them. Exceptions of function are rethrown in the
+	* caller.
+	*/
+	void ParallelFor(int64_t begin, int64_t end, const std::function<void(int64_t, int64_t, size_t)> &function);
+
+	/**
+	* Shared pool with one thread per hardware thread.
+	*/
+	static ThreadPool &GetDefault();
+
+  private:
+	std::vector<std::thread> _workers;
+	std::queue<std::function<void()>> _tasks;
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	bool _stopping = false;
+
+	void Enqueue(std::function<void()> task);
+	void WorkerLoop();
+};
+} // namespace ThunderVision
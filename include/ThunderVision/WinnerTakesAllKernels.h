@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "CpuFeatures.h"
+
+namespace ThunderVision
+{
+/**
+* Subpixel refinement of the selected disparity from the aggregated costs of its two neighbours: a parabola or two
+* lines of opposite slope (equiangular) through the three costs. Disparities at the end of the range keep their
+* integer value.
+*/
+enum class SubpixelMode
+{
+	None,
+	Parabolic,
+	Equiangular
+};
+
+/**
+* A disparity is invalid if the smallest cost of the disparities which are not neighbours of the selected disparity
+* is below best * (1 + uniquenessRatio), 0 disables the check. Invalid disparities are written as invalidValue.
+*/
+struct WinnerTakesAllParameters
+{
+	SubpixelMode subpixel = SubpixelMode::None;
+	float uniquenessRatio = 0.0f;
+	float invalidValue = 3.402823466e+38f;
+};
+
+// Fractional bits of the fixed point disparities (Q4)
+constexpr int DisparityFractionBits = 4;
+
+/**
+* Selects the disparities of width pixels whose nrDisparities aggregated costs are stride elements apart: the minimum,
+* its index (the first one for equal costs), the second best cost for the uniqueness check and the subpixel offset
+* are computed in one pass over the costs of a pixel.
+*/
+template <typename TAggregated>
+using WinnerTakesAllKernel = void (*)(const TAggregated *aggregated, const size_t width, const size_t stride, const size_t nrDisparities, const WinnerTakesAllParameters &parameters, float *disparities);
+
+/**
+* Selects the disparities of the right image from the aggregated costs of a row of the left image with nrDisparities
+* contiguous costs per pixel: right pixel x matches left pixel x + d, so its costs are the diagonal aggregated[x + d, d],
+* d < min(nrDisparities, width - x). The uniqueness check is not applied. buffer holds 2 * (width + nrDisparities)
+* elements.
+*/
+template <typename TAggregated>
+using RightWinnerTakesAllKernel = void (*)(const TAggregated *aggregated, const size_t width, const size_t nrDisparities, const WinnerTakesAllParameters &parameters, TAggregated *buffer, float *disparities);
+
+template <typename TAggregated>
+struct WinnerTakesAllKernels
+{
+	WinnerTakesAllKernel<TAggregated> disparities;
+	RightWinnerTakesAllKernel<TAggregated> rightDisparities;
+	SimdLevel level;
+};
+
+/**
+* Selects the fastest kernels available on the executing CPU, maxLevel allows to restrict the selection. Kernels are
+* available for unsigned int and uint16_t aggregated costs.
+*/
+template <typename TAggregated>
+WinnerTakesAllKernels<TAggregated> SelectWinnerTakesAllKernels(const SimdLevel maxLevel = SimdLevel::AVX2);
+} // namespace ThunderVision
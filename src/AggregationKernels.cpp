@@ -0,0 +1,228 @@
+#include "AggregationKernels.h"
+
+#include <algorithm>
+
+namespace
+{
+inline void Accumulate(unsigned int &aggregated, const unsigned int value)
+{
+	aggregated += value;
+}
+
+inline void Accumulate(uint16_t &aggregated, const unsigned int value)
+{
+	aggregated = static_cast<uint16_t>(std::min<unsigned int>(aggregated + value, UINT16_MAX));
+}
+
+template <typename TAggregated>
+uint16_t AggregateStepPortable(const uint16_t *costs, const uint16_t *previous, const uint16_t previousMin, uint16_t *current, TAggregated *aggregated, const size_t nrDisparities, const uint16_t P1, const uint16_t P2)
+{
+	const unsigned int minCosts = previousMin;
+	const unsigned int penaltyP2 = minCosts + P2;
+	const size_t end = nrDisparities - 1;
+
+	unsigned int currentMin = UINT16_MAX;
+	unsigned int value;
+	if (nrDisparities == 1)
+	{
+		value = costs[0] + std::min<unsigned int>(previous[0], penaltyP2) - minCosts;
+		current[0] = static_cast<uint16_t>(value);
+		Accumulate(aggregated[0], value);
+		return static_cast<uint16_t>(value);
+	}
+
+	value = costs[0] + std::min<unsigned int>(previous[0], std::min<unsigned int>(previous[1] + P1, penaltyP2)) - minCosts;
+	current[0] = static_cast<uint16_t>(value);
+	Accumulate(aggregated[0], value);
+	currentMin = std::min(currentMin, value);
+
+	for (size_t d = 1; d < end; d++)
+	{
+		value = costs[d] + std::min<unsigned int>(previous[d], std::min<unsigned int>(penaltyP2, std::min(previous[d - 1], previous[d + 1]) + P1)) - minCosts;
+		current[d] = static_cast<uint16_t>(value);
+		Accumulate(aggregated[d], value);
+		currentMin = std::min(currentMin, value);
+	}
+
+	value = costs[end] + std::min<unsigned int>(previous[end], std::min<unsigned int>(previous[end - 1] + P1, penaltyP2)) - minCosts;
+	current[end] = static_cast<uint16_t>(value);
+	Accumulate(aggregated[end], value);
+	currentMin = std::min(currentMin, value);
+
+	return static_cast<uint16_t>(currentMin);
+}
+
+template <typename TAggregated>
+uint16_t AggregateStartPortable(const uint16_t *costs, uint16_t *current, TAggregated *aggregated, const size_t nrDisparities)
+{
+	uint16_t currentMin = UINT16_MAX;
+	for (size_t d = 0; d < nrDisparities; d++)
+	{
+		current[d] = costs[d];
+		Accumulate(aggregated[d], costs[d]);
+		currentMin = std::min(currentMin, costs[d]);
+	}
+	return currentMin;
+}
+
+#ifdef THUNDER_X86
+// All path costs are at most UINT16_MAX (see AggregationStepKernel), hence the recurrence can be evaluated in
+// saturated 16 bit lanes: a saturated term only wins the minimum if the exact minimum is UINT16_MAX as well.
+// The subtraction of the previous minimum is applied before the costs are added, so it never wraps.
+
+THUNDER_TARGET_SSE41 inline void AccumulateSSE41(unsigned int *aggregated, const __m128i value)
+{
+	const __m128i low = _mm_cvtepu16_epi32(value);
+	const __m128i high = _mm_unpackhi_epi16(value, _mm_setzero_si128());
+	__m128i *target = reinterpret_cast<__m128i *>(aggregated);
+	_mm_storeu_si128(target, _mm_add_epi32(_mm_loadu_si128(target), low));
+	_mm_storeu_si128(target + 1, _mm_add_epi32(_mm_loadu_si128(target + 1), high));
+}
+
+THUNDER_TARGET_SSE41 inline void AccumulateSSE41(uint16_t *aggregated, const __m128i value)
+{
+	__m128i *target = reinterpret_cast<__m128i *>(aggregated);
+	_mm_storeu_si128(target, _mm_adds_epu16(_mm_loadu_si128(target), value));
+}
+
+template <typename TAggregated>
+THUNDER_TARGET_SSE41 uint16_t AggregateStepSSE41(const uint16_t *costs, const uint16_t *previous, const uint16_t previousMin, uint16_t *current, TAggregated *aggregated, const size_t nrDisparities, const uint16_t P1, const uint16_t P2)
+{
+	const __m128i invalid = _mm_set1_epi16(static_cast<short>(UINT16_MAX));
+	const __m128i penaltyP1 = _mm_set1_epi16(static_cast<short>(P1));
+	const __m128i minCosts = _mm_set1_epi16(static_cast<short>(previousMin));
+	const __m128i penaltyP2 = _mm_adds_epu16(minCosts, _mm_set1_epi16(static_cast<short>(P2)));
+
+	__m128i currentMin = invalid;
+	__m128i left = invalid;
+	__m128i center = _mm_loadu_si128(reinterpret_cast<const __m128i *>(previous));
+	for (size_t d = 0; d < nrDisparities; d += 8)
+	{
+		const __m128i right = d + 8 < nrDisparities ? _mm_loadu_si128(reinterpret_cast<const __m128i *>(previous + d + 8)) : invalid;
+
+		const __m128i previousMinus = _mm_alignr_epi8(center, left, 14);
+		const __m128i previousPlus = _mm_alignr_epi8(right, center, 2);
+
+		__m128i minimum = _mm_adds_epu16(_mm_min_epu16(previousMinus, previousPlus), penaltyP1);
+		minimum = _mm_min_epu16(center, _mm_min_epu16(minimum, penaltyP2));
+
+		const __m128i cost = _mm_loadu_si128(reinterpret_cast<const __m128i *>(costs + d));
+		const __m128i value = _mm_add_epi16(cost, _mm_sub_epi16(minimum, minCosts));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(current + d), value);
+		AccumulateSSE41(aggregated + d, value);
+		currentMin = _mm_min_epu16(currentMin, value);
+
+		left = center;
+		center = right;
+	}
+	return static_cast<uint16_t>(_mm_cvtsi128_si32(_mm_minpos_epu16(currentMin)));
+}
+
+template <typename TAggregated>
+THUNDER_TARGET_SSE41 uint16_t AggregateStartSSE41(const uint16_t *costs, uint16_t *current, TAggregated *aggregated, const size_t nrDisparities)
+{
+	__m128i currentMin = _mm_set1_epi16(static_cast<short>(UINT16_MAX));
+	for (size_t d = 0; d < nrDisparities; d += 8)
+	{
+		const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(costs + d));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(current + d), value);
+		AccumulateSSE41(aggregated + d, value);
+		currentMin = _mm_min_epu16(currentMin, value);
+	}
+	return static_cast<uint16_t>(_mm_cvtsi128_si32(_mm_minpos_epu16(currentMin)));
+}
+
+THUNDER_TARGET_AVX2 inline void AccumulateAVX2(unsigned int *aggregated, const __m256i value)
+{
+	const __m256i low = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(value));
+	const __m256i high = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(value, 1));
+	__m256i *target = reinterpret_cast<__m256i *>(aggregated);
+	_mm256_storeu_si256(target, _mm256_add_epi32(_mm256_loadu_si256(target), low));
+	_mm256_storeu_si256(target + 1, _mm256_add_epi32(_mm256_loadu_si256(target + 1), high));
+}
+
+THUNDER_TARGET_AVX2 inline void AccumulateAVX2(uint16_t *aggregated, const __m256i value)
+{
+	__m256i *target = reinterpret_cast<__m256i *>(aggregated);
+	_mm256_storeu_si256(target, _mm256_adds_epu16(_mm256_loadu_si256(target), value));
+}
+
+THUNDER_TARGET_AVX2 inline uint16_t HorizontalMinAVX2(const __m256i value)
+{
+	const __m128i minimum = _mm_min_epu16(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+	return static_cast<uint16_t>(_mm_cvtsi128_si32(_mm_minpos_epu16(minimum)));
+}
+
+template <typename TAggregated>
+THUNDER_TARGET_AVX2 uint16_t AggregateStepAVX2(const uint16_t *costs, const uint16_t *previous, const uint16_t previousMin, uint16_t *current, TAggregated *aggregated, const size_t nrDisparities, const uint16_t P1, const uint16_t P2)
+{
+	const __m256i invalid = _mm256_set1_epi16(static_cast<short>(UINT16_MAX));
+	const __m256i penaltyP1 = _mm256_set1_epi16(static_cast<short>(P1));
+	const __m256i minCosts = _mm256_set1_epi16(static_cast<short>(previousMin));
+	const __m256i penaltyP2 = _mm256_adds_epu16(minCosts, _mm256_set1_epi16(static_cast<short>(P2)));
+
+	__m256i currentMin = invalid;
+	__m256i left = invalid;
+	__m256i center = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(previous));
+	for (size_t d = 0; d < nrDisparities; d += 16)
+	{
+		const __m256i right = d + 16 < nrDisparities ? _mm256_loadu_si256(reinterpret_cast<const __m256i *>(previous + d + 16)) : invalid;
+
+		// alignr only shifts within 128 bit lanes, so the neighbouring lanes are brought in by a permute first
+		const __m256i leftHalves = _mm256_permute2x128_si256(left, center, 0x21);
+		const __m256i rightHalves = _mm256_permute2x128_si256(center, right, 0x21);
+		const __m256i previousMinus = _mm256_alignr_epi8(center, leftHalves, 14);
+		const __m256i previousPlus = _mm256_alignr_epi8(rightHalves, center, 2);
+
+		__m256i minimum = _mm256_adds_epu16(_mm256_min_epu16(previousMinus, previousPlus), penaltyP1);
+		minimum = _mm256_min_epu16(center, _mm256_min_epu16(minimum, penaltyP2));
+
+		const __m256i cost = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(costs + d));
+		const __m256i value = _mm256_add_epi16(cost, _mm256_sub_epi16(minimum, minCosts));
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(current + d), value);
+		AccumulateAVX2(aggregated + d, value);
+		currentMin = _mm256_min_epu16(currentMin, value);
+
+		left = center;
+		center = right;
+	}
+	return HorizontalMinAVX2(currentMin);
+}
+
+template <typename TAggregated>
+THUNDER_TARGET_AVX2 uint16_t AggregateStartAVX2(const uint16_t *costs, uint16_t *current, TAggregated *aggregated, const size_t nrDisparities)
+{
+	__m256i currentMin = _mm256_set1_epi16(static_cast<short>(UINT16_MAX));
+	for (size_t d = 0; d < nrDisparities; d += 16)
+	{
+		const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(costs + d));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(current + d), value);
+		AccumulateAVX2(aggregated + d, value);
+		currentMin = _mm256_min_epu16(currentMin, value);
+	}
+	return HorizontalMinAVX2(currentMin);
+}
+#endif // THUNDER_X86
+} // namespace
+
+template <typename TAggregated>
+ThunderVision::AggregationKernels<TAggregated> ThunderVision::SelectAggregationKernels(const size_t nrDisparities, const SimdLevel maxLevel)
+{
+	const SimdLevel level = std::min(maxLevel, GetSupportedSimdLevel());
+#ifdef THUNDER_X86
+	if (level >= SimdLevel::AVX2 && nrDisparities % 16 == 0)
+	{
+		return {AggregateStepAVX2<TAggregated>, AggregateStartAVX2<TAggregated>, SimdLevel::AVX2};
+	}
+	if (level >= SimdLevel::SSE41 && nrDisparities % 8 == 0)
+	{
+		return {AggregateStepSSE41<TAggregated>, AggregateStartSSE41<TAggregated>, SimdLevel::SSE41};
+	}
+#endif
+	return {AggregateStepPortable<TAggregated>, AggregateStartPortable<TAggregated>, SimdLevel::Portable};
+}
+
+template ThunderVision::AggregationKernels<unsigned int> ThunderVision::SelectAggregationKernels<unsigned int>(const size_t, const SimdLevel);
+template ThunderVision::AggregationKernels<uint16_t> ThunderVision::SelectAggregationKernels<uint16_t>(const size_t, const SimdLevel);
@@ -0,0 +1,238 @@
+#include "CensusTransform.h"
+
+#include <array>
+#include <vector>
+
+namespace
+{
+using RowContext = ThunderVision::CensusTransform::RowContext;
+
+#ifdef THUNDER_X86
+// The comparison masks of 8 consecutive bits are collected in one byte plane per pixel. Afterwards the up to 8 planes
+// are transposed so that plane j becomes byte j of the 64 bit vector of each pixel.
+
+THUNDER_TARGET_SSE41 void StoreTransposedSSE41(const __m128i *planes, uint64_t *census)
+{
+	const __m128i a0 = _mm_unpacklo_epi8(planes[0], planes[1]);
+	const __m128i a1 = _mm_unpackhi_epi8(planes[0], planes[1]);
+	const __m128i b0 = _mm_unpacklo_epi8(planes[2], planes[3]);
+	const __m128i b1 = _mm_unpackhi_epi8(planes[2], planes[3]);
+	const __m128i c0 = _mm_unpacklo_epi8(planes[4], planes[5]);
+	const __m128i c1 = _mm_unpackhi_epi8(planes[4], planes[5]);
+	const __m128i d0 = _mm_unpacklo_epi8(planes[6], planes[7]);
+	const __m128i d1 = _mm_unpackhi_epi8(planes[6], planes[7]);
+
+	const __m128i low[4] = {_mm_unpacklo_epi16(a0, b0), _mm_unpackhi_epi16(a0, b0), _mm_unpacklo_epi16(a1, b1), _mm_unpackhi_epi16(a1, b1)};
+	const __m128i high[4] = {_mm_unpacklo_epi16(c0, d0), _mm_unpackhi_epi16(c0, d0), _mm_unpacklo_epi16(c1, d1), _mm_unpackhi_epi16(c1, d1)};
+
+	__m128i *target = reinterpret_cast<__m128i *>(census);
+	for (int i = 0; i < 4; i++)
+	{
+		_mm_storeu_si128(target + 2 * i, _mm_unpacklo_epi32(low[i], high[i]));
+		_mm_storeu_si128(target + 2 * i + 1, _mm_unpackhi_epi32(low[i], high[i]));
+	}
+}
+
+THUNDER_TARGET_SSE41 size_t ComputeRowSSE41(const uint8_t *row, const size_t begin, const size_t end, const RowContext &context, uint64_t *census)
+{
+	const __m128i signFlip = _mm_set1_epi8(static_cast<char>(0x80));
+	const size_t nrBits = context.nrBits;
+
+	size_t x = begin;
+	for (; x + 16 <= end; x += 16)
+	{
+		__m128i planes[8];
+		for (int i = 0; i < 8; i++)
+			planes[i] = _mm_setzero_si128();
+
+		const uint8_t *pixel = row + x;
+		const __m128i center = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pixel)), signFlip);
+		for (size_t k = 0; k < nrBits; k++)
+		{
+			const __m128i smaller = context.dense ? center : _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pixel + context.smaller[k])), signFlip);
+			const __m128i greater = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pixel + context.greater[k])), signFlip);
+			const __m128i mask = _mm_and_si128(_mm_cmpgt_epi8(greater, smaller), _mm_set1_epi8(static_cast<char>(1 << (k & 7))));
+			planes[k >> 3] = _mm_or_si128(planes[k >> 3], mask);
+		}
+		StoreTransposedSSE41(planes, census + x);
+	}
+	return x;
+}
+
+THUNDER_TARGET_AVX2 void StoreTransposedAVX2(const __m256i *planes, uint64_t *census)
+{
+	const __m256i a0 = _mm256_unpacklo_epi8(planes[0], planes[1]);
+	const __m256i a1 = _mm256_unpackhi_epi8(planes[0], planes[1]);
+	const __m256i b0 = _mm256_unpacklo_epi8(planes[2], planes[3]);
+	const __m256i b1 = _mm256_unpackhi_epi8(planes[2], planes[3]);
+	const __m256i c0 = _mm256_unpacklo_epi8(planes[4], planes[5]);
+	const __m256i c1 = _mm256_unpackhi_epi8(planes[4], planes[5]);
+	const __m256i d0 = _mm256_unpacklo_epi8(planes[6], planes[7]);
+	const __m256i d1 = _mm256_unpackhi_epi8(planes[6], planes[7]);
+
+	const __m256i low[4] = {_mm256_unpacklo_epi16(a0, b0), _mm256_unpackhi_epi16(a0, b0), _mm256_unpacklo_epi16(a1, b1), _mm256_unpackhi_epi16(a1, b1)};
+	const __m256i high[4] = {_mm256_unpacklo_epi16(c0, d0), _mm256_unpackhi_epi16(c0, d0), _mm256_unpacklo_epi16(c1, d1), _mm256_unpackhi_epi16(c1, d1)};
+
+	// The unpacks work within 128 bit lanes, the lower lanes hold pixels 0 - 15 and the upper lanes pixels 16 - 31
+	__m256i *target = reinterpret_cast<__m256i *>(census);
+	for (int i = 0; i < 4; i++)
+	{
+		const __m256i first = _mm256_unpacklo_epi32(low[i], high[i]);
+		const __m256i second = _mm256_unpackhi_epi32(low[i], high[i]);
+		_mm256_storeu_si256(target + i, _mm256_permute2x128_si256(first, second, 0x20));
+		_mm256_storeu_si256(target + 4 + i, _mm256_permute2x128_si256(first, second, 0x31));
+	}
+}
+
+THUNDER_TARGET_AVX2 size_t ComputeRowAVX2(const uint8_t *row, const size_t begin, const size_t end, const RowContext &context, uint64_t *census)
+{
+	const __m256i signFlip = _mm256_set1_epi8(static_cast<char>(0x80));
+	const size_t nrBits = context.nrBits;
+
+	size_t x = begin;
+	for (; x + 32 <= end; x += 32)
+	{
+		__m256i planes[8];
+		for (int i = 0; i < 8; i++)
+			planes[i] = _mm256_setzero_si256();
+
+		const uint8_t *pixel = row + x;
+		const __m256i center = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(pixel)), signFlip);
+		for (size_t k = 0; k < nrBits; k++)
+		{
+			const __m256i smaller = context.dense ? center : _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(pixel + context.smaller[k])), signFlip);
+			const __m256i greater = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(pixel + context.greater[k])), signFlip);
+			const __m256i mask = _mm256_and_si256(_mm256_cmpgt_epi8(greater, smaller), _mm256_set1_epi8(static_cast<char>(1 << (k & 7))));
+			planes[k >> 3] = _mm256_or_si256(planes[k >> 3], mask);
+		}
+		StoreTransposedAVX2(planes, census + x);
+	}
+	return x;
+}
+#endif // THUNDER_X86
+} // namespace
+
+ThunderVision::CensusTransform::CensusTransform(CensusWindow window, CensusType type)
+{
+	_window = window;
+	_type = type;
+	_windowWidth = window == CensusWindow::W5x5 ? 5 : (window == CensusWindow::W7x7 ? 7 : 9);
+	_windowHeight = window == CensusWindow::W5x5 ? 5 : 7;
+	_radiusX = (_windowWidth - 1) / 2;
+	_radiusY = (_windowHeight - 1) / 2;
+}
+
+size_t ThunderVision::CensusTransform::GetWindowWidth() const
+{
+	return _windowWidth;
+}
+
+size_t ThunderVision::CensusTransform::GetWindowHeight() const
+{
+	return _windowHeight;
+}
+
+size_t ThunderVision::CensusTransform::GetNrBits() const
+{
+	const size_t windowSize = _windowWidth * _windowHeight;
+	return _type == CensusType::Dense ? windowSize : (windowSize - 1) / 2;
+}
+
+ThunderVision::CensusWindow ThunderVision::CensusTransform::GetWindow() const
+{
+	return _window;
+}
+
+ThunderVision::CensusType ThunderVision::CensusTransform::GetType() const
+{
+	return _type;
+}
+
+void ThunderVision::CensusTransform::SetInvalidValue(uint64_t invalidValue)
+{
+	_invalidValue = invalidValue;
+}
+
+uint64_t ThunderVision::CensusTransform::GetInvalidValue() const
+{
+	return _invalidValue;
+}
+
+ThunderVision::CensusTransform::RowContext ThunderVision::CensusTransform::PrepareRows(const int64_t rowStride, const SimdLevel maxLevel) const
+{
+	const int64_t windowWidth = static_cast<int64_t>(_windowWidth);
+	const int64_t windowSize = static_cast<int64_t>(_windowWidth * _windowHeight);
+	auto offset = [&](int64_t k) { return (k / windowWidth - static_cast<int64_t>(_radiusY)) * rowStride + k % windowWidth - static_cast<int64_t>(_radiusX); };
+
+	RowContext context;
+	context.dense = _type == CensusType::Dense;
+	context.nrBits = GetNrBits();
+	context.rowStride = rowStride;
+	context.level = std::min(GetSupportedSimdLevel(), maxLevel);
+	for (size_t k = 0; k < context.nrBits; k++)
+	{
+		const int64_t bit = static_cast<int64_t>(k);
+		context.smaller[k] = context.dense ? 0 : offset(bit);
+		context.greater[k] = context.dense ? offset(bit) : offset(windowSize - 1 - bit);
+	}
+	return context;
+}
+
+void ThunderVision::CensusTransform::ComputeRowU8(const uint8_t *row, const size_t width, const RowContext &context, uint64_t *census) const
+{
+	const size_t begin = _radiusX;
+	const size_t end = width - _radiusX;
+
+	size_t x = begin;
+#ifdef THUNDER_X86
+	if (context.level >= SimdLevel::AVX2)
+		x = ComputeRowAVX2(row, x, end, context, census);
+	if (context.level >= SimdLevel::SSE41)
+		x = ComputeRowSSE41(row, x, end, context, census);
+#endif
+
+	for (; x < end; x++)
+	{
+		census[x] = ComputeVector(row + x, context.rowStride, 1);
+	}
+}
+
+void ThunderVision::CensusTransform::ComputeFromRGB(const TensorView<const uint8_t> &rgb, Tensor<uint64_t> &census, GrayscaleWeights weights, ThreadPool &pool, SimdLevel maxLevel) const
+{
+	if (rgb.GetRank() != 3 || (rgb.GetDimension(2) != 3 && rgb.GetDimension(2) != 4))
+		throw new ThunderException("The CENSUS transform of colour images requires an RGB or RGBA image (rank 3 tensor with 3 or 4 channels).");
+
+	const size_t height = rgb.GetDimension(0);
+	const size_t width = rgb.GetDimension(1);
+	if (census.GetRank() != 2 || census.GetDimension(0) != height || census.GetDimension(1) != width)
+		census.Resize({height, width});
+
+	const size_t windowHeight = _windowHeight;
+	const RowContext context = PrepareRows(static_cast<int64_t>(width), maxLevel);
+	pool.ParallelFor(0, static_cast<int64_t>(height), [&](int64_t begin, int64_t end, size_t) {
+		// Image row r is stored at ring rows r % windowHeight and r % windowHeight + windowHeight, hence the rows of
+		// every window are consecutive in the ring. The buffer of a worker is reused by its later chunks.
+		thread_local std::vector<uint8_t> ring;
+		ring.resize(2 * windowHeight * width);
+
+		size_t next = 0;
+		for (size_t y = static_cast<size_t>(begin); y < static_cast<size_t>(end); y++)
+		{
+			if (y < _radiusY || y + _radiusY >= height || width <= 2 * _radiusX)
+			{
+				std::fill(census.Data() + y * width, census.Data() + (y + 1) * width, _invalidValue);
+				continue;
+			}
+
+			next = std::max(next, y - _radiusY);
+			for (; next <= y + _radiusY; next++)
+			{
+				uint8_t *slot = ring.data() + (next % windowHeight) * width;
+				ColorspaceConversion::ConvertRowToGrayscale(rgb, next, slot, weights, maxLevel);
+				std::copy(slot, slot + width, slot + windowHeight * width);
+			}
+			const TensorView<const uint8_t> window(ring.data() + ((y - _radiusY) % windowHeight) * width, {windowHeight, width});
+			ComputeRow(window, _radiusY, context, census.Data() + y * width);
+		}
+	});
+}
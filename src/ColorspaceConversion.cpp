@@ -0,0 +1,188 @@
+#include "ColorspaceConversion.h"
+
+#include <algorithm>
+#include <array>
+
+#include "Profiler.h"
+
+namespace
+{
+// Fixed point weights of r, g and b in 1/256, the average multiplies the sum by 2^16 / 3 instead
+struct Weights
+{
+	uint16_t r;
+	uint16_t g;
+	uint16_t b;
+	bool average;
+};
+
+const uint16_t averageFactor = 21846;
+
+Weights GetWeights(ThunderVision::GrayscaleWeights weights)
+{
+	switch (weights)
+	{
+	case ThunderVision::GrayscaleWeights::BT601:
+		return {77, 150, 29, false};
+	case ThunderVision::GrayscaleWeights::BT709:
+		return {54, 183, 19, false};
+	default:
+		return {1, 1, 1, true};
+	}
+}
+
+// (r + g + b) * 21846 >> 16 equals (r + g + b) / 3 for all sums up to 765
+inline uint8_t ConvertPixel(const uint8_t r, const uint8_t g, const uint8_t b, const Weights &weights)
+{
+	if (weights.average)
+		return static_cast<uint8_t>(((r + g + b) * averageFactor) >> 16);
+	return static_cast<uint8_t>((r * weights.r + g * weights.g + b * weights.b + 128) >> 8);
+}
+
+#ifdef THUNDER_X86
+// Byte i of channel c is byte 3 i + c of the 48 interleaved bytes, the shuffle of part p gathers the bytes which lie
+// in the p-th 16 bytes and zeroes the others
+std::array<int8_t, 16> DeinterleaveMask(const int channel, const int part)
+{
+	std::array<int8_t, 16> mask;
+	for (int i = 0; i < 16; i++)
+	{
+		const int source = 3 * i + channel;
+		mask[i] = source / 16 == part ? static_cast<int8_t>(source % 16) : static_cast<int8_t>(-1);
+	}
+	return mask;
+}
+
+THUNDER_TARGET_SSE41 __m128i Convert16SSE41(const __m128i r, const __m128i g, const __m128i b, const Weights &weights)
+{
+	if (weights.average)
+		return _mm_mulhi_epu16(_mm_add_epi16(_mm_add_epi16(r, g), b), _mm_set1_epi16(static_cast<short>(averageFactor)));
+	const __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(weights.r)), _mm_mullo_epi16(g, _mm_set1_epi16(weights.g))),
+									  _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(weights.b)), _mm_set1_epi16(128)));
+	return _mm_srli_epi16(sum, 8);
+}
+
+THUNDER_TARGET_SSE41 size_t ConvertRowSSE41(const uint8_t *rgb, const size_t begin, const size_t width, uint8_t *grayscale, const Weights &weights)
+{
+	__m128i masks[3][3];
+	for (int channel = 0; channel < 3; channel++)
+	{
+		for (int part = 0; part < 3; part++)
+			masks[channel][part] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(DeinterleaveMask(channel, part).data()));
+	}
+
+	const __m128i zero = _mm_setzero_si128();
+	size_t x = begin;
+	for (; x + 16 <= width; x += 16)
+	{
+		const __m128i *pixels = reinterpret_cast<const __m128i *>(rgb + 3 * x);
+		const __m128i parts[3] = {_mm_loadu_si128(pixels), _mm_loadu_si128(pixels + 1), _mm_loadu_si128(pixels + 2)};
+		__m128i channels[3];
+		for (int channel = 0; channel < 3; channel++)
+		{
+			channels[channel] = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(parts[0], masks[channel][0]), _mm_shuffle_epi8(parts[1], masks[channel][1])),
+											 _mm_shuffle_epi8(parts[2], masks[channel][2]));
+		}
+
+		const __m128i low = Convert16SSE41(_mm_unpacklo_epi8(channels[0], zero), _mm_unpacklo_epi8(channels[1], zero), _mm_unpacklo_epi8(channels[2], zero), weights);
+		const __m128i high = Convert16SSE41(_mm_unpackhi_epi8(channels[0], zero), _mm_unpackhi_epi8(channels[1], zero), _mm_unpackhi_epi8(channels[2], zero), weights);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(grayscale + x), _mm_packus_epi16(low, high));
+	}
+	return x;
+}
+
+THUNDER_TARGET_AVX2 __m256i Convert16AVX2(const __m256i r, const __m256i g, const __m256i b, const Weights &weights)
+{
+	if (weights.average)
+		return _mm256_mulhi_epu16(_mm256_add_epi16(_mm256_add_epi16(r, g), b), _mm256_set1_epi16(static_cast<short>(averageFactor)));
+	const __m256i sum = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi16(weights.r)), _mm256_mullo_epi16(g, _mm256_set1_epi16(weights.g))),
+										 _mm256_add_epi16(_mm256_mullo_epi16(b, _mm256_set1_epi16(weights.b)), _mm256_set1_epi16(128)));
+	return _mm256_srli_epi16(sum, 8);
+}
+
+// The shuffles work within 128 bit lanes, so the lower lanes process pixels 0 - 15 and the upper lanes pixels 16 - 31
+THUNDER_TARGET_AVX2 size_t ConvertRowAVX2(const uint8_t *rgb, const size_t begin, const size_t width, uint8_t *grayscale, const Weights &weights)
+{
+	__m256i masks[3][3];
+	for (int channel = 0; channel < 3; channel++)
+	{
+		for (int part = 0; part < 3; part++)
+			masks[channel][part] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(DeinterleaveMask(channel, part).data())));
+	}
+
+	const __m256i zero = _mm256_setzero_si256();
+	size_t x = begin;
+	for (; x + 32 <= width; x += 32)
+	{
+		const __m128i *pixels = reinterpret_cast<const __m128i *>(rgb + 3 * x);
+		__m256i parts[3];
+		for (int part = 0; part < 3; part++)
+			parts[part] = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(pixels + part)), _mm_loadu_si128(pixels + 3 + part), 1);
+
+		__m256i channels[3];
+		for (int channel = 0; channel < 3; channel++)
+		{
+			channels[channel] = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(parts[0], masks[channel][0]), _mm256_shuffle_epi8(parts[1], masks[channel][1])),
+												_mm256_shuffle_epi8(parts[2], masks[channel][2]));
+		}
+
+		const __m256i low = Convert16AVX2(_mm256_unpacklo_epi8(channels[0], zero), _mm256_unpacklo_epi8(channels[1], zero), _mm256_unpacklo_epi8(channels[2], zero), weights);
+		const __m256i high = Convert16AVX2(_mm256_unpackhi_epi8(channels[0], zero), _mm256_unpackhi_epi8(channels[1], zero), _mm256_unpackhi_epi8(channels[2], zero), weights);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(grayscale + x), _mm256_packus_epi16(low, high));
+	}
+	return x;
+}
+#endif // THUNDER_X86
+
+void CheckImage(const ThunderVision::TensorView<const uint8_t> &rgb)
+{
+	if (rgb.GetRank() != 3 || (rgb.GetDimension(2) != 3 && rgb.GetDimension(2) != 4))
+		throw new ThunderVision::ThunderException("Only RGB and RGBA images (rank 3 tensors with 3 or 4 channels) can be converted to grayscale.");
+}
+} // namespace
+
+void ThunderVision::ColorspaceConversion::ConvertToGrayscale(const TensorView<const uint8_t> &rgb, Tensor<uint8_t> &grayscale, GrayscaleWeights weights, ThreadPool &pool, SimdLevel maxLevel)
+{
+	THUNDER_PROFILE_SCOPE("Grayscale");
+	CheckImage(rgb);
+	const size_t height = rgb.GetDimension(0);
+	const size_t width = rgb.GetDimension(1);
+	if (grayscale.GetDimensions() != std::vector<size_t>{height, width})
+		grayscale.Resize({height, width});
+
+	pool.ParallelFor(0, static_cast<int64_t>(height), [&](int64_t begin, int64_t end, size_t) {
+		for (int64_t y = begin; y < end; y++)
+		{
+			ConvertRowToGrayscale(rgb, static_cast<size_t>(y), grayscale.Data() + y * width, weights, maxLevel);
+		}
+	});
+}
+
+void ThunderVision::ColorspaceConversion::ConvertRowToGrayscale(const TensorView<const uint8_t> &rgb, size_t y, uint8_t *grayscale, GrayscaleWeights weights, SimdLevel maxLevel)
+{
+	CheckImage(rgb);
+	const size_t width = rgb.GetDimension(1);
+	const int64_t pixelStride = rgb.GetStride(1);
+	const int64_t channelStride = rgb.GetStride(2);
+	const uint8_t *row = rgb.Data() + static_cast<int64_t>(y) * rgb.GetStride(0);
+	const Weights fixedWeights = GetWeights(weights);
+
+	size_t x = 0;
+#ifdef THUNDER_X86
+	const SimdLevel level = std::min(GetSupportedSimdLevel(), maxLevel);
+	if (pixelStride == 3 && channelStride == 1 && level >= SimdLevel::SSE41)
+	{
+		if (level >= SimdLevel::AVX2)
+			x = ConvertRowAVX2(row, x, width, grayscale, fixedWeights);
+		x = ConvertRowSSE41(row, x, width, grayscale, fixedWeights);
+	}
+#else
+	(void)maxLevel;
+#endif
+
+	for (; x < width; x++)
+	{
+		const uint8_t *pixel = row + static_cast<int64_t>(x) * pixelStride;
+		grayscale[x] = ConvertPixel(pixel[0], pixel[channelStride], pixel[2 * channelStride], fixedWeights);
+	}
+}
@@ -0,0 +1,67 @@
+#include "DisparityRanges.h"
+
+#include <algorithm>
+
+void ThunderVision::DisparityRanges::Resize(const size_t width, const size_t height)
+{
+	_width = width;
+	_height = height;
+	if (_minima.GetDimensions() != std::vector<size_t>{height, width})
+	{
+		_minima.Resize({height, width});
+		_counts.Resize({height, width});
+		_offsets.Resize({height, width});
+	}
+	_totalSize = 0;
+	_maxCount = 0;
+}
+
+void ThunderVision::DisparityRanges::UpdateOffsets()
+{
+	size_t offset = 0;
+	size_t maxCount = 0;
+	for (size_t i = 0; i < _width * _height; i++)
+	{
+		const size_t count = PadCount(_counts[i]);
+		_offsets[i] = offset;
+		offset += count;
+		maxCount = std::max(maxCount, count);
+	}
+	_totalSize = offset;
+	_maxCount = maxCount;
+}
+
+size_t ThunderVision::DisparityRanges::GetWidth() const
+{
+	return _width;
+}
+
+size_t ThunderVision::DisparityRanges::GetHeight() const
+{
+	return _height;
+}
+
+size_t ThunderVision::DisparityRanges::GetTotalSize() const
+{
+	return _totalSize;
+}
+
+size_t ThunderVision::DisparityRanges::GetMaxCount() const
+{
+	return _maxCount;
+}
+
+const int32_t *ThunderVision::DisparityRanges::GetMinima() const
+{
+	return _minima.Data();
+}
+
+const uint16_t *ThunderVision::DisparityRanges::GetCounts() const
+{
+	return _counts.Data();
+}
+
+const size_t *ThunderVision::DisparityRanges::GetOffsets() const
+{
+	return _offsets.Data();
+}
@@ -0,0 +1,130 @@
+#include "HammingCostKernels.h"
+
+#include <algorithm>
+
+#include "ext/libpopcnt.h"
+
+namespace
+{
+void HammingForwardPortable(const uint64_t base, const uint64_t *vectors, const size_t count, uint16_t *costs)
+{
+	for (size_t d = 0; d < count; d++)
+	{
+		costs[d] = static_cast<uint16_t>(popcnt64(base ^ vectors[d]));
+	}
+}
+
+void HammingBackwardPortable(const uint64_t base, const uint64_t *vectors, const size_t count, uint16_t *costs)
+{
+	for (size_t d = 0; d < count; d++)
+	{
+		costs[d] = static_cast<uint16_t>(popcnt64(base ^ *(vectors - d)));
+	}
+}
+
+#ifdef THUNDER_X86
+// Counts the bits of each 64 bit lane: a shuffle looks up the counts of both nibbles of every byte and sad sums the
+// eight bytes of a lane.
+THUNDER_TARGET_AVX2 inline __m256i PopcountAVX2(const __m256i value)
+{
+	const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i lowMask = _mm256_set1_epi8(0x0F);
+	const __m256i low = _mm256_shuffle_epi8(lookup, _mm256_and_si256(value, lowMask));
+	const __m256i high = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(value, 4), lowMask));
+	return _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256());
+}
+
+// Packs the 64 bit counts of a, b, c and d in this order into 16 bit lanes. The packs work within 128 bit lanes,
+// the permutation restores the order of the 32 bit pairs.
+THUNDER_TARGET_AVX2 inline __m256i PackCountsAVX2(const __m256i a, const __m256i b, const __m256i c, const __m256i d)
+{
+	const __m256i packed = _mm256_packus_epi32(_mm256_packus_epi32(a, b), _mm256_packus_epi32(c, d));
+	return _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+}
+
+THUNDER_TARGET_AVX2 inline __m256i CountForwardAVX2(const __m256i base, const uint64_t *vectors)
+{
+	return PopcountAVX2(_mm256_xor_si256(base, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(vectors))));
+}
+
+// Loads vectors[-3] to vectors[0] in reversed order
+THUNDER_TARGET_AVX2 inline __m256i CountBackwardAVX2(const __m256i base, const uint64_t *vectors)
+{
+	const __m256i loaded = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(vectors - 3));
+	return PopcountAVX2(_mm256_xor_si256(base, _mm256_permute4x64_epi64(loaded, 0x1B)));
+}
+
+THUNDER_TARGET_AVX2 void HammingForwardAVX2(const uint64_t base, const uint64_t *vectors, const size_t count, uint16_t *costs)
+{
+	const __m256i baseVector = _mm256_set1_epi64x(static_cast<long long>(base));
+
+	size_t d = 0;
+	for (; d + 16 <= count; d += 16)
+	{
+		const uint64_t *run = vectors + d;
+		const __m256i distances = PackCountsAVX2(CountForwardAVX2(baseVector, run), CountForwardAVX2(baseVector, run + 4), CountForwardAVX2(baseVector, run + 8), CountForwardAVX2(baseVector, run + 12));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(costs + d), distances);
+	}
+	HammingForwardPortable(base, vectors + d, count - d, costs + d);
+}
+
+THUNDER_TARGET_AVX2 void HammingBackwardAVX2(const uint64_t base, const uint64_t *vectors, const size_t count, uint16_t *costs)
+{
+	const __m256i baseVector = _mm256_set1_epi64x(static_cast<long long>(base));
+
+	size_t d = 0;
+	for (; d + 16 <= count; d += 16)
+	{
+		const uint64_t *run = vectors - d;
+		const __m256i distances = PackCountsAVX2(CountBackwardAVX2(baseVector, run), CountBackwardAVX2(baseVector, run - 4), CountBackwardAVX2(baseVector, run - 8), CountBackwardAVX2(baseVector, run - 12));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(costs + d), distances);
+	}
+	HammingBackwardPortable(base, vectors - d, count - d, costs + d);
+}
+
+// The zero masked forms are used because GCC warns about the undefined source operand of the unmasked builtins
+THUNDER_TARGET_AVX512 void HammingForwardAVX512(const uint64_t base, const uint64_t *vectors, const size_t count, uint16_t *costs)
+{
+	const __m512i baseVector = _mm512_set1_epi64(static_cast<long long>(base));
+
+	size_t d = 0;
+	for (; d + 8 <= count; d += 8)
+	{
+		const __m512i distances = _mm512_popcnt_epi64(_mm512_xor_si512(baseVector, _mm512_loadu_si512(vectors + d)));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(costs + d), _mm512_maskz_cvtepi64_epi16(0xFF, distances));
+	}
+	HammingForwardPortable(base, vectors + d, count - d, costs + d);
+}
+
+THUNDER_TARGET_AVX512 void HammingBackwardAVX512(const uint64_t base, const uint64_t *vectors, const size_t count, uint16_t *costs)
+{
+	const __m512i baseVector = _mm512_set1_epi64(static_cast<long long>(base));
+	const __m512i reverse = _mm512_setr_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+
+	size_t d = 0;
+	for (; d + 8 <= count; d += 8)
+	{
+		const __m512i loaded = _mm512_maskz_permutexvar_epi64(0xFF, reverse, _mm512_loadu_si512(vectors - d - 7));
+		const __m512i distances = _mm512_popcnt_epi64(_mm512_xor_si512(baseVector, loaded));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(costs + d), _mm512_maskz_cvtepi64_epi16(0xFF, distances));
+	}
+	HammingBackwardPortable(base, vectors - d, count - d, costs + d);
+}
+#endif // THUNDER_X86
+} // namespace
+
+ThunderVision::HammingCostKernels ThunderVision::SelectHammingCostKernels(const SimdLevel maxLevel)
+{
+	const SimdLevel level = std::min(maxLevel, GetSupportedSimdLevel());
+#ifdef THUNDER_X86
+	if (level >= SimdLevel::AVX512)
+	{
+		return {HammingForwardAVX512, HammingBackwardAVX512, SimdLevel::AVX512};
+	}
+	if (level >= SimdLevel::AVX2)
+	{
+		return {HammingForwardAVX2, HammingBackwardAVX2, SimdLevel::AVX2};
+	}
+#endif
+	return {HammingForwardPortable, HammingBackwardPortable, SimdLevel::Portable};
+}
@@ -0,0 +1,73 @@
+#include "ImagePyramid.h"
+
+#include "Exceptions.h"
+
+template <typename T>
+ThunderVision::ImagePyramid<T>::ImagePyramid(const SimdLevel maxLevel)
+	: _resizing(maxLevel)
+{
+}
+
+template <typename T>
+void ThunderVision::ImagePyramid<T>::Build(const TensorView<const T> &image, const size_t nrLevels, ThreadPool &pool)
+{
+	if (image.GetRank() != 3 && image.GetRank() != 2)
+		throw new ThunderException("Only images (tensors with two or three dimensions) are supported");
+	if (nrLevels == 0)
+		throw new ThunderException("A pyramid needs at least one level");
+
+	_image = image;
+	_levels.resize(nrLevels - 1);
+	for (size_t level = 1; level < nrLevels; level++)
+	{
+		const TensorView<const T> previous = GetLevel(level - 1);
+		const size_t width = (previous.GetDimension(1) + 1) / 2;
+		const size_t height = (previous.GetDimension(0) + 1) / 2;
+		if (_sigma > 0.0)
+		{
+			const Tensor<T> smoothed = _gaussianBlur.ApplyGaussian(previous, _sigma);
+			_resizing.Resize(TensorView<const T>(smoothed), width, height, _levels[level - 1], ResizeMode::Area, pool);
+		}
+		else
+		{
+			_resizing.Resize(previous, width, height, _levels[level - 1], ResizeMode::Area, pool);
+		}
+	}
+}
+
+template <typename T>
+void ThunderVision::ImagePyramid<T>::SetSmoothing(const double sigma)
+{
+	_sigma = sigma;
+}
+
+template <typename T>
+double ThunderVision::ImagePyramid<T>::GetSmoothing() const
+{
+	return _sigma;
+}
+
+template <typename T>
+size_t ThunderVision::ImagePyramid<T>::GetNrLevels() const
+{
+	return _levels.size() + 1;
+}
+
+template <typename T>
+ThunderVision::TensorView<const T> ThunderVision::ImagePyramid<T>::GetLevel(const size_t level) const
+{
+	if (level == 0)
+		return _image;
+	if (level > _levels.size())
+		throw new ThunderException("The pyramid has less levels");
+
+	// The resized levels are always (height, width, channels)
+	const Tensor<T> &tensor = _levels[level - 1];
+	if (_image.GetRank() == 2)
+		return TensorView<const T>(tensor.Data(), {tensor.GetDimension(0), tensor.GetDimension(1)});
+	return TensorView<const T>(tensor);
+}
+
+template class ThunderVision::ImagePyramid<float>;
+template class ThunderVision::ImagePyramid<uint8_t>;
+template class ThunderVision::ImagePyramid<uint16_t>;
@@ -0,0 +1,199 @@
+#include "ImageResizing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Exceptions.h"
+#include "FilterUtil.h"
+
+namespace
+{
+// An interval of length scale overlaps at most ceil(scale) + 1 pixels
+size_t MaxTaps(const size_t inputSize, const size_t outputSize, const ThunderVision::ResizeMode mode)
+{
+	if (mode == ThunderVision::ResizeMode::Bilinear)
+		return 2;
+	return static_cast<size_t>(std::ceil(static_cast<double>(inputSize) / static_cast<double>(outputSize))) + 1;
+}
+
+/**
+* Calls set(output, tap, source, weight) for the taps of every output index and returns the number of taps, unused
+* taps repeat the first source index with weight 0.
+*/
+template <typename TSet>
+size_t ComputeTaps(const size_t inputSize, const size_t outputSize, const ThunderVision::ResizeMode mode, TSet set)
+{
+	const double scale = static_cast<double>(inputSize) / static_cast<double>(outputSize);
+	const int64_t last = static_cast<int64_t>(inputSize) - 1;
+
+	if (mode == ThunderVision::ResizeMode::Bilinear)
+	{
+		for (size_t o = 0; o < outputSize; o++)
+		{
+			const double position = scale * static_cast<double>(o);
+			const int64_t first = std::min(static_cast<int64_t>(position), last);
+			const double fraction = std::min(position - static_cast<double>(first), 1.0);
+			set(o, 0, first, static_cast<float>(1.0 - fraction));
+			set(o, 1, std::min(first + 1, last), static_cast<float>(fraction));
+		}
+		return 2;
+	}
+
+	const size_t taps = MaxTaps(inputSize, outputSize, mode);
+	for (size_t o = 0; o < outputSize; o++)
+	{
+		const double begin = scale * static_cast<double>(o);
+		const double end = std::min(scale * static_cast<double>(o + 1), static_cast<double>(inputSize));
+		const int64_t first = std::min(static_cast<int64_t>(begin), last);
+		size_t k = 0;
+		for (int64_t i = first; i <= last && static_cast<double>(i) < end && k < taps; i++, k++)
+		{
+			const double coverage = std::min(end, static_cast<double>(i + 1)) - std::max(begin, static_cast<double>(i));
+			set(o, k, i, static_cast<float>(coverage / (end - begin)));
+		}
+		for (; k < taps; k++)
+		{
+			set(o, k, first, 0.0f);
+		}
+	}
+	return taps;
+}
+
+template <typename T>
+void Reserve(ThunderVision::Tensor<T> &tensor, const std::vector<size_t> &dimensions)
+{
+	if (tensor.GetDimensions() != dimensions)
+		tensor.Resize(dimensions);
+}
+} // namespace
+
+ThunderVision::ImageResizing::ImageResizing(const SimdLevel maxLevel)
+{
+	_kernels = SelectSeparableFilterKernels(maxLevel);
+}
+
+template <typename TIn, typename TOut>
+void ThunderVision::ImageResizing::Resize(const TensorView<const TIn> &input, const size_t outputWidth, const size_t outputHeight, Tensor<TOut> &output,
+										  const ResizeMode mode, ThreadPool &pool)
+{
+	if (input.GetRank() != 3 && input.GetRank() != 2)
+		throw new ThunderException("Only images (tensors with two or three dimensions) are supported");
+
+	const size_t height = input.GetDimension(0);
+	const size_t width = input.GetDimension(1);
+	const size_t channels = input.GetRank() == 3 ? input.GetDimension(2) : 1;
+	const std::vector<size_t> outputDimensions = {outputHeight, outputWidth, channels};
+	if (output.GetDimensions() != outputDimensions)
+		output.Resize(outputDimensions);
+	if (output.GetTotalSize() == 0)
+		return;
+	if (width == 0 || height == 0)
+		throw new ThunderException("Can not resize an empty image");
+
+	const int64_t strideY = input.GetStride(0);
+	const int64_t strideX = input.GetStride(1);
+	const int64_t strideC = input.GetRank() == 3 ? input.GetStride(2) : 0;
+	const size_t rowLength = width * channels;
+	const size_t outputRowLength = outputWidth * channels;
+
+	// Columns are stored planar by tap for the gather kernel, rows interleaved as the weights of one output row
+	const size_t maxTapsX = MaxTaps(width, outputWidth, mode);
+	const size_t maxTapsY = MaxTaps(height, outputHeight, mode);
+	Reserve(_columnIndices, {maxTapsX * outputRowLength});
+	Reserve(_columnWeights, {maxTapsX * outputRowLength});
+	Reserve(_rowIndices, {outputHeight * maxTapsY});
+	Reserve(_rowWeights, {outputHeight * maxTapsY});
+
+	int32_t *columnIndices = _columnIndices.Data();
+	float *columnWeights = _columnWeights.Data();
+	const size_t tapsX = ComputeTaps(width, outputWidth, mode, [&](size_t x, size_t k, int64_t source, float weight) {
+		for (size_t c = 0; c < channels; c++)
+		{
+			columnIndices[k * outputRowLength + x * channels + c] = static_cast<int32_t>(source * static_cast<int64_t>(channels) + static_cast<int64_t>(c));
+			columnWeights[k * outputRowLength + x * channels + c] = weight;
+		}
+	});
+	int32_t *rowIndices = _rowIndices.Data();
+	float *rowWeights = _rowWeights.Data();
+	const size_t tapsY = ComputeTaps(height, outputHeight, mode, [&](size_t y, size_t k, int64_t source, float weight) {
+		rowIndices[y * maxTapsY + k] = static_cast<int32_t>(source);
+		rowWeights[y * maxTapsY + k] = weight;
+	});
+
+	// Contiguous float rows are blended in place, other inputs are converted row by row
+	const bool direct = std::is_same<TIn, float>::value && strideC == 1 && strideX == static_cast<int64_t>(channels);
+	const size_t blockAlignment = TensorAlignment / sizeof(float);
+	const size_t perThread = ((direct ? 0 : tapsY * rowLength) + rowLength + outputRowLength + blockAlignment - 1) / blockAlignment * blockAlignment;
+	Reserve(_buffer, {pool.GetNrThreads(), perThread});
+
+	const SeparableFilterKernels kernels = _kernels;
+	pool.ParallelFor(0, static_cast<int64_t>(outputHeight), [&](int64_t yBegin, int64_t yEnd, size_t threadIndex) {
+		float *converted = _buffer.Data() + threadIndex * perThread;
+		float *blended = converted + (direct ? 0 : tapsY * rowLength);
+		float *scratch = blended + rowLength;
+		std::vector<const float *> rows(tapsY);
+		// Source row in each conversion slot, upscaled rows reuse the rows of the previous output row
+		std::vector<int32_t> convertedRows(tapsY, -1);
+
+		for (int64_t y = yBegin; y < yEnd; y++)
+		{
+			for (size_t k = 0; k < tapsY; k++)
+			{
+				const int32_t sourceRow = rowIndices[y * maxTapsY + k];
+				const TIn *source = input.Data() + sourceRow * strideY;
+				if constexpr (std::is_same<TIn, float>::value)
+				{
+					if (direct)
+					{
+						rows[k] = source;
+						continue;
+					}
+				}
+				float *row = converted + k * rowLength;
+				rows[k] = row;
+				if (convertedRows[k] == sourceRow)
+					continue;
+				convertedRows[k] = sourceRow;
+				if (strideC == 1 && strideX == static_cast<int64_t>(channels))
+				{
+					std::copy(source, source + rowLength, row);
+					continue;
+				}
+				for (size_t x = 0; x < width; x++)
+				{
+					for (size_t c = 0; c < channels; c++)
+					{
+						row[x * channels + c] = static_cast<float>(source[static_cast<int64_t>(x) * strideX + static_cast<int64_t>(c) * strideC]);
+					}
+				}
+			}
+
+			kernels.verticalFloat(rows.data(), rowWeights + y * maxTapsY, tapsY, rowLength, blended);
+
+			TOut *out = output.Data() + y * outputRowLength;
+			if constexpr (std::is_same<TOut, float>::value)
+			{
+				kernels.resample(blended, columnIndices, columnWeights, tapsX, outputRowLength, out);
+			}
+			else
+			{
+				kernels.resample(blended, columnIndices, columnWeights, tapsX, outputRowLength, scratch);
+				FilterUtil::RoundAndSaturate(kernels, scratch, outputRowLength, out);
+			}
+		}
+	});
+}
+
+#define THUNDER_IMAGE_RESIZING_INSTANTIATE(TIn, TOut)                                                                                                        \
+	template void ThunderVision::ImageResizing::Resize<TIn, TOut>(const TensorView<const TIn> &, const size_t, const size_t, Tensor<TOut> &, const ResizeMode, \
+																  ThreadPool &);
+
+#define THUNDER_IMAGE_RESIZING_INSTANTIATE_OUTPUTS(TIn) \
+	THUNDER_IMAGE_RESIZING_INSTANTIATE(TIn, float)      \
+	THUNDER_IMAGE_RESIZING_INSTANTIATE(TIn, uint8_t)    \
+	THUNDER_IMAGE_RESIZING_INSTANTIATE(TIn, uint16_t)
+
+THUNDER_IMAGE_RESIZING_INSTANTIATE_OUTPUTS(float)
+THUNDER_IMAGE_RESIZING_INSTANTIATE_OUTPUTS(uint8_t)
+THUNDER_IMAGE_RESIZING_INSTANTIATE_OUTPUTS(uint16_t)
@@ -0,0 +1,442 @@
+#include "MedianKernels.h"
+
+#include <algorithm>
+#include <array>
+
+#include "Tensor.h"
+
+// Devillard's exchange network for the median of 25 elements, SORT(a, b) orders p[a] <= p[b]. Afterwards p[12] holds
+// the median, exchanges which do not contribute to it are removed by the compiler.
+#define THUNDER_MEDIAN25_NETWORK(SORT)                                                                                                \
+	SORT(0, 1) SORT(3, 4) SORT(2, 4) SORT(2, 3) SORT(6, 7) SORT(5, 7) SORT(5, 6) SORT(9, 10) SORT(8, 10) SORT(8, 9)                  \
+	SORT(12, 13) SORT(11, 13) SORT(11, 12) SORT(15, 16) SORT(14, 16) SORT(14, 15) SORT(18, 19) SORT(17, 19) SORT(17, 18)             \
+	SORT(21, 22) SORT(20, 22) SORT(20, 21) SORT(23, 24) SORT(2, 5) SORT(3, 6) SORT(0, 6) SORT(0, 3) SORT(4, 7) SORT(1, 7)            \
+	SORT(1, 4) SORT(11, 14) SORT(8, 14) SORT(8, 11) SORT(12, 15) SORT(9, 15) SORT(9, 12) SORT(13, 16) SORT(10, 16)                   \
+	SORT(10, 13) SORT(20, 23) SORT(17, 23) SORT(17, 20) SORT(21, 24) SORT(18, 24) SORT(18, 21) SORT(19, 22) SORT(8, 17)              \
+	SORT(9, 18) SORT(0, 18) SORT(0, 9) SORT(10, 19) SORT(1, 19) SORT(1, 10) SORT(11, 20) SORT(2, 20) SORT(2, 11)                     \
+	SORT(12, 21) SORT(3, 21) SORT(3, 12) SORT(13, 22) SORT(4, 22) SORT(4, 13) SORT(14, 23) SORT(5, 23) SORT(5, 14)                   \
+	SORT(15, 24) SORT(6, 24) SORT(6, 15) SORT(7, 16) SORT(7, 19) SORT(13, 21) SORT(15, 23) SORT(7, 13) SORT(7, 15)                   \
+	SORT(1, 9) SORT(3, 11) SORT(5, 17) SORT(11, 17) SORT(9, 17) SORT(4, 10) SORT(6, 12) SORT(7, 14) SORT(4, 6) SORT(4, 7)            \
+	SORT(12, 14) SORT(10, 14) SORT(6, 7) SORT(10, 12) SORT(6, 10) SORT(6, 17) SORT(12, 17) SORT(7, 17) SORT(7, 10)                   \
+	SORT(12, 18) SORT(7, 12) SORT(10, 18) SORT(12, 20) SORT(10, 20) SORT(10, 12)
+
+namespace
+{
+template <typename T>
+inline void SortColumn3(const T a, const T b, const T c, T &low, T &middle, T &high)
+{
+	const T minimumAB = std::min(a, b);
+	const T maximumAB = std::max(a, b);
+	low = std::min(minimumAB, c);
+	high = std::max(maximumAB, c);
+	middle = std::max(minimumAB, std::min(maximumAB, c));
+}
+
+template <typename T>
+inline T Median3(const T a, const T b, const T c)
+{
+	return std::max(std::min(a, b), std::min(std::max(a, b), c));
+}
+
+template <typename T>
+inline T MedianOfSortedColumns(const T *low, const T *middle, const T *high)
+{
+	const T lowMax = std::max(std::max(low[0], low[1]), low[2]);
+	const T highMin = std::min(std::min(high[0], high[1]), high[2]);
+	return Median3(lowMax, Median3(middle[0], middle[1], middle[2]), highMin);
+}
+
+template <typename T>
+inline T MedianOf25(const T *const *rows, const size_t x)
+{
+	T p[25];
+	for (size_t y = 0; y < 5; y++)
+	{
+		for (size_t i = 0; i < 5; i++)
+		{
+			p[y * 5 + i] = rows[y][x + i];
+		}
+	}
+
+#define THUNDER_MEDIAN_SCALAR_SORT(a, b)                 \
+	{                                                    \
+		const T minimum = std::min(p[a], p[b]);          \
+		p[b] = std::max(p[a], p[b]);                     \
+		p[a] = minimum;                                  \
+	}
+	THUNDER_MEDIAN25_NETWORK(THUNDER_MEDIAN_SCALAR_SORT)
+#undef THUNDER_MEDIAN_SCALAR_SORT
+
+	return p[12];
+}
+
+namespace Portable
+{
+template <typename T>
+struct Ops
+{
+	using Vector = T;
+	static constexpr size_t Width = 1;
+	static inline Vector Load(const T *p) { return *p; }
+	static inline void Store(T *p, const Vector v) { *p = v; }
+	static inline Vector Min(const Vector a, const Vector b) { return std::min(a, b); }
+	static inline Vector Max(const Vector a, const Vector b) { return std::max(a, b); }
+};
+
+#define THUNDER_MEDIAN_TARGET
+#include "MedianNetworks.inl"
+#undef THUNDER_MEDIAN_TARGET
+} // namespace Portable
+
+#ifdef THUNDER_X86
+namespace SSE41
+{
+template <typename T>
+struct Ops;
+
+template <>
+struct Ops<float>
+{
+	using Vector = __m128;
+	static constexpr size_t Width = 4;
+	THUNDER_TARGET_SSE41 static inline Vector Load(const float *p) { return _mm_loadu_ps(p); }
+	THUNDER_TARGET_SSE41 static inline void Store(float *p, const Vector v) { _mm_storeu_ps(p, v); }
+	THUNDER_TARGET_SSE41 static inline Vector Min(const Vector a, const Vector b) { return _mm_min_ps(a, b); }
+	THUNDER_TARGET_SSE41 static inline Vector Max(const Vector a, const Vector b) { return _mm_max_ps(a, b); }
+};
+
+template <>
+struct Ops<uint8_t>
+{
+	using Vector = __m128i;
+	static constexpr size_t Width = 16;
+	THUNDER_TARGET_SSE41 static inline Vector Load(const uint8_t *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+	THUNDER_TARGET_SSE41 static inline void Store(uint8_t *p, const Vector v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+	THUNDER_TARGET_SSE41 static inline Vector Min(const Vector a, const Vector b) { return _mm_min_epu8(a, b); }
+	THUNDER_TARGET_SSE41 static inline Vector Max(const Vector a, const Vector b) { return _mm_max_epu8(a, b); }
+};
+
+template <>
+struct Ops<uint16_t>
+{
+	using Vector = __m128i;
+	static constexpr size_t Width = 8;
+	THUNDER_TARGET_SSE41 static inline Vector Load(const uint16_t *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+	THUNDER_TARGET_SSE41 static inline void Store(uint16_t *p, const Vector v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+	THUNDER_TARGET_SSE41 static inline Vector Min(const Vector a, const Vector b) { return _mm_min_epu16(a, b); }
+	THUNDER_TARGET_SSE41 static inline Vector Max(const Vector a, const Vector b) { return _mm_max_epu16(a, b); }
+};
+
+#define THUNDER_MEDIAN_TARGET THUNDER_TARGET_SSE41
+#include "MedianNetworks.inl"
+#undef THUNDER_MEDIAN_TARGET
+} // namespace SSE41
+
+namespace AVX2
+{
+template <typename T>
+struct Ops;
+
+template <>
+struct Ops<float>
+{
+	using Vector = __m256;
+	static constexpr size_t Width = 8;
+	THUNDER_TARGET_AVX2 static inline Vector Load(const float *p) { return _mm256_loadu_ps(p); }
+	THUNDER_TARGET_AVX2 static inline void Store(float *p, const Vector v) { _mm256_storeu_ps(p, v); }
+	THUNDER_TARGET_AVX2 static inline Vector Min(const Vector a, const Vector b) { return _mm256_min_ps(a, b); }
+	THUNDER_TARGET_AVX2 static inline Vector Max(const Vector a, const Vector b) { return _mm256_max_ps(a, b); }
+};
+
+template <>
+struct Ops<uint8_t>
+{
+	using Vector = __m256i;
+	static constexpr size_t Width = 32;
+	THUNDER_TARGET_AVX2 static inline Vector Load(const uint8_t *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+	THUNDER_TARGET_AVX2 static inline void Store(uint8_t *p, const Vector v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+	THUNDER_TARGET_AVX2 static inline Vector Min(const Vector a, const Vector b) { return _mm256_min_epu8(a, b); }
+	THUNDER_TARGET_AVX2 static inline Vector Max(const Vector a, const Vector b) { return _mm256_max_epu8(a, b); }
+};
+
+template <>
+struct Ops<uint16_t>
+{
+	using Vector = __m256i;
+	static constexpr size_t Width = 16;
+	THUNDER_TARGET_AVX2 static inline Vector Load(const uint16_t *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+	THUNDER_TARGET_AVX2 static inline void Store(uint16_t *p, const Vector v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+	THUNDER_TARGET_AVX2 static inline Vector Min(const Vector a, const Vector b) { return _mm256_min_epu16(a, b); }
+	THUNDER_TARGET_AVX2 static inline Vector Max(const Vector a, const Vector b) { return _mm256_max_epu16(a, b); }
+};
+
+#define THUNDER_MEDIAN_TARGET THUNDER_TARGET_AVX2
+#include "MedianNetworks.inl"
+#undef THUNDER_MEDIAN_TARGET
+} // namespace AVX2
+
+namespace AVX512
+{
+template <typename T>
+struct Ops;
+
+template <>
+struct Ops<float>
+{
+	using Vector = __m512;
+	static constexpr size_t Width = 16;
+	THUNDER_TARGET_AVX512 static inline Vector Load(const float *p) { return _mm512_loadu_ps(p); }
+	THUNDER_TARGET_AVX512 static inline void Store(float *p, const Vector v) { _mm512_storeu_ps(p, v); }
+	THUNDER_TARGET_AVX512 static inline Vector Min(const Vector a, const Vector b) { return _mm512_mask_min_ps(a, 0xFFFF, a, b); }
+	THUNDER_TARGET_AVX512 static inline Vector Max(const Vector a, const Vector b) { return _mm512_mask_max_ps(a, 0xFFFF, a, b); }
+};
+
+template <>
+struct Ops<uint8_t>
+{
+	using Vector = __m512i;
+	static constexpr size_t Width = 64;
+	THUNDER_TARGET_AVX512 static inline Vector Load(const uint8_t *p) { return _mm512_loadu_si512(p); }
+	THUNDER_TARGET_AVX512 static inline void Store(uint8_t *p, const Vector v) { _mm512_storeu_si512(p, v); }
+	THUNDER_TARGET_AVX512 static inline Vector Min(const Vector a, const Vector b) { return _mm512_min_epu8(a, b); }
+	THUNDER_TARGET_AVX512 static inline Vector Max(const Vector a, const Vector b) { return _mm512_max_epu8(a, b); }
+};
+
+template <>
+struct Ops<uint16_t>
+{
+	using Vector = __m512i;
+	static constexpr size_t Width = 32;
+	THUNDER_TARGET_AVX512 static inline Vector Load(const uint16_t *p) { return _mm512_loadu_si512(p); }
+	THUNDER_TARGET_AVX512 static inline void Store(uint16_t *p, const Vector v) { _mm512_storeu_si512(p, v); }
+	THUNDER_TARGET_AVX512 static inline Vector Min(const Vector a, const Vector b) { return _mm512_min_epu16(a, b); }
+	THUNDER_TARGET_AVX512 static inline Vector Max(const Vector a, const Vector b) { return _mm512_max_epu16(a, b); }
+};
+
+#define THUNDER_MEDIAN_TARGET THUNDER_TARGET_AVX512
+#include "MedianNetworks.inl"
+#undef THUNDER_MEDIAN_TARGET
+} // namespace AVX512
+#endif // THUNDER_X86
+
+template <typename T>
+using MedianRowKernel = void (*)(const T *const *rows, const size_t count, T *medians);
+
+template <typename T>
+MedianRowKernel<T> SelectMedianRowKernel(const size_t radius, const ThunderVision::SimdLevel level)
+{
+#ifdef THUNDER_X86
+	if (level >= ThunderVision::SimdLevel::AVX512)
+		return radius == 1 ? AVX512::MedianRow3x3<AVX512::Ops<T>, T> : AVX512::MedianRow5x5<AVX512::Ops<T>, T>;
+	if (level >= ThunderVision::SimdLevel::AVX2)
+		return radius == 1 ? AVX2::MedianRow3x3<AVX2::Ops<T>, T> : AVX2::MedianRow5x5<AVX2::Ops<T>, T>;
+	if (level >= ThunderVision::SimdLevel::SSE41)
+		return radius == 1 ? SSE41::MedianRow3x3<SSE41::Ops<T>, T> : SSE41::MedianRow5x5<SSE41::Ops<T>, T>;
+#endif
+	return radius == 1 ? Portable::MedianRow3x3<Portable::Ops<T>, T> : Portable::MedianRow5x5<Portable::Ops<T>, T>;
+}
+
+// Perreault and Hebert, "Median Filtering in Constant Time". Every column keeps a histogram of the 2 radiusY + 1 pixels
+// around the current row, the window histogram is updated by adding the column entering and subtracting the column
+// leaving the window. The histograms have 16 coarse bins (upper nibble) and 256 fine bins. The fine bins of the window
+// are only updated for the coarse bin which contains the median, lazily from the column where they were last valid.
+void MedianHistogram8(const uint8_t *image, const int64_t rowStride, const size_t radiusX, const size_t radiusY, const size_t xBegin, const size_t xEnd,
+					  const size_t yBegin, const size_t yEnd, uint8_t *medians, const int64_t medianRowStride)
+{
+	const size_t windowWidth = 2 * radiusX + 1;
+	const size_t firstColumn = xBegin - radiusX;
+	const size_t nrColumns = xEnd - xBegin + 2 * radiusX;
+	const size_t rank = (windowWidth * (2 * radiusY + 1) - 1) / 2;
+	const size_t never = SIZE_MAX;
+
+	ThunderVision::Tensor<uint16_t> coarseColumns({nrColumns, 16});
+	ThunderVision::Tensor<uint16_t> fineColumns({nrColumns, 256});
+	auto updateColumns = [&](const size_t y, const int delta) {
+		const uint8_t *row = image + static_cast<int64_t>(y) * rowStride + firstColumn;
+		for (size_t c = 0; c < nrColumns; c++)
+		{
+			coarseColumns[c * 16 + (row[c] >> 4)] += static_cast<uint16_t>(delta);
+			fineColumns[c * 256 + row[c]] += static_cast<uint16_t>(delta);
+		}
+	};
+
+	for (size_t y = yBegin - radiusY; y < yBegin + radiusY; y++)
+	{
+		updateColumns(y, 1);
+	}
+
+	for (size_t y = yBegin; y < yEnd; y++)
+	{
+		updateColumns(y + radiusY, 1);
+		if (y > yBegin)
+			updateColumns(y - radiusY - 1, -1);
+
+		std::array<uint16_t, 16> coarse{};
+		std::array<uint16_t, 256> fine;
+		std::array<size_t, 16> updated;
+		updated.fill(never);
+		for (size_t c = 0; c < windowWidth; c++)
+		{
+			for (size_t bin = 0; bin < 16; bin++)
+			{
+				coarse[bin] += coarseColumns[c * 16 + bin];
+			}
+		}
+
+		uint8_t *medianRow = medians + static_cast<int64_t>(y) * medianRowStride;
+		for (size_t x = xBegin; x < xEnd; x++)
+		{
+			// The window covers the columns [i, i + windowWidth)
+			const size_t i = x - xBegin;
+			if (i > 0)
+			{
+				const uint16_t *entering = coarseColumns.Data() + (i + windowWidth - 1) * 16;
+				const uint16_t *leaving = coarseColumns.Data() + (i - 1) * 16;
+				for (size_t bin = 0; bin < 16; bin++)
+				{
+					coarse[bin] = static_cast<uint16_t>(coarse[bin] + entering[bin] - leaving[bin]);
+				}
+			}
+
+			size_t sum = 0;
+			size_t bin = 0;
+			while (sum + coarse[bin] <= rank)
+			{
+				sum += coarse[bin++];
+			}
+
+			uint16_t *segment = fine.data() + bin * 16;
+			if (updated[bin] == never || i - updated[bin] >= windowWidth)
+			{
+				std::fill(segment, segment + 16, static_cast<uint16_t>(0));
+				for (size_t c = i; c < i + windowWidth; c++)
+				{
+					const uint16_t *column = fineColumns.Data() + c * 256 + bin * 16;
+					for (size_t k = 0; k < 16; k++)
+					{
+						segment[k] += column[k];
+					}
+				}
+			}
+			else
+			{
+				for (size_t j = updated[bin] + 1; j <= i; j++)
+				{
+					const uint16_t *entering = fineColumns.Data() + (j + windowWidth - 1) * 256 + bin * 16;
+					const uint16_t *leaving = fineColumns.Data() + (j - 1) * 256 + bin * 16;
+					for (size_t k = 0; k < 16; k++)
+					{
+						segment[k] = static_cast<uint16_t>(segment[k] + entering[k] - leaving[k]);
+					}
+				}
+			}
+			updated[bin] = i;
+
+			size_t k = 0;
+			while (sum + segment[k] <= rank)
+			{
+				sum += segment[k++];
+			}
+			medianRow[x] = static_cast<uint8_t>(bin * 16 + k);
+		}
+	}
+}
+
+// A constant time histogram per column would need 65536 bins per column for 16 bit data. Instead a single window
+// histogram with 256 coarse and 65536 fine bins slides along each row (Huang), which costs O(radiusY) per pixel.
+void MedianHistogram16(const uint16_t *image, const int64_t rowStride, const size_t radiusX, const size_t radiusY, const size_t xBegin, const size_t xEnd,
+					   const size_t yBegin, const size_t yEnd, uint16_t *medians, const int64_t medianRowStride)
+{
+	const size_t windowHeight = 2 * radiusY + 1;
+	const size_t rank = ((2 * radiusX + 1) * windowHeight - 1) / 2;
+
+	ThunderVision::Tensor<uint16_t> fine({65536});
+	std::array<uint32_t, 256> coarse{};
+
+	for (size_t y = yBegin; y < yEnd; y++)
+	{
+		const uint16_t *windowTop = image + static_cast<int64_t>(y - radiusY) * rowStride;
+		auto updateColumn = [&](const size_t x, const int delta) {
+			const uint16_t *pixel = windowTop + x;
+			for (size_t j = 0; j < windowHeight; j++, pixel += rowStride)
+			{
+				coarse[*pixel >> 8] += delta;
+				fine[*pixel] += static_cast<uint16_t>(delta);
+			}
+		};
+
+		for (size_t x = xBegin - radiusX; x < xBegin + radiusX; x++)
+		{
+			updateColumn(x, 1);
+		}
+
+		uint16_t *medianRow = medians + static_cast<int64_t>(y) * medianRowStride;
+		for (size_t x = xBegin; x < xEnd; x++)
+		{
+			updateColumn(x + radiusX, 1);
+			if (x > xBegin)
+				updateColumn(x - radiusX - 1, -1);
+
+			size_t sum = 0;
+			size_t bin = 0;
+			while (sum + coarse[bin] <= rank)
+			{
+				sum += coarse[bin++];
+			}
+			size_t value = bin * 256;
+			while (sum + fine[value] <= rank)
+			{
+				sum += fine[value++];
+			}
+			medianRow[x] = static_cast<uint16_t>(value);
+		}
+
+		// Empties the histograms for the next row
+		for (size_t x = xEnd - 1 - radiusX; x <= xEnd - 1 + radiusX; x++)
+		{
+			updateColumn(x, -1);
+		}
+	}
+}
+} // namespace
+
+template <typename T>
+bool ThunderVision::ComputeMedians(const T *image, const int64_t rowStride, const size_t radiusX, const size_t radiusY, const size_t xBegin, const size_t xEnd,
+								   const size_t yBegin, const size_t yEnd, T *medians, const int64_t medianRowStride, ThreadPool &pool, const SimdLevel maxLevel)
+{
+	const bool network = radiusX == radiusY && (radiusX == 1 || radiusX == 2);
+	const bool histogram = !std::is_same<T, float>::value && (2 * radiusX + 1) * (2 * radiusY + 1) <= UINT16_MAX;
+	if (!network && !histogram)
+		return false;
+	if (xEnd <= xBegin || yEnd <= yBegin)
+		return true;
+
+	if (network)
+	{
+		const MedianRowKernel<T> kernel = SelectMedianRowKernel<T>(radiusX, std::min(maxLevel, GetSupportedSimdLevel()));
+		pool.ParallelFor(static_cast<int64_t>(yBegin), static_cast<int64_t>(yEnd), [&](int64_t begin, int64_t end, size_t) {
+			const T *rows[5];
+			for (int64_t y = begin; y < end; y++)
+			{
+				for (size_t i = 0; i < 2 * radiusY + 1; i++)
+				{
+					rows[i] = image + (y - static_cast<int64_t>(radiusY) + static_cast<int64_t>(i)) * rowStride + static_cast<int64_t>(xBegin - radiusX);
+				}
+				kernel(rows, xEnd - xBegin, medians + y * medianRowStride + static_cast<int64_t>(xBegin));
+			}
+		});
+		return true;
+	}
+
+	pool.ParallelFor(static_cast<int64_t>(yBegin), static_cast<int64_t>(yEnd), [&](int64_t begin, int64_t end, size_t) {
+		if constexpr (std::is_same<T, uint8_t>::value)
+			MedianHistogram8(image, rowStride, radiusX, radiusY, xBegin, xEnd, static_cast<size_t>(begin), static_cast<size_t>(end), medians, medianRowStride);
+		else if constexpr (std::is_same<T, uint16_t>::value)
+			MedianHistogram16(image, rowStride, radiusX, radiusY, xBegin, xEnd, static_cast<size_t>(begin), static_cast<size_t>(end), medians, medianRowStride);
+	});
+	return true;
+}
+
+template bool ThunderVision::ComputeMedians<float>(const float *, const int64_t, const size_t, const size_t, const size_t, const size_t, const size_t, const size_t, float *, const int64_t, ThreadPool &, const SimdLevel);
+template bool ThunderVision::ComputeMedians<uint8_t>(const uint8_t *, const int64_t, const size_t, const size_t, const size_t, const size_t, const size_t, const size_t, uint8_t *, const int64_t, ThreadPool &, const SimdLevel);
+template bool ThunderVision::ComputeMedians<uint16_t>(const uint16_t *, const int64_t, const size_t, const size_t, const size_t, const size_t, const size_t, const size_t, uint16_t *, const int64_t, ThreadPool &, const SimdLevel);
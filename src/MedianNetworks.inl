@@ -0,0 +1,100 @@
+// Sorting network median kernels. MedianKernels.cpp includes this file once per instruction set, with
+// THUNDER_MEDIAN_TARGET set to the target attribute of the instruction set. Ops provides the vector type, its Width
+// and Load, Store, Min and Max.
+
+template <typename Ops>
+THUNDER_MEDIAN_TARGET inline void Sort(typename Ops::Vector &a, typename Ops::Vector &b)
+{
+	const typename Ops::Vector minimum = Ops::Min(a, b);
+	b = Ops::Max(a, b);
+	a = minimum;
+}
+
+template <typename Ops>
+THUNDER_MEDIAN_TARGET inline typename Ops::Vector Median3(typename Ops::Vector a, typename Ops::Vector b, const typename Ops::Vector c)
+{
+	Sort<Ops>(a, b);
+	return Ops::Max(a, Ops::Min(b, c));
+}
+
+// The median of a 3x3 window is the median of the largest minimum, the median of the medians and the smallest
+// maximum of its sorted columns. Every column is sorted once and used by three windows.
+template <typename Ops, typename T>
+THUNDER_MEDIAN_TARGET void MedianRow3x3(const T *const *rows, const size_t count, T *medians)
+{
+	using Vector = typename Ops::Vector;
+	constexpr size_t width = Ops::Width;
+	constexpr size_t blockSize = 256;
+
+	T low[blockSize + 2];
+	T middle[blockSize + 2];
+	T high[blockSize + 2];
+
+	for (size_t begin = 0; begin < count; begin += blockSize)
+	{
+		const size_t nrMedians = std::min(blockSize, count - begin);
+		const size_t nrColumns = nrMedians + 2;
+
+		size_t c = 0;
+		for (; c + width <= nrColumns; c += width)
+		{
+			Vector a = Ops::Load(rows[0] + begin + c);
+			Vector b = Ops::Load(rows[1] + begin + c);
+			Vector d = Ops::Load(rows[2] + begin + c);
+			Sort<Ops>(a, b);
+			Sort<Ops>(b, d);
+			Sort<Ops>(a, b);
+			Ops::Store(low + c, a);
+			Ops::Store(middle + c, b);
+			Ops::Store(high + c, d);
+		}
+		for (; c < nrColumns; c++)
+		{
+			SortColumn3(rows[0][begin + c], rows[1][begin + c], rows[2][begin + c], low[c], middle[c], high[c]);
+		}
+
+		size_t x = 0;
+		for (; x + width <= nrMedians; x += width)
+		{
+			const Vector lowMax = Ops::Max(Ops::Max(Ops::Load(low + x), Ops::Load(low + x + 1)), Ops::Load(low + x + 2));
+			const Vector middleMedian = Median3<Ops>(Ops::Load(middle + x), Ops::Load(middle + x + 1), Ops::Load(middle + x + 2));
+			const Vector highMin = Ops::Min(Ops::Min(Ops::Load(high + x), Ops::Load(high + x + 1)), Ops::Load(high + x + 2));
+			Ops::Store(medians + begin + x, Median3<Ops>(lowMax, middleMedian, highMin));
+		}
+		for (; x < nrMedians; x++)
+		{
+			medians[begin + x] = MedianOfSortedColumns(low + x, middle + x, high + x);
+		}
+	}
+}
+
+template <typename Ops, typename T>
+THUNDER_MEDIAN_TARGET void MedianRow5x5(const T *const *rows, const size_t count, T *medians)
+{
+	using Vector = typename Ops::Vector;
+	constexpr size_t width = Ops::Width;
+
+#define THUNDER_MEDIAN_SORT(a, b) Sort<Ops>(p[a], p[b]);
+
+	size_t x = 0;
+	for (; x + width <= count; x += width)
+	{
+		Vector p[25];
+		for (size_t y = 0; y < 5; y++)
+		{
+			for (size_t i = 0; i < 5; i++)
+			{
+				p[y * 5 + i] = Ops::Load(rows[y] + x + i);
+			}
+		}
+		THUNDER_MEDIAN25_NETWORK(THUNDER_MEDIAN_SORT)
+		Ops::Store(medians + x, p[12]);
+	}
+
+#undef THUNDER_MEDIAN_SORT
+
+	for (; x < count; x++)
+	{
+		medians[x] = MedianOf25(rows, x);
+	}
+}
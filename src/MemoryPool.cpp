@@ -0,0 +1,154 @@
+#include "MemoryPool.h"
+
+#include <atomic>
+
+namespace
+{
+std::atomic<size_t> heapAllocations{0};
+std::atomic<size_t> heapDeallocations{0};
+std::atomic<size_t> heapAllocatedBytes{0};
+} // namespace
+
+void *ThunderVision::AllocateAligned(size_t bytes)
+{
+	void *pointer = ::operator new(bytes, std::align_val_t(TensorAlignment));
+	heapAllocations++;
+	heapAllocatedBytes += bytes;
+	return pointer;
+}
+
+void ThunderVision::DeallocateAligned(void *pointer, size_t bytes)
+{
+	if (pointer == nullptr)
+		return;
+	::operator delete(pointer, std::align_val_t(TensorAlignment));
+	heapDeallocations++;
+}
+
+ThunderVision::HeapAllocationCounters ThunderVision::GetHeapAllocationCounters()
+{
+	HeapAllocationCounters counters;
+	counters.allocations = heapAllocations.load();
+	counters.deallocations = heapDeallocations.load();
+	counters.allocatedBytes = heapAllocatedBytes.load();
+	return counters;
+}
+
+ThunderVision::MemoryPool::MemoryPool(size_t maxCachedBytes)
+{
+	_maxCachedBytes = maxCachedBytes;
+}
+
+ThunderVision::MemoryPool::~MemoryPool()
+{
+	Trim();
+}
+
+void *ThunderVision::MemoryPool::Allocate(size_t bytes)
+{
+	size_t classBytes;
+	const size_t sizeClass = GetSizeClass(bytes, classBytes);
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		FreeBuffer *buffer = _freeLists[sizeClass];
+		if (buffer != nullptr)
+		{
+			_freeLists[sizeClass] = buffer->next;
+			_statistics.reusedAllocations++;
+			_statistics.cachedBuffers--;
+			_statistics.cachedBytes -= classBytes;
+			return buffer;
+		}
+		_statistics.heapAllocations++;
+	}
+	return AllocateAligned(classBytes);
+}
+
+void ThunderVision::MemoryPool::Deallocate(void *pointer, size_t bytes)
+{
+	if (pointer == nullptr)
+		return;
+
+	size_t classBytes;
+	const size_t sizeClass = GetSizeClass(bytes, classBytes);
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_statistics.cachedBytes + classBytes <= _maxCachedBytes)
+		{
+			FreeBuffer *buffer = static_cast<FreeBuffer *>(pointer);
+			buffer->next = _freeLists[sizeClass];
+			_freeLists[sizeClass] = buffer;
+			_statistics.cachedBuffers++;
+			_statistics.cachedBytes += classBytes;
+			return;
+		}
+	}
+	DeallocateAligned(pointer, classBytes);
+}
+
+void ThunderVision::MemoryPool::Trim()
+{
+	std::array<FreeBuffer *, NrSizeClasses> freeLists;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		freeLists = _freeLists;
+		_freeLists.fill(nullptr);
+		_statistics.cachedBuffers = 0;
+		_statistics.cachedBytes = 0;
+	}
+
+	for (FreeBuffer *buffer : freeLists)
+	{
+		while (buffer != nullptr)
+		{
+			FreeBuffer *next = buffer->next;
+			DeallocateAligned(buffer, 0);
+			buffer = next;
+		}
+	}
+}
+
+void ThunderVision::MemoryPool::SetMaxCachedBytes(size_t maxCachedBytes)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_maxCachedBytes = maxCachedBytes;
+}
+
+size_t ThunderVision::MemoryPool::GetMaxCachedBytes() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _maxCachedBytes;
+}
+
+ThunderVision::MemoryPoolStatistics ThunderVision::MemoryPool::GetStatistics() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _statistics;
+}
+
+ThunderVision::MemoryPool &ThunderVision::MemoryPool::GetDefault()
+{
+	// Never destroyed, tensors with static storage duration may still return their buffers during shutdown
+	static MemoryPool *pool = new MemoryPool();
+	return *pool;
+}
+
+size_t ThunderVision::MemoryPool::GetSizeClass(size_t bytes, size_t &classBytes)
+{
+	if (bytes <= TensorAlignment)
+	{
+		classBytes = TensorAlignment;
+		return 0;
+	}
+
+	// 2^exponent < bytes <= 2^(exponent + 1), split into four classes of 2^(exponent - 2) bytes
+	size_t exponent = 0;
+	while ((size_t(2) << exponent) < bytes)
+	{
+		exponent++;
+	}
+	const size_t step = size_t(1) << (exponent - 2);
+	const size_t steps = (bytes + step - 1) / step;
+	classBytes = steps * step;
+	return 1 + (exponent - 6) * 4 + (steps - 5);
+}
@@ -0,0 +1,187 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+// The mutex of a buffer is only contended while the records are read or cleared
+struct ThreadBuffer
+{
+	std::mutex mutex;
+	std::vector<ThunderVision::ProfileRecord> records;
+	size_t next = 0;
+	size_t thread = 0;
+};
+
+struct Registry
+{
+	std::mutex mutex;
+	std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+	std::atomic<bool> enabled{true};
+	const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+Registry &GetRegistry()
+{
+	static Registry registry;
+	return registry;
+}
+
+// Registered on the first record of a thread, the registry keeps the buffers of finished threads
+ThreadBuffer &GetThreadBuffer()
+{
+	thread_local std::shared_ptr<ThreadBuffer> buffer;
+	if (!buffer)
+	{
+		buffer = std::make_shared<ThreadBuffer>();
+		buffer->records.reserve(ThunderVision::Profiler::RingSize);
+		Registry &registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		buffer->thread = registry.buffers.size();
+		registry.buffers.push_back(buffer);
+	}
+	return *buffer;
+}
+
+void WriteEscaped(std::ostream &stream, const char *text)
+{
+	for (; *text != '\0'; text++)
+	{
+		if (*text == '"' || *text == '\\')
+			stream << '\\';
+		stream << *text;
+	}
+}
+
+// The trace event format expects microseconds
+void WriteMicroseconds(std::ostream &stream, const uint64_t nanoseconds)
+{
+	char text[32];
+	std::snprintf(text, sizeof(text), "%llu.%03llu", static_cast<unsigned long long>(nanoseconds / 1000), static_cast<unsigned long long>(nanoseconds % 1000));
+	stream << text;
+}
+} // namespace
+
+bool ThunderVision::Profiler::IsCompiled()
+{
+#ifdef THUNDER_PROFILING
+	return true;
+#else
+	return false;
+#endif
+}
+
+void ThunderVision::Profiler::SetEnabled(bool enabled)
+{
+	GetRegistry().enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool ThunderVision::Profiler::IsEnabled()
+{
+	return GetRegistry().enabled.load(std::memory_order_relaxed);
+}
+
+uint64_t ThunderVision::Profiler::Now()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - GetRegistry().epoch).count());
+}
+
+void ThunderVision::Profiler::Record(const char *name, uint64_t begin, uint64_t end)
+{
+	ThreadBuffer &buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	const ProfileRecord record = {name, buffer.thread, begin, end};
+	if (buffer.records.size() < RingSize)
+		buffer.records.push_back(record);
+	else
+		buffer.records[buffer.next] = record;
+	buffer.next = (buffer.next + 1) % RingSize;
+}
+
+std::vector<ThunderVision::ProfileRecord> ThunderVision::Profiler::GetRecords()
+{
+	Registry &registry = GetRegistry();
+	std::vector<ProfileRecord> records;
+	{
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		for (auto &buffer : registry.buffers)
+		{
+			std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+			records.insert(records.end(), buffer->records.begin(), buffer->records.end());
+		}
+	}
+	std::stable_sort(records.begin(), records.end(), [](const ProfileRecord &a, const ProfileRecord &b) { return a.begin < b.begin; });
+	return records;
+}
+
+std::vector<ThunderVision::ProfileSummary> ThunderVision::Profiler::Summarize()
+{
+	std::map<std::string, ProfileSummary> stages;
+	for (const ProfileRecord &record : GetRecords())
+	{
+		const double duration = static_cast<double>(record.end - record.begin) * 1e-6;
+		auto stage = stages.find(record.name);
+		if (stage == stages.end())
+		{
+			stages.emplace(record.name, ProfileSummary{record.name, 1, duration, duration, duration});
+			continue;
+		}
+		ProfileSummary &summary = stage->second;
+		summary.count++;
+		summary.total += duration;
+		summary.minimum = std::min(summary.minimum, duration);
+		summary.maximum = std::max(summary.maximum, duration);
+	}
+
+	std::vector<ProfileSummary> summaries;
+	for (auto &stage : stages)
+	{
+		summaries.push_back(stage.second);
+	}
+	return summaries;
+}
+
+void ThunderVision::Profiler::WriteChromeTrace(std::ostream &stream)
+{
+	const std::vector<ProfileRecord> records = GetRecords();
+	stream << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+	for (size_t i = 0; i < records.size(); i++)
+	{
+		stream << (i == 0 ? "\n" : ",\n") << "{\"name\": \"";
+		WriteEscaped(stream, records[i].name);
+		stream << "\", \"cat\": \"ThunderVision\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << records[i].thread << ", \"ts\": ";
+		WriteMicroseconds(stream, records[i].begin);
+		stream << ", \"dur\": ";
+		WriteMicroseconds(stream, records[i].end - records[i].begin);
+		stream << "}";
+	}
+	stream << "\n]}\n";
+}
+
+void ThunderVision::Profiler::Clear()
+{
+	Registry &registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	for (auto &buffer : registry.buffers)
+	{
+		std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+		buffer->records.clear();
+		buffer->next = 0;
+	}
+}
+
+ThunderVision::ScopedTimer::ScopedTimer(const char *name) : _name(Profiler::IsEnabled() ? name : nullptr), _begin(_name != nullptr ? Profiler::Now() : 0)
+{
+}
+
+ThunderVision::ScopedTimer::~ScopedTimer()
+{
+	if (_name != nullptr)
+		Profiler::Record(_name, _begin, Profiler::Now());
+}
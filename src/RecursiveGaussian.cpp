@@ -0,0 +1,142 @@
+#include "RecursiveGaussian.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include "Exceptions.h"
+#include "FilterUtil.h"
+
+namespace
+{
+// Rows filtered together in the horizontal pass and columns in the vertical pass
+constexpr size_t RowsPerBlock = 16;
+constexpr size_t ColumnsPerBlock = 64;
+
+// {B, a1, a2, a3} of Young and van Vliet, eq. 11 - 16 (b_i / b0 as a_i)
+std::array<float, 4> ComputeCoefficients(const double sigma)
+{
+	const double q = sigma >= 2.5 ? 0.98711 * sigma - 0.96330 : 3.97156 - 4.14554 * std::sqrt(1.0 - 0.26891 * sigma);
+	const double b0 = 1.57825 + 2.44413 * q + 1.4281 * q * q + 0.422205 * q * q * q;
+	const double b1 = 2.44413 * q + 2.85619 * q * q + 1.26661 * q * q * q;
+	const double b2 = -(1.4281 * q * q + 1.26661 * q * q * q);
+	const double b3 = 0.422205 * q * q * q;
+	const double a1 = b1 / b0;
+	const double a2 = b2 / b0;
+	const double a3 = b3 / b0;
+	return {static_cast<float>(1.0 - (a1 + a2 + a3)), static_cast<float>(a1), static_cast<float>(a2), static_cast<float>(a3)};
+}
+} // namespace
+
+ThunderVision::RecursiveGaussian::RecursiveGaussian(const SimdLevel maxLevel)
+{
+	_kernels = SelectSeparableFilterKernels(maxLevel);
+}
+
+template <typename T>
+void ThunderVision::RecursiveGaussian::Apply(const TensorView<const T> &input, const double sigma, Tensor<T> &output, ThreadPool &pool)
+{
+	if (sigma < 0.5)
+		throw new ThunderException("The recursive Gaussian requires sigma >= 0.5");
+	if (input.GetRank() != 3 && input.GetRank() != 2)
+		throw new ThunderException("At the moment only 2D and 3D tensors are supported");
+
+	const int64_t height = static_cast<int64_t>(input.GetDimension(0));
+	const int64_t width = static_cast<int64_t>(input.GetDimension(1));
+	const int64_t channels = input.GetRank() == 3 ? static_cast<int64_t>(input.GetDimension(2)) : 1;
+	const int64_t strideY = input.GetStride(0);
+	const int64_t strideX = input.GetStride(1);
+	const int64_t strideC = input.GetRank() == 3 ? input.GetStride(2) : 0;
+
+	const std::vector<size_t> outputDimensions = {static_cast<size_t>(height), static_cast<size_t>(width), static_cast<size_t>(channels)};
+	if (output.GetDimensions() != outputDimensions)
+		output.Resize(outputDimensions);
+	if (output.GetTotalSize() == 0)
+		return;
+	if (_intermediate.GetDimensions() != outputDimensions)
+		_intermediate.Resize(outputDimensions);
+
+	const std::array<float, 4> coefficients = ComputeCoefficients(sigma);
+	const int64_t padding = static_cast<int64_t>(std::ceil(4.0 * sigma));
+	const int64_t rowLength = width * channels;
+	const size_t paddedWidth = static_cast<size_t>(width + 2 * padding);
+	const size_t paddedHeight = static_cast<size_t>(height + 2 * padding);
+
+	const size_t perThread = std::max(paddedWidth * RowsPerBlock * static_cast<size_t>(channels), paddedHeight * ColumnsPerBlock);
+	const std::vector<size_t> linesDimensions = {pool.GetNrThreads(), perThread};
+	if (_lines.GetDimensions() != linesDimensions)
+		_lines.Resize(linesDimensions);
+
+	const RecursiveFilterKernel recursive = _kernels.recursive;
+
+	// Rows: element n of the lanes (row r, channel c) is the pixel at x = n - padding
+	const int64_t nrRowBlocks = (height + RowsPerBlock - 1) / RowsPerBlock;
+	pool.ParallelFor(0, nrRowBlocks, [&](int64_t blockBegin, int64_t blockEnd, size_t threadIndex) {
+		float *lines = _lines.Data() + threadIndex * perThread;
+		for (int64_t block = blockBegin; block < blockEnd; block++)
+		{
+			const int64_t rowBegin = block * RowsPerBlock;
+			const int64_t nrRows = std::min<int64_t>(RowsPerBlock, height - rowBegin);
+			const size_t lanes = static_cast<size_t>(nrRows * channels);
+
+			for (int64_t n = 0; n < static_cast<int64_t>(paddedWidth); n++)
+			{
+				const int64_t x = FilterUtil::Reflect(n - padding, width);
+				float *target = lines + n * lanes;
+				for (int64_t r = 0; r < nrRows; r++)
+				{
+					const T *pixel = input.Data() + (rowBegin + r) * strideY + x * strideX;
+					for (int64_t c = 0; c < channels; c++)
+					{
+						target[r * channels + c] = static_cast<float>(pixel[c * strideC]);
+					}
+				}
+			}
+
+			recursive(lines, paddedWidth, lanes, coefficients.data());
+
+			for (int64_t r = 0; r < nrRows; r++)
+			{
+				float *row = _intermediate.Data() + (rowBegin + r) * rowLength;
+				for (int64_t x = 0; x < width; x++)
+				{
+					const float *source = lines + (x + padding) * lanes + r * channels;
+					for (int64_t c = 0; c < channels; c++)
+					{
+						row[x * channels + c] = source[c];
+					}
+				}
+			}
+		}
+	});
+
+	// Columns: consecutive elements of the intermediate rows are the lanes
+	const int64_t nrColumnBlocks = (rowLength + ColumnsPerBlock - 1) / ColumnsPerBlock;
+	pool.ParallelFor(0, nrColumnBlocks, [&](int64_t blockBegin, int64_t blockEnd, size_t threadIndex) {
+		float *lines = _lines.Data() + threadIndex * perThread;
+		for (int64_t block = blockBegin; block < blockEnd; block++)
+		{
+			const int64_t columnBegin = block * ColumnsPerBlock;
+			const size_t lanes = static_cast<size_t>(std::min<int64_t>(ColumnsPerBlock, rowLength - columnBegin));
+
+			for (int64_t n = 0; n < static_cast<int64_t>(paddedHeight); n++)
+			{
+				const float *source = _intermediate.Data() + FilterUtil::Reflect(n - padding, height) * rowLength + columnBegin;
+				std::copy(source, source + lanes, lines + n * lanes);
+			}
+
+			recursive(lines, paddedHeight, lanes, coefficients.data());
+
+			for (int64_t y = 0; y < height; y++)
+			{
+				const float *source = lines + (y + padding) * lanes;
+				FilterUtil::RoundAndSaturate(_kernels, source, lanes, output.Data() + y * rowLength + columnBegin);
+			}
+		}
+	});
+}
+
+template void ThunderVision::RecursiveGaussian::Apply<float>(const TensorView<const float> &, const double, Tensor<float> &, ThreadPool &);
+template void ThunderVision::RecursiveGaussian::Apply<uint8_t>(const TensorView<const uint8_t> &, const double, Tensor<uint8_t> &, ThreadPool &);
+template void ThunderVision::RecursiveGaussian::Apply<uint16_t>(const TensorView<const uint16_t> &, const double, Tensor<uint16_t> &, ThreadPool &);
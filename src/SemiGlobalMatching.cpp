@@ -1,10 +1,172 @@
 #include "SemiGlobalMatching.h"
 
+namespace
+{
+// Profiling names of the aggregation directions, see AggregateCosts<X, Y>
+template <int X, int Y>
+constexpr const char *AggregationStage()
+{
+	if (X == 1 && Y == 0)
+		return "Aggregation (1, 0)";
+	if (X == -1 && Y == 0)
+		return "Aggregation (-1, 0)";
+	if (X == 0 && Y == 1)
+		return "Aggregation (0, 1)";
+	if (X == 0 && Y == -1)
+		return "Aggregation (0, -1)";
+	if (X == 1 && Y == 1)
+		return "Aggregation (1, 1)";
+	if (X == -1 && Y == 1)
+		return "Aggregation (-1, 1)";
+	if (X == -1 && Y == -1)
+		return "Aggregation (-1, -1)";
+	return "Aggregation (1, -1)";
+}
+
+// Disparity bands of the hierarchical mode are multiples of the widest aggregation kernel
+size_t RoundUpToBand(const size_t disparities)
+{
+	return ThunderVision::DisparityRanges::PadCount(disparities);
+}
+
+/**
+* Path costs of the predecessor seen from the range of the current pixel: entry d of the result belongs to disparity
+* minima[pixel] + d. The path buffers are padded with UINT16_MAX by the largest count on both sides, so disparities
+* outside of the range of the predecessor read as invalid.
+*/
+inline const uint16_t *AlignToRange(const uint16_t *previous, const int32_t *minima, const int64_t pixel, const int64_t predecessor, const int64_t maxCount)
+{
+	if (minima == nullptr)
+		return previous;
+	return previous + std::min(std::max<int64_t>(minima[pixel] - minima[predecessor], -maxCount), maxCount);
+}
+
+/**
+* Invalidates the path costs behind the count of a pixel which are left over from an earlier pixel with a larger count.
+* extent is the number of path costs of the buffer which may be valid.
+*/
+inline void ClearTail(uint16_t *path, const size_t count, size_t &extent)
+{
+	if (extent > count)
+		std::fill(path + count, path + extent, UINT16_MAX);
+	extent = count;
+}
+
+/**
+* Ranges of the left image within [0, maxDisparity), optionally restricted by per pixel minima and maxima, and to the
+* disparities whose matching pixel lies inside of the right image.
+*/
+void SetLeftRanges(const ThunderVision::Tensor<int32_t> *minima, const ThunderVision::Tensor<int32_t> *maxima, const size_t maxDisparity, ThunderVision::DisparityRanges &ranges)
+{
+	const size_t width = ranges.GetWidth();
+	const int32_t maximum = static_cast<int32_t>(maxDisparity);
+	for (size_t y = 0, pixel = 0; y < ranges.GetHeight(); y++)
+	{
+		for (size_t x = 0; x < width; x++, pixel++)
+		{
+			const int32_t begin = minima ? std::min(std::max((*minima)[pixel], 0), maximum) : 0;
+			const int32_t end = maxima ? std::min(std::max((*maxima)[pixel], 0), maximum) : maximum;
+			ranges.Set(pixel, begin, std::min(end, static_cast<int32_t>(x) + 1));
+		}
+	}
+}
+
+/**
+* Centers the band of every pixel on the coarser disparities, scaled to the resolution of the level. If the valid
+* coarser disparities around the pixel differ by less than half a band, the band covers all of them, otherwise it
+* follows the nearest coarser pixel. Pixels without a valid coarser disparity to follow search the full range.
+*/
+void SetBandRanges(const ThunderVision::Tensor<float> &coarse, const size_t band, const size_t maxDisparity, ThunderVision::DisparityRanges &ranges)
+{
+	const int64_t width = static_cast<int64_t>(ranges.GetWidth());
+	const int64_t height = static_cast<int64_t>(ranges.GetHeight());
+	const int64_t coarseHeight = static_cast<int64_t>(coarse.GetDimension(0));
+	const int64_t coarseWidth = static_cast<int64_t>(coarse.GetDimension(1));
+	const float scale = static_cast<float>(width) / static_cast<float>(coarseWidth);
+	const int32_t maxOffset = static_cast<int32_t>(std::max(band, maxDisparity) - band);
+	const float invalid = std::numeric_limits<float>::max();
+
+	for (int64_t y = 0; y < height; y++)
+	{
+		const int64_t cy = std::min(y * coarseHeight / height, coarseHeight - 1);
+		for (int64_t x = 0; x < width; x++)
+		{
+			const int64_t cx = std::min(x * coarseWidth / width, coarseWidth - 1);
+			const float nearest = coarse[cy * coarseWidth + cx];
+			float low = invalid;
+			float high = -invalid;
+			for (int64_t ny = std::max<int64_t>(cy - 1, 0); ny <= std::min(cy + 1, coarseHeight - 1); ny++)
+			{
+				for (int64_t nx = std::max<int64_t>(cx - 1, 0); nx <= std::min(cx + 1, coarseWidth - 1); nx++)
+				{
+					const float disparity = coarse[ny * coarseWidth + nx];
+					if (disparity == invalid)
+						continue;
+					low = std::min(low, disparity);
+					high = std::max(high, disparity);
+				}
+			}
+
+			const size_t pixel = static_cast<size_t>(y * width + x);
+			const bool covered = low <= high && (high - low) * scale < 0.5f * band;
+			if (!covered && nearest == invalid)
+			{
+				ranges.Set(pixel, 0, std::min(static_cast<int32_t>(maxDisparity), static_cast<int32_t>(x) + 1));
+				continue;
+			}
+
+			const float center = covered ? 0.5f * (low + high) * scale : nearest * scale;
+			const int32_t offset = std::min(std::max(static_cast<int32_t>(std::lround(center)) - static_cast<int32_t>(band / 2), 0), maxOffset);
+			ranges.Set(pixel, offset, std::min(offset + static_cast<int32_t>(band), static_cast<int32_t>(x) + 1));
+		}
+	}
+}
+
+/**
+* Ranges of the right image covering the disparities of all left pixels which are seen at a right pixel. Right pixels
+* seen by no left pixel take the range of their left neighbour, clipped to the disparities inside of the left image.
+*/
+void SetRightRanges(const ThunderVision::DisparityRanges &left, ThunderVision::DisparityRanges &right)
+{
+	const int64_t width = static_cast<int64_t>(left.GetWidth());
+	std::vector<int32_t> minima(width);
+	std::vector<int32_t> maxima(width);
+	for (int64_t y = 0; y < static_cast<int64_t>(left.GetHeight()); y++)
+	{
+		const int32_t *leftMinima = left.GetMinima() + y * width;
+		const uint16_t *leftCounts = left.GetCounts() + y * width;
+		std::fill(minima.begin(), minima.end(), INT32_MAX);
+		std::fill(maxima.begin(), maxima.end(), 0);
+		for (int64_t x = 0; x < width; x++)
+		{
+			for (int32_t d = leftMinima[x]; d < leftMinima[x] + leftCounts[x] && d <= x; d++)
+			{
+				minima[x - d] = std::min(minima[x - d], d);
+				maxima[x - d] = std::max(maxima[x - d], d + 1);
+			}
+		}
+
+		int32_t previousMinimum = 0;
+		int32_t previousMaximum = 1;
+		for (int64_t x = 0; x < width; x++)
+		{
+			if (minima[x] < maxima[x])
+			{
+				previousMinimum = minima[x];
+				previousMaximum = maxima[x];
+			}
+			right.Set(static_cast<size_t>(y * width + x), previousMinimum, std::min(previousMaximum, static_cast<int32_t>(width - x)));
+		}
+	}
+}
+} // namespace
+
 ThunderVision::SemiGlobalMatching::SemiGlobalMatching(size_t maxDisparity, bool consistencyCheck, AggregationDirections dirs)
 {
 	_aggregationDirections = dirs;
 	_maxDisparity = maxDisparity;
 	_consistencyCheck = consistencyCheck;
+	_censusTransform.SetInvalidValue(invalid_census_value);
 
 	static_assert(std::numeric_limits<int>::max() >= std::numeric_limits<int32_t>::max(), "The integer type on this system is too small to represent all of the asserted images properly.");
 	static_assert(std::numeric_limits<unsigned int>::max() >= std::numeric_limits<uint32_t>::max(), "The integer type on this system is too small to represent all of the asserted images properly.");
@@ -16,170 +178,688 @@ ThunderVision::SemiGlobalMatching::~SemiGlobalMatching()
 
 void ThunderVision::SemiGlobalMatching::Prepare(size_t width, size_t height)
 {
-	Tensor<unsigned int> l_aggregatedCosts({height, width, _maxDisparity});
-	Tensor<unsigned int> l_tempBuffer({height, width, _maxDisparity});
-	Tensor<uint16_t> l_costVolume({height, width, _maxDisparity});
-	Tensor<float> l_minimalDisparities({height, width});
-	Tensor<uint64_t> l_censusLeftImage({height, width});
-	Tensor<uint64_t> l_censusRightImage({height, width});
+	if (_hierarchicalLevels > 1 || _compactCostVolume)
+	{
+		// The compact volumes are sized by ComputeCompactMatchingCostImage
+		const size_t nrThreads = GetThreadPool().GetNrThreads();
+		pathBuffers.resize(nrThreads);
+		pathMinimaBuffers.resize(nrThreads);
+		censusRows = Tensor<uint64_t>();
+		costRow = Tensor<uint16_t>();
+		streamingPathBuffers = Tensor<uint16_t>();
+		streamingPathMinima = Tensor<uint16_t>();
+		_hammingKernels = SelectHammingCostKernels(_maxSimdLevel);
+		_winnerTakesAllKernels = SelectWinnerTakesAllKernels<unsigned int>(_maxSimdLevel);
+		_winnerTakesAllKernels16 = SelectWinnerTakesAllKernels<uint16_t>(_maxSimdLevel);
+		_width = width;
+		_height = height;
+		prepared = true;
+		return;
+	}
 
-	censusLeft = l_censusLeftImage;
-	censusRight = l_censusRightImage;
-	aggregatedCosts = l_aggregatedCosts;
-	tempBuffer = l_tempBuffer;
-	costVolume = l_costVolume;
-	minimalDisparities = l_minimalDisparities;
+	if (_costStorage == CostStorage::UInt16Saturated)
+	{
+		aggregatedCosts16.Resize({height, width, _maxDisparity});
+		aggregatedCosts = Tensor<unsigned int>();
+	}
+	else
+	{
+		aggregatedCosts.Resize({height, width, _maxDisparity});
+		aggregatedCosts16 = Tensor<uint16_t>();
+	}
 
+	const size_t nrThreads = GetThreadPool().GetNrThreads();
+	pathBuffers.resize(nrThreads);
+	pathMinimaBuffers.resize(nrThreads);
+	for (size_t i = 0; i < nrThreads; i++)
+	{
+		pathBuffers[i].Resize({2, width, _maxDisparity});
+		pathMinimaBuffers[i].Resize({2, width});
+	}
+
+	if (_rowStreaming)
+	{
+		censusRows.Resize({2, width});
+		costRow.Resize({width, _maxDisparity});
+		streamingPathBuffers.Resize({3, 2, width, _maxDisparity});
+		streamingPathMinima.Resize({3, 2, width});
+		costVolume = Tensor<uint16_t>();
+		censusLeft = Tensor<uint64_t>();
+		censusRight = Tensor<uint64_t>();
+	}
+	else
+	{
+		costVolume.Resize({height, width, _maxDisparity});
+		censusLeft.Resize({height, width});
+		censusRight.Resize({height, width});
+		censusRows = Tensor<uint64_t>();
+		costRow = Tensor<uint16_t>();
+		streamingPathBuffers = Tensor<uint16_t>();
+		streamingPathMinima = Tensor<uint16_t>();
+	}
+	minimalDisparities.Resize({height, width});
+
+	_aggregationKernels = SelectAggregationKernels<unsigned int>(_maxDisparity, _maxSimdLevel);
+	_aggregationKernels16 = SelectAggregationKernels<uint16_t>(_maxDisparity, _maxSimdLevel);
+	_hammingKernels = SelectHammingCostKernels(_maxSimdLevel);
+	_winnerTakesAllKernels = SelectWinnerTakesAllKernels<unsigned int>(_maxSimdLevel);
+	_winnerTakesAllKernels16 = SelectWinnerTakesAllKernels<uint16_t>(_maxSimdLevel);
+	_width = width;
+	_height = height;
 	prepared = true;
 }
 
-void ThunderVision::SemiGlobalMatching::AggregateCosts(const Tensor<uint16_t> &costVolume, const bool internalParallel, Tensor<unsigned int> &aggregatedCosts, Tensor<unsigned int> &tempBuffer)
+void ThunderVision::SemiGlobalMatching::SetCostStorage(CostStorage storage)
+{
+	if (storage != _costStorage)
+	{
+		_costStorage = storage;
+		prepared = false;
+	}
+}
+
+ThunderVision::CostStorage ThunderVision::SemiGlobalMatching::GetCostStorage() const
+{
+	return _costStorage;
+}
+
+void ThunderVision::SemiGlobalMatching::SetMaxSimdLevel(SimdLevel level)
+{
+	if (level != _maxSimdLevel)
+	{
+		_maxSimdLevel = level;
+		prepared = false;
+	}
+}
+
+ThunderVision::SimdLevel ThunderVision::SemiGlobalMatching::GetMaxSimdLevel() const
+{
+	return _maxSimdLevel;
+}
+
+void ThunderVision::SemiGlobalMatching::SetNrThreads(size_t nrThreads)
+{
+	_threadPool = nrThreads == 0 ? nullptr : std::make_shared<ThreadPool>(nrThreads);
+	prepared = false;
+}
+
+size_t ThunderVision::SemiGlobalMatching::GetNrThreads() const
+{
+	return _threadPool ? _threadPool->GetNrThreads() : ThreadPool::GetDefault().GetNrThreads();
+}
+
+void ThunderVision::SemiGlobalMatching::SetRowStreaming(bool enabled)
+{
+	if (enabled != _rowStreaming)
+	{
+		_rowStreaming = enabled;
+		prepared = false;
+	}
+}
+
+bool ThunderVision::SemiGlobalMatching::GetRowStreaming() const
+{
+	return _rowStreaming;
+}
+
+void ThunderVision::SemiGlobalMatching::SetHierarchical(size_t nrLevels, size_t disparityBand)
+{
+	if (nrLevels == 0)
+		throw new ThunderException("The hierarchical mode needs at least one level");
+
+	_hierarchicalLevels = nrLevels;
+	_disparityBand = RoundUpToBand(disparityBand);
+	prepared = false;
+}
+
+size_t ThunderVision::SemiGlobalMatching::GetHierarchicalLevels() const
+{
+	return _hierarchicalLevels;
+}
+
+size_t ThunderVision::SemiGlobalMatching::GetDisparityBand() const
+{
+	return _disparityBand;
+}
+
+void ThunderVision::SemiGlobalMatching::SetCompactCostVolume(bool enabled)
+{
+	_compactCostVolume = enabled;
+	prepared = false;
+}
+
+bool ThunderVision::SemiGlobalMatching::GetCompactCostVolume() const
+{
+	return _compactCostVolume;
+}
+
+void ThunderVision::SemiGlobalMatching::SetDisparityRanges(const Tensor<int32_t> &minima, const Tensor<int32_t> &maxima)
+{
+	if (minima.GetDimensions() != maxima.GetDimensions() || (minima.GetTotalSize() > 0 && minima.GetRank() != 2))
+		throw new ThunderException("The disparity minima and maxima have to be 2D tensors of the same size.");
+
+	_rangeMinima = minima;
+	_rangeMaxima = maxima;
+	_compactCostVolume = true;
+	prepared = false;
+}
+
+void ThunderVision::SemiGlobalMatching::SetSubpixelRefinement(SubpixelMode mode)
+{
+	_winnerTakesAllParameters.subpixel = mode;
+}
+
+ThunderVision::SubpixelMode ThunderVision::SemiGlobalMatching::GetSubpixelRefinement() const
+{
+	return _winnerTakesAllParameters.subpixel;
+}
+
+void ThunderVision::SemiGlobalMatching::SetUniquenessRatio(float ratio)
+{
+	if (ratio < 0.0f)
+		throw new ThunderException("The uniqueness ratio can not be negative.");
+	_winnerTakesAllParameters.uniquenessRatio = ratio;
+}
+
+float ThunderVision::SemiGlobalMatching::GetUniquenessRatio() const
+{
+	return _winnerTakesAllParameters.uniquenessRatio;
+}
+
+void ThunderVision::SemiGlobalMatching::SetConsistencyMode(ConsistencyMode mode)
+{
+	_consistencyMode = mode;
+}
+
+ThunderVision::ConsistencyMode ThunderVision::SemiGlobalMatching::GetConsistencyMode() const
+{
+	return _consistencyMode;
+}
+
+void ThunderVision::SemiGlobalMatching::SetGrayscaleWeights(GrayscaleWeights weights)
+{
+	_grayscaleWeights = weights;
+}
+
+ThunderVision::GrayscaleWeights ThunderVision::SemiGlobalMatching::GetGrayscaleWeights() const
+{
+	return _grayscaleWeights;
+}
+
+void ThunderVision::SemiGlobalMatching::SetCensusTransform(CensusWindow window, CensusType type)
+{
+	_censusTransform = CensusTransform(window, type);
+	_censusTransform.SetInvalidValue(invalid_census_value);
+}
+
+const ThunderVision::CensusTransform &ThunderVision::SemiGlobalMatching::GetCensusTransform() const
+{
+	return _censusTransform;
+}
+
+ThunderVision::ThreadPool &ThunderVision::SemiGlobalMatching::GetThreadPool()
+{
+	return _threadPool ? *_threadPool : ThreadPool::GetDefault();
+}
+
+void ThunderVision::SemiGlobalMatching::AggregateCosts(const Tensor<uint16_t> &costVolume, Tensor<unsigned int> &aggregatedCosts)
+{
+	AggregateCosts(costVolume, _aggregationKernels, aggregatedCosts);
+}
+
+void ThunderVision::SemiGlobalMatching::AggregateCosts(const Tensor<uint16_t> &costVolume, Tensor<uint16_t> &aggregatedCosts)
+{
+	AggregateCosts(costVolume, _aggregationKernels16, aggregatedCosts);
+}
+
+template <typename TAggregated>
+void ThunderVision::SemiGlobalMatching::AggregateCosts(const Tensor<uint16_t> &costVolume, const AggregationKernels<TAggregated> &kernels, Tensor<TAggregated> &aggregatedCosts)
 {
 	aggregatedCosts.Fill(0);
 	if (_aggregationDirections == AggregationDirections::Nr4_Diag)
 	{
-		AggregateCosts<1, 1>(costVolume, aggregatedCosts, tempBuffer);
-		AggregateCosts<-1, 1>(costVolume, aggregatedCosts, tempBuffer);
-		AggregateCosts<-1, -1>(costVolume, aggregatedCosts, tempBuffer);
-		AggregateCosts<1, -1>(costVolume, aggregatedCosts, tempBuffer);
+		AggregateCosts<1, 1>(costVolume, kernels, aggregatedCosts);
+		AggregateCosts<-1, 1>(costVolume, kernels, aggregatedCosts);
+		AggregateCosts<-1, -1>(costVolume, kernels, aggregatedCosts);
+		AggregateCosts<1, -1>(costVolume, kernels, aggregatedCosts);
 		return;
 	}
 
 	if (_aggregationDirections == AggregationDirections::Nr4_Axis)
 	{
-		AggregateCosts<1, 0>(costVolume, aggregatedCosts, tempBuffer);
-		AggregateCosts<0, 1>(costVolume, aggregatedCosts, tempBuffer);
-		AggregateCosts<-1, 0>(costVolume, aggregatedCosts, tempBuffer);
-		AggregateCosts<0, -1>(costVolume, aggregatedCosts, tempBuffer);
+		AggregateCosts<1, 0>(costVolume, kernels, aggregatedCosts);
+		AggregateCosts<0, 1>(costVolume, kernels, aggregatedCosts);
+		AggregateCosts<-1, 0>(costVolume, kernels, aggregatedCosts);
+		AggregateCosts<0, -1>(costVolume, kernels, aggregatedCosts);
 		return;
 	}
 
-	AggregateCosts<1, 0>(costVolume, aggregatedCosts, tempBuffer);
-	AggregateCosts<1, 1>(costVolume, aggregatedCosts, tempBuffer);
-	AggregateCosts<0, 1>(costVolume, aggregatedCosts, tempBuffer);
-	AggregateCosts<-1, 1>(costVolume, aggregatedCosts, tempBuffer);
-	AggregateCosts<-1, 0>(costVolume, aggregatedCosts, tempBuffer);
-	AggregateCosts<-1, -1>(costVolume, aggregatedCosts, tempBuffer);
-	AggregateCosts<0, -1>(costVolume, aggregatedCosts, tempBuffer);
-	AggregateCosts<1, -1>(costVolume, aggregatedCosts, tempBuffer);
+	AggregateCosts<1, 0>(costVolume, kernels, aggregatedCosts);
+	AggregateCosts<1, 1>(costVolume, kernels, aggregatedCosts);
+	AggregateCosts<0, 1>(costVolume, kernels, aggregatedCosts);
+	AggregateCosts<-1, 1>(costVolume, kernels, aggregatedCosts);
+	AggregateCosts<-1, 0>(costVolume, kernels, aggregatedCosts);
+	AggregateCosts<-1, -1>(costVolume, kernels, aggregatedCosts);
+	AggregateCosts<0, -1>(costVolume, kernels, aggregatedCosts);
+	AggregateCosts<1, -1>(costVolume, kernels, aggregatedCosts);
 }
 
-inline void ThunderVision::SemiGlobalMatching::AggregatePositionCost(const Tensor<uint16_t> &costVolume,
-																	 Tensor<unsigned int> &aggregatedCosts,
-																	 Tensor<unsigned int> &temp,
-																	 const int64_t maxDisp,
-																	 const int64_t pos,
-																	 const int64_t direction)
+template <int X, int Y, typename TAggregated>
+void ThunderVision::SemiGlobalMatching::AggregateCosts(const Tensor<uint16_t> &costVolume, const AggregationKernels<TAggregated> &kernels, Tensor<TAggregated> &aggregatedCosts)
 {
-	auto posDir = pos + direction;
-	auto pos_index = pos;
-	auto minCosts = temp[posDir];
-	const size_t e = posDir + maxDisp;
-	for (size_t j = posDir; j < e; j++)
+	THUNDER_PROFILE_SCOPE(AggregationStage<X, Y>());
+
+	// Compact volumes are described by _ranges, dense volumes by their shape {height, width, maxDisparity}
+	const DisparityRanges *ranges = _ranges;
+	const int64_t width = static_cast<int64_t>(ranges ? ranges->GetWidth() : costVolume.GetDimension(1));
+	const int64_t height = static_cast<int64_t>(ranges ? ranges->GetHeight() : costVolume.GetDimension(0));
+	const int64_t maxDisp = static_cast<int64_t>(ranges ? ranges->GetMaxCount() : costVolume.GetDimension(2));
+	const int32_t *minima = ranges ? ranges->GetMinima() : nullptr;
+	const uint16_t *counts = ranges ? ranges->GetCounts() : nullptr;
+	const size_t *offsets = ranges ? ranges->GetOffsets() : nullptr;
+	auto position = [&](int64_t pixel) { return offsets ? static_cast<int64_t>(offsets[pixel]) : pixel * maxDisp; };
+	auto count = [&](int64_t pixel) { return counts ? DisparityRanges::PadCount(counts[pixel]) : static_cast<size_t>(maxDisp); };
+
+	const uint16_t *costs = costVolume.Data();
+	TAggregated *aggregated = aggregatedCosts.Data();
+
+	// Compact path costs are padded by the largest count on both sides, see AlignToRange
+	const int64_t pathStride = ranges ? 3 * maxDisp : maxDisp;
+	const int64_t pathPadding = ranges ? maxDisp : 0;
+
+	// Every pixel belongs to exactly one path of a direction, hence the threads never write to the same costs
+	if (Y == 0)
 	{
-		minCosts = std::min(temp[j], minCosts);
+		// Rows are independent paths
+		GetThreadPool().ParallelFor(0, height, [&](int64_t begin, int64_t end, size_t thread) {
+			uint16_t *previous = pathBuffers[thread].Data() + pathPadding;
+			uint16_t *current = previous + pathStride;
+			size_t previousExtent = static_cast<size_t>(maxDisp);
+			size_t currentExtent = static_cast<size_t>(maxDisp);
+			for (int64_t y = begin; y < end; y++)
+			{
+				int64_t x = X > 0 ? 0 : width - 1;
+				int64_t pixel = y * width + x;
+				size_t nrDisparities = count(pixel);
+				uint16_t minCosts = kernels.start(costs + position(pixel), previous, aggregated + position(pixel), nrDisparities);
+				ClearTail(previous, nrDisparities, previousExtent);
+				for (x += X; x >= 0 && x < width; x += X)
+				{
+					pixel = y * width + x;
+					nrDisparities = count(pixel);
+					const int64_t pos = position(pixel);
+					const uint16_t *predecessor = AlignToRange(previous, minima, pixel, pixel - X, maxDisp);
+					minCosts = kernels.step(costs + pos, predecessor, minCosts, current, aggregated + pos, nrDisparities, P1, P2);
+					ClearTail(current, nrDisparities, currentExtent);
+					std::swap(previous, current);
+					std::swap(previousExtent, currentExtent);
+				}
+			}
+		});
 	}
-
-	auto value = costVolume[pos] + std::min(temp[posDir], std::min(temp[posDir + 1] + P1, minCosts + P2)) - minCosts;
-	temp[pos_index] = value;
-	aggregatedCosts[pos_index] += value;
-
-	const int64_t end = maxDisp - 1;
-	for (int64_t d = 1; d < end; d++)
+	else if (X == 0)
 	{
-		value = costVolume[pos + d] + std::min(temp[posDir + d], std::min(minCosts + P2, std::min(temp[posDir + d - 1], temp[posDir + d + 1]) + P1));
-		value -= minCosts;
+		// Columns are independent paths, neighbouring columns are advanced together row by row for contiguous accesses
+		GetThreadPool().ParallelFor(0, width, [&](int64_t begin, int64_t end, size_t thread) {
+			uint16_t *previous = pathBuffers[thread].Data() + pathPadding;
+			uint16_t *current = previous + width * pathStride;
+			uint16_t *previousMinima = pathMinimaBuffers[thread].Data();
+			uint16_t *currentMinima = previousMinima + width;
+			std::vector<size_t> extents(2 * static_cast<size_t>(end - begin), static_cast<size_t>(maxDisp));
+			size_t *previousExtents = extents.data();
+			size_t *currentExtents = previousExtents + (end - begin);
+
+			int64_t y = Y > 0 ? 0 : height - 1;
+			for (int64_t x = begin; x < end; x++)
+			{
+				const int64_t pixel = y * width + x;
+				const size_t nrDisparities = count(pixel);
+				uint16_t *path = previous + (x - begin) * pathStride;
+				previousMinima[x - begin] = kernels.start(costs + position(pixel), path, aggregated + position(pixel), nrDisparities);
+				ClearTail(path, nrDisparities, previousExtents[x - begin]);
+			}
 
-		temp[pos_index + d] = value;
-		aggregatedCosts[pos_index + d] += value;
+			for (y += Y; y >= 0 && y < height; y += Y)
+			{
+				for (int64_t x = begin; x < end; x++)
+				{
+					const int64_t pixel = y * width + x;
+					const size_t nrDisparities = count(pixel);
+					const int64_t pos = position(pixel);
+					const int64_t bufferPos = (x - begin) * pathStride;
+					const uint16_t *predecessor = AlignToRange(previous + bufferPos, minima, pixel, pixel - Y * width, maxDisp);
+					currentMinima[x - begin] = kernels.step(costs + pos, predecessor, previousMinima[x - begin], current + bufferPos, aggregated + pos, nrDisparities, P1, P2);
+					ClearTail(current + bufferPos, nrDisparities, currentExtents[x - begin]);
+				}
+				std::swap(previous, current);
+				std::swap(previousMinima, currentMinima);
+				std::swap(previousExtents, currentExtents);
+			}
+		});
 	}
+	else
+	{
+		// Diagonals are independent paths, the first width paths start in the first row of the direction,
+		// the remaining ones in the first column
+		const int64_t startRow = Y > 0 ? 0 : height - 1;
+		const int64_t startColumn = X > 0 ? 0 : width - 1;
+		GetThreadPool().ParallelFor(0, width + height - 1, [&](int64_t begin, int64_t end, size_t thread) {
+			uint16_t *previous = pathBuffers[thread].Data() + pathPadding;
+			uint16_t *current = previous + pathStride;
+			size_t previousExtent = static_cast<size_t>(maxDisp);
+			size_t currentExtent = static_cast<size_t>(maxDisp);
+			for (int64_t i = begin; i < end; i++)
+			{
+				int64_t x = i < width ? i : startColumn;
+				int64_t y = i < width ? startRow : startRow + Y * (i - width + 1);
+
+				int64_t pixel = y * width + x;
+				size_t nrDisparities = count(pixel);
+				uint16_t minCosts = kernels.start(costs + position(pixel), previous, aggregated + position(pixel), nrDisparities);
+				ClearTail(previous, nrDisparities, previousExtent);
+				for (x += X, y += Y; x >= 0 && x < width && y >= 0 && y < height; x += X, y += Y)
+				{
+					pixel = y * width + x;
+					nrDisparities = count(pixel);
+					const int64_t pos = position(pixel);
+					const uint16_t *predecessor = AlignToRange(previous, minima, pixel, pixel - Y * width - X, maxDisp);
+					minCosts = kernels.step(costs + pos, predecessor, minCosts, current, aggregated + pos, nrDisparities, P1, P2);
+					ClearTail(current, nrDisparities, currentExtent);
+					std::swap(previous, current);
+					std::swap(previousExtent, currentExtent);
+				}
+			}
+		});
+	}
+}
 
-	value = costVolume[pos + maxDisp - 1] + std::min(temp[posDir + maxDisp - 1], std::min(temp[posDir + maxDisp - 2] + P1, minCosts + P2));
-	value -= minCosts;
-	temp[pos_index + maxDisp - 1] = value;
-	aggregatedCosts[pos_index + maxDisp - 1] += value;
+void ThunderVision::SemiGlobalMatching::AggregateStreaming(const std::function<void(size_t, uint16_t *)> &computeCostRow, Tensor<unsigned int> &aggregatedCosts, Tensor<float> &minimalDisparities)
+{
+	AggregateStreaming(computeCostRow, _aggregationKernels, aggregatedCosts, minimalDisparities);
 }
 
-inline void ThunderVision::SemiGlobalMatching::CopyCostsToAggregation(const Tensor<uint16_t> &costVolume,
-																	  Tensor<unsigned int> &aggregatedCosts,
-																	  Tensor<unsigned int> &temp,
-																	  const int64_t maxDisp,
-																	  const int64_t pos)
+void ThunderVision::SemiGlobalMatching::AggregateStreaming(const std::function<void(size_t, uint16_t *)> &computeCostRow, Tensor<uint16_t> &aggregatedCosts, Tensor<float> &minimalDisparities)
 {
-	for (int64_t d = 0; d < maxDisp; d++)
-	{
-		temp[pos + d] = costVolume[pos + d];
-		aggregatedCosts[pos + d] += costVolume[pos + d];
-	}
+	AggregateStreaming(computeCostRow, _aggregationKernels16, aggregatedCosts, minimalDisparities);
 }
 
-template <int X, int Y>
-void ThunderVision::SemiGlobalMatching::AggregateCosts(const Tensor<uint16_t> &costVolume, Tensor<unsigned int> &aggregatedCosts, Tensor<unsigned int> &tempBuffer)
+template <typename TAggregated>
+void ThunderVision::SemiGlobalMatching::AggregateStreaming(const std::function<void(size_t, uint16_t *)> &computeCostRow, const AggregationKernels<TAggregated> &kernels, Tensor<TAggregated> &aggregatedCosts, Tensor<float> &minimalDisparities)
 {
-	const int64_t width = static_cast<int64_t>(costVolume.GetDimension(1));
-	const int64_t height = static_cast<int64_t>(costVolume.GetDimension(0));
-	const int64_t size = width * height;
+	THUNDER_PROFILE_SCOPE("StreamingAggregation");
+
+	const size_t rowSize = _width * _maxDisparity;
+	const bool axisPaths = _aggregationDirections != AggregationDirections::Nr4_Diag;
+	const bool diagonalPaths = _aggregationDirections != AggregationDirections::Nr4_Axis;
+	uint16_t *costs = costRow.Data();
 
-	const int64_t maxDisp = static_cast<int64_t>(costVolume.GetDimension(2));
+	// Downward pass over the paths coming from the left and from the top
+	for (size_t y = 0; y < _height; y++)
+	{
+		TAggregated *aggregated = aggregatedCosts.Data() + y * rowSize;
+		std::fill(aggregated, aggregated + rowSize, static_cast<TAggregated>(0));
+		computeCostRow(y, costs);
+
+		const bool firstRow = y == 0;
+		const size_t parity = y & 1;
+		if (axisPaths)
+		{
+			AggregateStreamingRow<1, 0>(costs, kernels, firstRow, parity, aggregated);
+			AggregateStreamingRow<0, 1>(costs, kernels, firstRow, parity, aggregated);
+		}
+		if (diagonalPaths)
+		{
+			AggregateStreamingRow<1, 1>(costs, kernels, firstRow, parity, aggregated);
+			AggregateStreamingRow<-1, 1>(costs, kernels, firstRow, parity, aggregated);
+		}
+	}
 
-	const bool startTop = (Y > 0 || (Y == 0 && X == 1));
-	for (int64_t i = startTop ? 0 : size - 1; startTop ? i < size : i >= 0; startTop ? i++ : i--)
+	// Upward pass over the paths coming from the right and from the bottom, afterwards the aggregated costs of a row are complete
+	for (size_t i = 0; i < _height; i++)
 	{
-		int64_t pos = i * maxDisp;
+		const size_t y = _height - 1 - i;
+		TAggregated *aggregated = aggregatedCosts.Data() + y * rowSize;
+		computeCostRow(y, costs);
 
-		int64_t x = i % width;
-		if ((X > 0 && x == 0) || (X < 0 && x == width - 1))
+		const bool firstRow = i == 0;
+		const size_t parity = i & 1;
+		if (axisPaths)
+		{
+			AggregateStreamingRow<-1, 0>(costs, kernels, firstRow, parity, aggregated);
+			AggregateStreamingRow<0, -1>(costs, kernels, firstRow, parity, aggregated);
+		}
+		if (diagonalPaths)
 		{
-			CopyCostsToAggregation(costVolume, aggregatedCosts, tempBuffer, maxDisp, pos);
-			continue;
+			AggregateStreamingRow<-1, -1>(costs, kernels, firstRow, parity, aggregated);
+			AggregateStreamingRow<1, -1>(costs, kernels, firstRow, parity, aggregated);
 		}
 
-		int64_t y = (i - x) / width;
-		if ((Y > 0 && y == 0) || (Y < 0 && y == height - 1))
+		ComputeMinimalDisparityRow(aggregated, _width, _maxDisparity, minimalDisparities.Data() + y * _width);
+	}
+}
+
+template <int X, int Y, typename TAggregated>
+void ThunderVision::SemiGlobalMatching::AggregateStreamingRow(const uint16_t *costs, const AggregationKernels<TAggregated> &kernels, const bool firstRow, const size_t parity, TAggregated *aggregated)
+{
+	const int64_t width = static_cast<int64_t>(_width);
+	const int64_t maxDisp = static_cast<int64_t>(_maxDisparity);
+
+	if (Y == 0)
+	{
+		uint16_t *previous = pathBuffers[0].Data();
+		uint16_t *current = previous + maxDisp;
+		int64_t x = X > 0 ? 0 : width - 1;
+		uint16_t minCosts = kernels.start(costs + x * maxDisp, previous, aggregated + x * maxDisp, _maxDisparity);
+		for (x += X; x >= 0 && x < width; x += X)
 		{
-			CopyCostsToAggregation(costVolume, aggregatedCosts, tempBuffer, maxDisp, pos);
-			continue;
+			minCosts = kernels.step(costs + x * maxDisp, previous, minCosts, current, aggregated + x * maxDisp, _maxDisparity, P1, P2);
+			std::swap(previous, current);
 		}
+		return;
+	}
+
+	// The buffers are selected by X, the upward and the downward pass reuse them
+	const size_t slot = static_cast<size_t>(X + 1);
+	const size_t rowSize = _width * _maxDisparity;
+	const uint16_t *previous = streamingPathBuffers.Data() + (2 * slot + 1 - parity) * rowSize;
+	uint16_t *current = streamingPathBuffers.Data() + (2 * slot + parity) * rowSize;
+	const uint16_t *previousMinima = streamingPathMinima.Data() + (2 * slot + 1 - parity) * _width;
+	uint16_t *currentMinima = streamingPathMinima.Data() + (2 * slot + parity) * _width;
 
-		int64_t direction = ((-1 * X) + (-1 * Y * width)) * maxDisp;
-		AggregatePositionCost(costVolume, aggregatedCosts, tempBuffer, maxDisp, pos, direction);
+	for (int64_t x = 0; x < width; x++)
+	{
+		const int64_t predecessor = x - X;
+		const int64_t pos = x * maxDisp;
+		if (firstRow || predecessor < 0 || predecessor >= width)
+		{
+			currentMinima[x] = kernels.start(costs + pos, current + pos, aggregated + pos, _maxDisparity);
+		}
+		else
+		{
+			currentMinima[x] = kernels.step(costs + pos, previous + predecessor * maxDisp, previousMinima[predecessor], current + pos, aggregated + pos, _maxDisparity, P1, P2);
+		}
 	}
 }
 
 void ThunderVision::SemiGlobalMatching::ComputeMinimalDisparity(const Tensor<unsigned int> &aggregatedCosts, Tensor<float> &minimalDisparities)
 {
+	ComputeMinimalDisparityImpl(aggregatedCosts, minimalDisparities);
+}
+
+void ThunderVision::SemiGlobalMatching::ComputeMinimalDisparity(const Tensor<uint16_t> &aggregatedCosts, Tensor<float> &minimalDisparities)
+{
+	ComputeMinimalDisparityImpl(aggregatedCosts, minimalDisparities);
+}
+
+template <typename TAggregated>
+void ThunderVision::SemiGlobalMatching::ComputeMinimalDisparityImpl(const Tensor<TAggregated> &aggregatedCosts, Tensor<float> &minimalDisparities)
+{
+	THUNDER_PROFILE_SCOPE("WinnerTakesAll");
 	const size_t height = aggregatedCosts.GetDimension(0);
 	const size_t width = aggregatedCosts.GetDimension(1);
 	const size_t maxDisp = aggregatedCosts.GetDimension(2);
 
-	size_t d = 0;
-	for (size_t i = 0, cost_pos = 0; i < width * height; i++, cost_pos += maxDisp)
-	{
-		unsigned int minCost = std::numeric_limits<unsigned int>::max();
-		size_t minDisparity = 0;
-		for (d = 0; d < maxDisp; d++)
+	GetThreadPool().ParallelFor(0, static_cast<int64_t>(height), [&](int64_t begin, int64_t end, size_t) {
+		for (int64_t y = begin; y < end; y++)
 		{
-			auto value = aggregatedCosts[cost_pos + d];
+			ComputeMinimalDisparityRow(aggregatedCosts.Data() + y * width * maxDisp, width, maxDisp, minimalDisparities.Data() + y * width);
+		}
+	});
+}
+
+template <typename TAggregated>
+void ThunderVision::SemiGlobalMatching::ComputeMinimalDisparityRow(const TAggregated *aggregated, const size_t width, const size_t maxDisp, float *minimalDisparities)
+{
+	if constexpr (std::is_same<TAggregated, uint16_t>::value)
+		_winnerTakesAllKernels16.disparities(aggregated, width, maxDisp, maxDisp, _winnerTakesAllParameters, minimalDisparities);
+	else
+		_winnerTakesAllKernels.disparities(aggregated, width, maxDisp, maxDisp, _winnerTakesAllParameters, minimalDisparities);
+}
 
-			if (value < minCost)
+template <typename TAggregated>
+void ThunderVision::SemiGlobalMatching::ComputeMinimalDisparity(const Tensor<TAggregated> &aggregatedCosts, const DisparityRanges &ranges, Tensor<float> &minimalDisparities)
+{
+	THUNDER_PROFILE_SCOPE("WinnerTakesAll");
+	const size_t width = ranges.GetWidth();
+	GetThreadPool().ParallelFor(0, static_cast<int64_t>(ranges.GetHeight()), [&](int64_t begin, int64_t end, size_t) {
+		for (size_t pixel = static_cast<size_t>(begin) * width; pixel < static_cast<size_t>(end) * width; pixel++)
+		{
+			// The padded disparities behind the count are skipped, pixels with empty ranges have no disparity
+			if (ranges.GetCounts()[pixel] == 0)
 			{
-				minCost = value;
-				minDisparity = d;
+				minimalDisparities[pixel] = _winnerTakesAllParameters.invalidValue;
+				continue;
 			}
+			const TAggregated *aggregated = aggregatedCosts.Data() + ranges.GetOffsets()[pixel];
+			ComputeMinimalDisparityRow(aggregated, 1, ranges.GetCounts()[pixel], minimalDisparities.Data() + pixel);
+			if (minimalDisparities[pixel] != _winnerTakesAllParameters.invalidValue)
+				minimalDisparities[pixel] += static_cast<float>(ranges.GetMinima()[pixel]);
 		}
+	});
+}
 
-		minimalDisparities[i] = static_cast<float>(minDisparity);
+template <typename TAggregated>
+void ThunderVision::SemiGlobalMatching::ComputeRightDisparities(const Tensor<TAggregated> &aggregatedCosts)
+{
+	THUNDER_PROFILE_SCOPE("RightWinnerTakesAll");
+	const size_t height = aggregatedCosts.GetDimension(0);
+	const size_t width = aggregatedCosts.GetDimension(1);
+	const size_t maxDisp = aggregatedCosts.GetDimension(2);
+	const size_t bufferSize = 2 * (width + maxDisp);
+	if (rightDisparities.GetDimensions() != std::vector<size_t>{height, width})
+		rightDisparities.Resize({height, width});
+
+	Tensor<TAggregated> *buffers;
+	if constexpr (std::is_same<TAggregated, uint16_t>::value)
+		buffers = &rightSelectionBuffers16;
+	else
+		buffers = &rightSelectionBuffers;
+	if (buffers->GetDimensions() != std::vector<size_t>{GetThreadPool().GetNrThreads(), bufferSize})
+		buffers->Resize({GetThreadPool().GetNrThreads(), bufferSize});
+
+	GetThreadPool().ParallelFor(0, static_cast<int64_t>(height), [&](int64_t begin, int64_t end, size_t thread) {
+		for (int64_t y = begin; y < end; y++)
+		{
+			const TAggregated *aggregated = aggregatedCosts.Data() + y * width * maxDisp;
+			if constexpr (std::is_same<TAggregated, uint16_t>::value)
+				_winnerTakesAllKernels16.rightDisparities(aggregated, width, maxDisp, _winnerTakesAllParameters, buffers->Data() + thread * bufferSize, rightDisparities.Data() + y * width);
+			else
+				_winnerTakesAllKernels.rightDisparities(aggregated, width, maxDisp, _winnerTakesAllParameters, buffers->Data() + thread * bufferSize, rightDisparities.Data() + y * width);
+		}
+	});
+}
+
+template void ThunderVision::SemiGlobalMatching::ComputeRightDisparities<unsigned int>(const Tensor<unsigned int> &);
+template void ThunderVision::SemiGlobalMatching::ComputeRightDisparities<uint16_t>(const Tensor<uint16_t> &);
+
+void ThunderVision::SemiGlobalMatching::ToFixedPoint(const Tensor<float> &disparities, Tensor<uint16_t> &fixedDisparities) const
+{
+	if (fixedDisparities.GetDimensions() != disparities.GetDimensions())
+		fixedDisparities.Resize(disparities.GetDimensions());
+
+	constexpr float scale = 1 << DisparityFractionBits;
+	for (size_t i = 0; i < disparities.GetTotalSize(); i++)
+	{
+		const float disparity = disparities[i];
+		if (disparity == std::numeric_limits<float>::max())
+			fixedDisparities[i] = UINT16_MAX;
+		else
+			fixedDisparities[i] = static_cast<uint16_t>(std::min(std::lround(disparity * scale), static_cast<long>(UINT16_MAX - 1)));
 	}
 }
 
+void ThunderVision::SemiGlobalMatching::ComputeDisparitiesFromCensus(const Tensor<uint64_t> &censusLeftImage, const Tensor<uint64_t> &censusRightImage, Tensor<float> &disparities)
+{
+	if (censusLeftImage.GetRank() != 2 || censusLeftImage.GetDimensions() != censusRightImage.GetDimensions())
+		throw new ThunderException("The CENSUS images have to be 2D tensors of the same size.");
+	if (_hierarchicalLevels > 1 || _compactCostVolume || _rowStreaming)
+		throw new ThunderException("Disparities of CENSUS images require the dense cost volume without row streaming.");
+
+	if (!prepared || censusLeftImage.GetDimension(0) != _height || censusLeftImage.GetDimension(1) != _width)
+		Prepare(censusLeftImage.GetDimension(1), censusLeftImage.GetDimension(0));
+
+	if (!_consistencyCheck)
+	{
+		ComputeMinimalMatchingCostImage<MatchingDirection::lr>(censusLeftImage, censusRightImage, _maxDisparity, disparities);
+		return;
+	}
+
+	ComputeMinimalMatchingCostImage<MatchingDirection::lr>(censusLeftImage, censusRightImage, _maxDisparity, filteredLeft);
+	if (_consistencyMode == ConsistencyMode::Diagonal)
+	{
+		THUNDER_PROFILE_SCOPE("Median");
+		_medianFilter.ApplyMedianFilter<3, 3>(TensorView<const float>(rightDisparities), filteredRight, GetThreadPool());
+	}
+	else
+		ComputeMinimalMatchingCostImage<MatchingDirection::rl>(censusLeftImage, censusRightImage, _maxDisparity, filteredRight);
+	LeftToRightConsistencyCheck(filteredLeft, filteredRight, 1.1f, disparities);
+}
+
+ThunderVision::Tensor<float> ThunderVision::SemiGlobalMatching::ComputeColorDisparities(const TensorView<const uint8_t> &leftImage, const TensorView<const uint8_t> &rightImage)
+{
+	if (leftImage.GetDimensions() != rightImage.GetDimensions())
+		throw new ThunderException("The left and the right image have to be of the same size.");
+
+	if (_hierarchicalLevels > 1 || _rowStreaming)
+	{
+		ColorspaceConversion::ConvertToGrayscale(leftImage, grayscaleLeft, _grayscaleWeights, GetThreadPool(), _maxSimdLevel);
+		ColorspaceConversion::ConvertToGrayscale(rightImage, grayscaleRight, _grayscaleWeights, GetThreadPool(), _maxSimdLevel);
+		return ComputeDisparities(TensorView<const uint8_t>(grayscaleLeft), TensorView<const uint8_t>(grayscaleRight));
+	}
+
+	if (!prepared || leftImage.GetDimension(0) != _height || leftImage.GetDimension(1) != _width)
+		Prepare(leftImage.GetDimension(1), leftImage.GetDimension(0));
+
+	{
+		THUNDER_PROFILE_SCOPE("Census");
+		_censusTransform.ComputeFromRGB(leftImage, censusLeft, _grayscaleWeights, GetThreadPool(), _maxSimdLevel);
+		_censusTransform.ComputeFromRGB(rightImage, censusRight, _grayscaleWeights, GetThreadPool(), _maxSimdLevel);
+	}
+	if (_compactCostVolume)
+		return ComputeCompactDisparities();
+
+	Tensor<float> disparities;
+	ComputeDisparitiesFromCensus(censusLeft, censusRight, disparities);
+	return disparities;
+}
+
 ThunderVision::Tensor<float> ThunderVision::SemiGlobalMatching::LeftToRightConsistencyCheck(const Tensor<float> &leftDisparityImage, const Tensor<float> &rightDisparityImage, const float epsilon)
 {
+	Tensor<float> consistencyCheckedImage;
+	LeftToRightConsistencyCheck(leftDisparityImage, rightDisparityImage, epsilon, consistencyCheckedImage);
+	return consistencyCheckedImage;
+}
+
+void ThunderVision::SemiGlobalMatching::LeftToRightConsistencyCheck(const Tensor<float> &leftDisparityImage, const Tensor<float> &rightDisparityImage, const float epsilon, Tensor<float> &consistencyCheckedImage)
+{
+	THUNDER_PROFILE_SCOPE("ConsistencyCheck");
 	float disparityValueLeft, disparityValueRight;
 
 	const int64_t width = static_cast<int64_t>(leftDisparityImage.GetDimension(1));
 	const int64_t height = static_cast<int64_t>(leftDisparityImage.GetDimension(0));
 
-	Tensor<float> consistencyCheckedImage({leftDisparityImage.GetDimension(0), leftDisparityImage.GetDimension(1)});
+	if (consistencyCheckedImage.GetDimensions() != std::vector<size_t>{leftDisparityImage.GetDimension(0), leftDisparityImage.GetDimension(1)})
+		consistencyCheckedImage.Resize({leftDisparityImage.GetDimension(0), leftDisparityImage.GetDimension(1)});
 
 	int64_t posLeft = 0;
 	int64_t x, posRight;
@@ -188,6 +868,12 @@ ThunderVision::Tensor<float> ThunderVision::SemiGlobalMatching::LeftToRightConsi
 		for (x = 0; x < width; x++, posLeft++)
 		{
 			disparityValueLeft = leftDisparityImage[posLeft];
+			// Invalid disparities stay invalid, they would average to infinity with an invalid right disparity
+			if (disparityValueLeft == std::numeric_limits<float>::max())
+			{
+				consistencyCheckedImage[posLeft] = disparityValueLeft;
+				continue;
+			}
 
 			int new_x = static_cast<int>(static_cast<float>(x) - disparityValueLeft);
 			posRight = posLeft + (new_x - x);
@@ -209,5 +895,128 @@ ThunderVision::Tensor<float> ThunderVision::SemiGlobalMatching::LeftToRightConsi
 			}
 		}
 	}
-	return consistencyCheckedImage;
+}
+
+
+ThunderVision::Tensor<float> ThunderVision::SemiGlobalMatching::ComputeCompactDisparities()
+{
+	const bool restricted = _rangeMinima.GetTotalSize() > 0;
+	if (restricted && _rangeMinima.GetDimensions() != std::vector<size_t>{_height, _width})
+		throw new ThunderException("The disparity ranges have to be of the size of the images.");
+
+	leftRanges.Resize(_width, _height);
+	SetLeftRanges(restricted ? &_rangeMinima : nullptr, restricted ? &_rangeMaxima : nullptr, _maxDisparity, leftRanges);
+	leftRanges.UpdateOffsets();
+	return ComputeRangeDisparities(_consistencyCheck);
+}
+
+ThunderVision::Tensor<float> ThunderVision::SemiGlobalMatching::ComputeBandedDisparities(const Tensor<float> &coarseDisparities, const bool finestLevel)
+{
+	const size_t width = censusLeft.GetDimension(1);
+	const size_t height = censusLeft.GetDimension(0);
+	const size_t levelMaxDisparity = std::max<size_t>(1, (_maxDisparity * width + _width - 1) / _width);
+
+	// The coarsest level searches the whole range, as do levels whose range fits into the band
+	leftRanges.Resize(width, height);
+	if (coarseDisparities.GetTotalSize() == 0 || levelMaxDisparity <= _disparityBand)
+		SetLeftRanges(nullptr, nullptr, levelMaxDisparity, leftRanges);
+	else
+		SetBandRanges(coarseDisparities, _disparityBand, levelMaxDisparity, leftRanges);
+	leftRanges.UpdateOffsets();
+
+	return ComputeRangeDisparities(finestLevel && _consistencyCheck);
+}
+
+ThunderVision::Tensor<float> ThunderVision::SemiGlobalMatching::ComputeRangeDisparities(const bool consistencyCheck)
+{
+	auto disparitiesLeft = ComputeCompactMatchingCostImage<MatchingDirection::lr>(leftRanges);
+	if (!consistencyCheck)
+		return disparitiesLeft;
+
+	rightRanges.Resize(leftRanges.GetWidth(), leftRanges.GetHeight());
+	SetRightRanges(leftRanges, rightRanges);
+	rightRanges.UpdateOffsets();
+	auto disparitiesRight = ComputeCompactMatchingCostImage<MatchingDirection::rl>(rightRanges);
+	return LeftToRightConsistencyCheck(disparitiesLeft, disparitiesRight, 1.1f);
+}
+
+template <ThunderVision::MatchingDirection direction>
+ThunderVision::Tensor<float> ThunderVision::SemiGlobalMatching::ComputeCompactMatchingCostImage(const DisparityRanges &ranges)
+{
+	const size_t width = ranges.GetWidth();
+	const size_t height = ranges.GetHeight();
+	const size_t maxCount = ranges.GetMaxCount();
+	if (costVolume.GetDimensions() != std::vector<size_t>{ranges.GetTotalSize()})
+		costVolume.Resize({ranges.GetTotalSize()});
+
+	// Costs[d] of a pixel belong to disparity minimum + d, disparities whose matching pixel lies outside of the image and the padding keep the error value
+	{
+		THUNDER_PROFILE_SCOPE("CostVolume");
+		GetThreadPool().ParallelFor(0, static_cast<int64_t>(height), [&](int64_t begin, int64_t end, size_t) {
+			for (int64_t y = begin; y < end; y++)
+			{
+				const uint64_t *left = censusLeft.Data() + y * width;
+				const uint64_t *right = censusRight.Data() + y * width;
+				for (size_t x = 0, pixel = y * width; x < width; x++, pixel++)
+				{
+					const size_t minimum = static_cast<size_t>(ranges.GetMinima()[pixel]);
+					const size_t rangeCount = ranges.GetCounts()[pixel];
+					uint16_t *costs = costVolume.Data() + ranges.GetOffsets()[pixel];
+					size_t count = 0;
+					if constexpr (direction == MatchingDirection::lr)
+					{
+						if (left[x] != invalid_census_value && x >= minimum)
+						{
+							count = std::min(rangeCount, x - minimum + 1);
+							_hammingKernels.backward(left[x], right + x - minimum, count, costs);
+						}
+					}
+					else
+					{
+						if (right[x] != invalid_census_value && x + minimum < width)
+						{
+							count = std::min(rangeCount, width - x - minimum);
+							_hammingKernels.forward(right[x], left + x + minimum, count, costs);
+						}
+					}
+					std::fill(costs + count, costs + DisparityRanges::PadCount(rangeCount), errorPixelValue);
+				}
+			}
+		});
+	}
+
+	// Path buffers padded by the largest count on both sides, see AlignToRange
+	for (size_t i = 0; i < pathBuffers.size(); i++)
+	{
+		if (pathBuffers[i].GetDimensions() != std::vector<size_t>{2, width, 3 * maxCount})
+			pathBuffers[i].Resize({2, width, 3 * maxCount});
+		pathBuffers[i].Fill(UINT16_MAX);
+		if (pathMinimaBuffers[i].GetDimensions() != std::vector<size_t>{2, width})
+			pathMinimaBuffers[i].Resize({2, width});
+	}
+	_aggregationKernels = SelectAggregationKernels<unsigned int>(DisparityRanges::Granularity, _maxSimdLevel);
+	_aggregationKernels16 = SelectAggregationKernels<uint16_t>(DisparityRanges::Granularity, _maxSimdLevel);
+
+	if (minimalDisparities.GetDimensions() != std::vector<size_t>{height, width})
+		minimalDisparities.Resize({height, width});
+
+	_ranges = &ranges;
+	if (_costStorage == CostStorage::UInt16Saturated)
+	{
+		if (aggregatedCosts16.GetDimensions() != costVolume.GetDimensions())
+			aggregatedCosts16.Resize(costVolume.GetDimensions());
+		AggregateCosts(costVolume, aggregatedCosts16);
+		ComputeMinimalDisparity(aggregatedCosts16, ranges, minimalDisparities);
+	}
+	else
+	{
+		if (aggregatedCosts.GetDimensions() != costVolume.GetDimensions())
+			aggregatedCosts.Resize(costVolume.GetDimensions());
+		AggregateCosts(costVolume, aggregatedCosts);
+		ComputeMinimalDisparity(aggregatedCosts, ranges, minimalDisparities);
+	}
+	_ranges = nullptr;
+
+	THUNDER_PROFILE_SCOPE("Median");
+	return _medianFilter.ApplyMedianFilter<3, 3>(minimalDisparities, GetThreadPool());
 }
@@ -0,0 +1,463 @@
+#include "SeparableFilter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Exceptions.h"
+#include "FilterUtil.h"
+
+namespace
+{
+using ThunderVision::BorderMode;
+
+/**
+* Converts source row r of the image with radius border pixels on each side into padded. Rows and columns outside
+* the image follow the border mode, fill is the converted constant border value.
+*/
+template <typename T, typename TBuffer, typename TLoad>
+void LoadPaddedRow(const ThunderVision::TensorView<const T> &input, const int64_t r, const int64_t radius, const BorderMode border, const TBuffer fill, TLoad load,
+				   TBuffer *padded)
+{
+	const int64_t height = static_cast<int64_t>(input.GetDimension(0));
+	const int64_t width = static_cast<int64_t>(input.GetDimension(1));
+	const int64_t channels = input.GetRank() == 3 ? static_cast<int64_t>(input.GetDimension(2)) : 1;
+	const int64_t strideX = input.GetStride(1);
+	const int64_t strideC = input.GetRank() == 3 ? input.GetStride(2) : 0;
+	const int64_t rowLength = width * channels;
+
+	const int64_t y = ThunderVision::FilterUtil::BorderIndex(r, height, border);
+	if (y < 0)
+	{
+		std::fill(padded, padded + rowLength + 2 * radius * channels, fill);
+		return;
+	}
+
+	const T *source = input.Data() + y * input.GetStride(0);
+	TBuffer *interior = padded + radius * channels;
+	if (strideC == 1 && strideX == channels)
+	{
+		for (int64_t i = 0; i < rowLength; i++)
+		{
+			interior[i] = load(source[i]);
+		}
+	}
+	else
+	{
+		for (int64_t x = 0; x < width; x++)
+		{
+			for (int64_t c = 0; c < channels; c++)
+			{
+				interior[x * channels + c] = load(source[x * strideX + c * strideC]);
+			}
+		}
+	}
+	for (int64_t x = 1; x <= radius; x++)
+	{
+		const int64_t left = ThunderVision::FilterUtil::BorderIndex(-x, width, border);
+		const int64_t right = ThunderVision::FilterUtil::BorderIndex(width - 1 + x, width, border);
+		for (int64_t c = 0; c < channels; c++)
+		{
+			interior[-x * channels + c] = left < 0 ? fill : load(source[left * strideX + c * strideC]);
+			interior[(width - 1 + x) * channels + c] = right < 0 ? fill : load(source[right * strideX + c * strideC]);
+		}
+	}
+}
+
+/**
+* Resizes buffer to one 64 byte aligned block of perThread elements for every thread of the pool.
+*/
+template <typename TBuffer>
+size_t ReserveThreadBuffers(ThunderVision::Tensor<TBuffer> &buffer, const size_t perThread, ThunderVision::ThreadPool &pool)
+{
+	const size_t blockAlignment = ThunderVision::TensorAlignment / sizeof(TBuffer);
+	const size_t alignedPerThread = (perThread + blockAlignment - 1) / blockAlignment * blockAlignment;
+	const std::vector<size_t> bufferDimensions = {pool.GetNrThreads(), alignedPerThread};
+	if (buffer.GetDimensions() != bufferDimensions)
+		buffer.Resize(bufferDimensions);
+	return alignedPerThread;
+}
+
+// Strips of several kernel heights keep the rows filtered twice at the strip borders negligible
+int64_t StripHeight(const size_t tapsY)
+{
+	return std::max<int64_t>(32, 8 * static_cast<int64_t>(tapsY));
+}
+
+/**
+* Filters the image strip by strip. load converts a pixel to the buffer type, horizontal(row, length, out) filters a
+* padded row and storeRow(rows, y, scratch) computes output row y from the kernelY.size horizontally filtered rows.
+*/
+template <typename T, typename TBuffer, typename TLoad, typename THorizontal, typename TStoreRow>
+void FilterStrips(const ThunderVision::TensorView<const T> &input, const size_t tapsX, const size_t tapsY, const BorderMode border, const TBuffer fill,
+				  ThunderVision::Tensor<TBuffer> &buffer, ThunderVision::ThreadPool &pool, TLoad load, THorizontal horizontal, TStoreRow storeRow)
+{
+	const int64_t height = static_cast<int64_t>(input.GetDimension(0));
+	const int64_t width = static_cast<int64_t>(input.GetDimension(1));
+	const int64_t channels = input.GetRank() == 3 ? static_cast<int64_t>(input.GetDimension(2)) : 1;
+
+	const int64_t radiusX = static_cast<int64_t>(tapsX - 1) / 2;
+	const int64_t radiusY = static_cast<int64_t>(tapsY - 1) / 2;
+	const size_t rowLength = static_cast<size_t>(width * channels);
+	const size_t paddedLength = (static_cast<size_t>(width) + tapsX - 1) * static_cast<size_t>(channels);
+
+	// Padded row, ring of horizontally filtered rows and a scratch row per thread
+	const size_t perThread = ReserveThreadBuffers(buffer, paddedLength + (tapsY + 1) * rowLength, pool);
+
+	const int64_t stripHeight = StripHeight(tapsY);
+	const int64_t nrStrips = (height + stripHeight - 1) / stripHeight;
+
+	pool.ParallelFor(0, nrStrips, [&](int64_t stripBegin, int64_t stripEnd, size_t threadIndex) {
+		TBuffer *padded = buffer.Data() + threadIndex * perThread;
+		TBuffer *ring = padded + paddedLength;
+		TBuffer *scratch = ring + tapsY * rowLength;
+		std::vector<const TBuffer *> rows(tapsY);
+
+		for (int64_t strip = stripBegin; strip < stripEnd; strip++)
+		{
+			const int64_t yBegin = strip * stripHeight;
+			const int64_t yEnd = std::min(height, yBegin + stripHeight);
+
+			// Source row r goes to ring slot (r - yBegin + radiusY) % tapsY
+			auto filterRow = [&](const int64_t r) {
+				LoadPaddedRow(input, r, radiusX, border, fill, load, padded);
+				horizontal(padded, rowLength, ring + static_cast<size_t>(r - yBegin + radiusY) % tapsY * rowLength);
+			};
+
+			for (int64_t r = yBegin - radiusY; r < yBegin + radiusY; r++)
+			{
+				filterRow(r);
+			}
+			for (int64_t y = yBegin; y < yEnd; y++)
+			{
+				filterRow(y + radiusY);
+				for (size_t k = 0; k < tapsY; k++)
+				{
+					rows[k] = ring + static_cast<size_t>(y - yBegin + static_cast<int64_t>(k)) % tapsY * rowLength;
+				}
+				storeRow(rows.data(), y, scratch);
+			}
+		}
+	});
+}
+
+/**
+* Like FilterStrips for a 2D kernel of kernelHeight rows: the ring holds the padded source rows and
+* horizontal(i, row, length, out) filters a padded row with kernel row i. storeRow sums the kernelHeight results.
+*/
+template <typename T, typename TBuffer, typename TLoad, typename THorizontal, typename TStoreRow>
+void Filter2DStrips(const ThunderVision::TensorView<const T> &input, const size_t kernelWidth, const size_t kernelHeight, const BorderMode border, const TBuffer fill,
+					ThunderVision::Tensor<TBuffer> &buffer, ThunderVision::ThreadPool &pool, TLoad load, THorizontal horizontal, TStoreRow storeRow)
+{
+	const int64_t height = static_cast<int64_t>(input.GetDimension(0));
+	const int64_t width = static_cast<int64_t>(input.GetDimension(1));
+	const int64_t channels = input.GetRank() == 3 ? static_cast<int64_t>(input.GetDimension(2)) : 1;
+
+	const int64_t radiusX = static_cast<int64_t>(kernelWidth - 1) / 2;
+	const int64_t radiusY = static_cast<int64_t>(kernelHeight - 1) / 2;
+	const size_t rowLength = static_cast<size_t>(width * channels);
+	const size_t paddedLength = (static_cast<size_t>(width) + kernelWidth - 1) * static_cast<size_t>(channels);
+
+	// Ring of padded rows, the filtered rows and a scratch row per thread
+	const size_t perThread = ReserveThreadBuffers(buffer, kernelHeight * (paddedLength + rowLength) + rowLength, pool);
+
+	const int64_t stripHeight = StripHeight(kernelHeight);
+	const int64_t nrStrips = (height + stripHeight - 1) / stripHeight;
+
+	pool.ParallelFor(0, nrStrips, [&](int64_t stripBegin, int64_t stripEnd, size_t threadIndex) {
+		TBuffer *ring = buffer.Data() + threadIndex * perThread;
+		TBuffer *filtered = ring + kernelHeight * paddedLength;
+		TBuffer *scratch = filtered + kernelHeight * rowLength;
+		std::vector<const TBuffer *> rows(kernelHeight);
+		for (size_t i = 0; i < kernelHeight; i++)
+		{
+			rows[i] = filtered + i * rowLength;
+		}
+
+		for (int64_t strip = stripBegin; strip < stripEnd; strip++)
+		{
+			const int64_t yBegin = strip * stripHeight;
+			const int64_t yEnd = std::min(height, yBegin + stripHeight);
+
+			// Source row r goes to ring slot (r - yBegin + radiusY) % kernelHeight
+			auto slot = [&](const int64_t r) { return ring + static_cast<size_t>(r - yBegin + radiusY) % kernelHeight * paddedLength; };
+
+			for (int64_t r = yBegin - radiusY; r < yBegin + radiusY; r++)
+			{
+				LoadPaddedRow(input, r, radiusX, border, fill, load, slot(r));
+			}
+			for (int64_t y = yBegin; y < yEnd; y++)
+			{
+				LoadPaddedRow(input, y + radiusY, radiusX, border, fill, load, slot(y + radiusY));
+				for (size_t i = 0; i < kernelHeight; i++)
+				{
+					horizontal(i, slot(y - radiusY + static_cast<int64_t>(i)), rowLength, filtered + i * rowLength);
+				}
+				storeRow(rows.data(), y, scratch);
+			}
+		}
+	});
+}
+
+std::vector<float> ToFloatWeights(const ThunderVision::Tensor<double> &kernel)
+{
+	std::vector<float> weights(kernel.GetTotalSize());
+	for (size_t i = 0; i < weights.size(); i++)
+	{
+		weights[i] = static_cast<float>(kernel[i]);
+	}
+	return weights;
+}
+
+std::vector<int16_t> ToFixedWeights(const ThunderVision::Tensor<double> &kernel)
+{
+	std::vector<int16_t> weights(kernel.GetTotalSize());
+	for (size_t i = 0; i < weights.size(); i++)
+	{
+		const double scaled = std::round(kernel[i] * (1 << ThunderVision::FilterFixedWeightBits));
+		weights[i] = static_cast<int16_t>(std::min(std::max(scaled, -32768.0), 32767.0));
+	}
+	return weights;
+}
+
+// The fixed point pixels have to stay in int16_t after each pass: 255 * 2^6 * sum |w| < 2^15
+bool FitsFixedPoint(const ThunderVision::Tensor<double> &kernelX, const ThunderVision::Tensor<double> &kernelY)
+{
+	double sumX = 0.0;
+	double sumY = 0.0;
+	for (size_t i = 0; i < kernelX.GetTotalSize(); i++)
+	{
+		if (std::abs(kernelX[i]) >= 1.0)
+			return false;
+		sumX += std::abs(kernelX[i]);
+	}
+	for (size_t i = 0; i < kernelY.GetTotalSize(); i++)
+	{
+		if (std::abs(kernelY[i]) >= 1.0)
+			return false;
+		sumY += std::abs(kernelY[i]);
+	}
+	return sumX * sumY < 1.9;
+}
+
+/**
+* Sum of the absolute weights if all weights are integers, otherwise -1.
+*/
+double IntegerWeightSum(const ThunderVision::Tensor<double> &kernel)
+{
+	double sum = 0.0;
+	for (size_t i = 0; i < kernel.GetTotalSize(); i++)
+	{
+		if (kernel[i] != std::round(kernel[i]))
+			return -1.0;
+		sum += std::abs(kernel[i]);
+	}
+	return sum;
+}
+
+// uint8_t pixels filtered with integer weights are exact in int16_t if 255 * sum |w| < 2^15
+bool FitsInteger(const double weightSum)
+{
+	return weightSum >= 0.0 && 255.0 * weightSum <= 32767.0;
+}
+
+std::vector<int16_t> ToIntWeights(const ThunderVision::Tensor<double> &kernel)
+{
+	std::vector<int16_t> weights(kernel.GetTotalSize());
+	for (size_t i = 0; i < weights.size(); i++)
+	{
+		weights[i] = static_cast<int16_t>(kernel[i]);
+	}
+	return weights;
+}
+
+/**
+* Writes a row of filter results to the output type, rounded and saturated.
+*/
+template <typename TBuffer, typename TOut>
+void StoreRow(const TBuffer *values, const size_t length, TOut *out)
+{
+	for (size_t i = 0; i < length; i++)
+	{
+		out[i] = ThunderVision::FilterUtil::RoundAndSaturate<TOut>(static_cast<float>(values[i]));
+	}
+}
+
+template <typename TIn, typename TOut>
+void ValidateInput(const ThunderVision::TensorView<const TIn> &input, ThunderVision::Tensor<TOut> &output)
+{
+	static_assert(ThunderVision::SeparableFilter::IsSupported<TIn>(), "The input type is not supported");
+	static_assert(ThunderVision::SeparableFilter::IsSupportedOutput<TOut>(), "The output type is not supported");
+	if (input.GetRank() != 3 && input.GetRank() != 2)
+		throw new ThunderVision::ThunderException("At the moment only 2D and 3D tensors are supported");
+
+	const std::vector<size_t> outputDimensions = {input.GetDimension(0), input.GetDimension(1), input.GetRank() == 3 ? input.GetDimension(2) : 1};
+	if (output.GetDimensions() != outputDimensions)
+		output.Resize(outputDimensions);
+}
+} // namespace
+
+ThunderVision::SeparableFilter::SeparableFilter(const SimdLevel maxLevel)
+{
+	_kernels = SelectSeparableFilterKernels(maxLevel);
+}
+
+template <typename TIn, typename TOut>
+void ThunderVision::SeparableFilter::Apply(const TensorView<const TIn> &input, const Tensor<double> &kernelX, const Tensor<double> &kernelY, Tensor<TOut> &output,
+										   const BorderMode border, const double borderValue, ThreadPool &pool)
+{
+	if (kernelX.GetRank() != 1 || kernelY.GetRank() != 1)
+		throw new ThunderException("The kernels have to be 1D");
+	if (kernelX.GetDimension(0) % 2 != 1 || kernelY.GetDimension(0) % 2 != 1)
+		throw new ThunderException("The kernel sizes have to be uneven");
+	ValidateInput(input, output);
+	if (output.GetTotalSize() == 0)
+		return;
+
+	const size_t tapsX = kernelX.GetDimension(0);
+	const size_t tapsY = kernelY.GetDimension(0);
+	const size_t channels = output.GetDimension(2);
+	const size_t rowLength = output.GetDimension(1) * channels;
+	const SeparableFilterKernels kernels = _kernels;
+	const TIn fill = FilterUtil::RoundAndSaturate<TIn>(static_cast<float>(borderValue));
+
+	if constexpr (std::is_same<TIn, uint8_t>::value)
+	{
+		if constexpr (std::is_same<TOut, uint8_t>::value)
+		{
+			if (FitsFixedPoint(kernelX, kernelY))
+			{
+				const std::vector<int16_t> weightsX = ToFixedWeights(kernelX);
+				const std::vector<int16_t> weightsY = ToFixedWeights(kernelY);
+				auto load = [](const uint8_t value) { return static_cast<int16_t>(value << FilterFixedPixelBits); };
+				FilterStrips(
+					input, tapsX, tapsY, border, load(fill), _fixedBuffer, pool, load,
+					[&](const int16_t *row, size_t length, int16_t *out) { kernels.horizontalFixed(row, length, weightsX.data(), tapsX, channels, out); },
+					[&](const int16_t *const *rows, int64_t y, int16_t *) { kernels.verticalFixed(rows, weightsY.data(), tapsY, rowLength, output.Data() + y * rowLength); });
+				return;
+			}
+		}
+
+		// The int16_t arithmetic wraps, so only the final sum has to fit
+		const double sumX = IntegerWeightSum(kernelX);
+		const double sumY = IntegerWeightSum(kernelY);
+		if (sumX >= 0.0 && sumY >= 0.0 && FitsInteger(sumX * sumY))
+		{
+			const std::vector<int16_t> weightsX = ToIntWeights(kernelX);
+			const std::vector<int16_t> weightsY = ToIntWeights(kernelY);
+			auto load = [](const uint8_t value) { return static_cast<int16_t>(value); };
+			FilterStrips(
+				input, tapsX, tapsY, border, load(fill), _fixedBuffer, pool, load,
+				[&](const int16_t *row, size_t length, int16_t *out) { kernels.horizontalInt(row, length, weightsX.data(), tapsX, channels, out); },
+				[&](const int16_t *const *rows, int64_t y, int16_t *scratch) {
+					if constexpr (std::is_same<TOut, int16_t>::value)
+					{
+						kernels.verticalInt(rows, weightsY.data(), tapsY, rowLength, output.Data() + y * rowLength);
+					}
+					else
+					{
+						kernels.verticalInt(rows, weightsY.data(), tapsY, rowLength, scratch);
+						StoreRow(scratch, rowLength, output.Data() + y * rowLength);
+					}
+				});
+			return;
+		}
+	}
+
+	const std::vector<float> weightsX = ToFloatWeights(kernelX);
+	const std::vector<float> weightsY = ToFloatWeights(kernelY);
+	FilterStrips(
+		input, tapsX, tapsY, border, static_cast<float>(fill), _floatBuffer, pool, [](const TIn value) { return static_cast<float>(value); },
+		[&](const float *row, size_t length, float *out) { kernels.horizontalFloat(row, length, weightsX.data(), tapsX, channels, out); },
+		[&](const float *const *rows, int64_t y, float *scratch) {
+			if constexpr (std::is_same<TOut, float>::value)
+			{
+				kernels.verticalFloat(rows, weightsY.data(), tapsY, rowLength, output.Data() + y * rowLength);
+			}
+			else
+			{
+				kernels.verticalFloat(rows, weightsY.data(), tapsY, rowLength, scratch);
+				FilterUtil::RoundAndSaturate(kernels, scratch, rowLength, output.Data() + y * rowLength);
+			}
+		});
+}
+
+template <typename TIn, typename TOut>
+void ThunderVision::SeparableFilter::Apply2D(const TensorView<const TIn> &input, const Tensor<double> &kernel, Tensor<TOut> &output, const BorderMode border,
+											 const double borderValue, ThreadPool &pool)
+{
+	if (kernel.GetRank() != 2)
+		throw new ThunderException("The kernel has to be 2D");
+	if (kernel.GetDimension(0) % 2 != 1 || kernel.GetDimension(1) % 2 != 1)
+		throw new ThunderException("The kernel sizes have to be uneven");
+	ValidateInput(input, output);
+	if (output.GetTotalSize() == 0)
+		return;
+
+	const size_t kernelHeight = kernel.GetDimension(0);
+	const size_t kernelWidth = kernel.GetDimension(1);
+	const size_t channels = output.GetDimension(2);
+	const size_t rowLength = output.GetDimension(1) * channels;
+	const SeparableFilterKernels kernels = _kernels;
+	const TIn fill = FilterUtil::RoundAndSaturate<TIn>(static_cast<float>(borderValue));
+
+	if constexpr (std::is_same<TIn, uint8_t>::value)
+	{
+		if (FitsInteger(IntegerWeightSum(kernel)))
+		{
+			const std::vector<int16_t> weights = ToIntWeights(kernel);
+			const std::vector<int16_t> ones(kernelHeight, 1);
+			auto load = [](const uint8_t value) { return static_cast<int16_t>(value); };
+			Filter2DStrips(
+				input, kernelWidth, kernelHeight, border, load(fill), _fixedBuffer, pool, load,
+				[&](size_t i, const int16_t *row, size_t length, int16_t *out) {
+					kernels.horizontalInt(row, length, weights.data() + i * kernelWidth, kernelWidth, channels, out);
+				},
+				[&](const int16_t *const *rows, int64_t y, int16_t *scratch) {
+					if constexpr (std::is_same<TOut, int16_t>::value)
+					{
+						kernels.verticalInt(rows, ones.data(), kernelHeight, rowLength, output.Data() + y * rowLength);
+					}
+					else
+					{
+						kernels.verticalInt(rows, ones.data(), kernelHeight, rowLength, scratch);
+						StoreRow(scratch, rowLength, output.Data() + y * rowLength);
+					}
+				});
+			return;
+		}
+	}
+
+	const std::vector<float> weights = ToFloatWeights(kernel);
+	const std::vector<float> ones(kernelHeight, 1.0f);
+	Filter2DStrips(
+		input, kernelWidth, kernelHeight, border, static_cast<float>(fill), _floatBuffer, pool, [](const TIn value) { return static_cast<float>(value); },
+		[&](size_t i, const float *row, size_t length, float *out) { kernels.horizontalFloat(row, length, weights.data() + i * kernelWidth, kernelWidth, channels, out); },
+		[&](const float *const *rows, int64_t y, float *scratch) {
+			if constexpr (std::is_same<TOut, float>::value)
+			{
+				kernels.verticalFloat(rows, ones.data(), kernelHeight, rowLength, output.Data() + y * rowLength);
+			}
+			else
+			{
+				kernels.verticalFloat(rows, ones.data(), kernelHeight, rowLength, scratch);
+				FilterUtil::RoundAndSaturate(kernels, scratch, rowLength, output.Data() + y * rowLength);
+			}
+		});
+}
+
+#define THUNDER_SEPARABLE_FILTER_INSTANTIATE(TIn, TOut)                                                                                                                \
+	template void ThunderVision::SeparableFilter::Apply<TIn, TOut>(const TensorView<const TIn> &, const Tensor<double> &, const Tensor<double> &, Tensor<TOut> &,   \
+																   const BorderMode, const double, ThreadPool &);                                                \
+	template void ThunderVision::SeparableFilter::Apply2D<TIn, TOut>(const TensorView<const TIn> &, const Tensor<double> &, Tensor<TOut> &, const BorderMode,      \
+																	 const double, ThreadPool &);
+
+#define THUNDER_SEPARABLE_FILTER_INSTANTIATE_OUTPUTS(TIn)   \
+	THUNDER_SEPARABLE_FILTER_INSTANTIATE(TIn, float)        \
+	THUNDER_SEPARABLE_FILTER_INSTANTIATE(TIn, uint8_t)      \
+	THUNDER_SEPARABLE_FILTER_INSTANTIATE(TIn, uint16_t)     \
+	THUNDER_SEPARABLE_FILTER_INSTANTIATE(TIn, int16_t)
+
+THUNDER_SEPARABLE_FILTER_INSTANTIATE_OUTPUTS(float)
+THUNDER_SEPARABLE_FILTER_INSTANTIATE_OUTPUTS(uint8_t)
+THUNDER_SEPARABLE_FILTER_INSTANTIATE_OUTPUTS(uint16_t)
@@ -0,0 +1,348 @@
+#include "SeparableFilterKernels.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "FilterUtil.h"
+
+// Calls the compile time specializations of KERNEL for the common kernel sizes
+#define THUNDER_FILTER_DISPATCH_TAPS(KERNEL, ...) \
+	switch (taps)                                 \
+	{                                             \
+	case 3:                                       \
+		KERNEL<3>(__VA_ARGS__);                   \
+		break;                                    \
+	case 5:                                       \
+		KERNEL<5>(__VA_ARGS__);                   \
+		break;                                    \
+	case 7:                                       \
+		KERNEL<7>(__VA_ARGS__);                   \
+		break;                                    \
+	default:                                      \
+		KERNEL<0>(__VA_ARGS__);                   \
+	}
+
+namespace
+{
+inline float FilterTaps(const float *row, const size_t step, const float *weights, const size_t taps)
+{
+	float sum = weights[0] * row[0];
+	for (size_t k = 1; k < taps; k++)
+	{
+		sum = sum + weights[k] * row[k * step];
+	}
+	return sum;
+}
+
+inline float FilterTaps(const float *const *rows, const size_t j, const float *weights, const size_t taps)
+{
+	float sum = weights[0] * rows[0][j];
+	for (size_t k = 1; k < taps; k++)
+	{
+		sum = sum + weights[k] * rows[k][j];
+	}
+	return sum;
+}
+
+// Rounded product with 15 fractional bits in b, the same as PMULHRSW
+inline int16_t MulRound(const int16_t a, const int16_t b)
+{
+	return static_cast<int16_t>((static_cast<int32_t>(a) * b + 0x4000) >> 15);
+}
+
+inline int16_t FilterTapsFixed(const int16_t *row, const size_t step, const int16_t *weights, const size_t taps)
+{
+	int16_t sum = MulRound(row[0], weights[0]);
+	for (size_t k = 1; k < taps; k++)
+	{
+		sum = static_cast<int16_t>(sum + MulRound(row[k * step], weights[k]));
+	}
+	return sum;
+}
+
+inline int16_t FilterTapsFixed(const int16_t *const *rows, const size_t j, const int16_t *weights, const size_t taps)
+{
+	int16_t sum = MulRound(rows[0][j], weights[0]);
+	for (size_t k = 1; k < taps; k++)
+	{
+		sum = static_cast<int16_t>(sum + MulRound(rows[k][j], weights[k]));
+	}
+	return sum;
+}
+
+inline int16_t FilterTapsInt(const int16_t *row, const size_t step, const int16_t *weights, const size_t taps)
+{
+	int16_t sum = static_cast<int16_t>(row[0] * weights[0]);
+	for (size_t k = 1; k < taps; k++)
+	{
+		sum = static_cast<int16_t>(sum + row[k * step] * weights[k]);
+	}
+	return sum;
+}
+
+inline int16_t FilterTapsInt(const int16_t *const *rows, const size_t j, const int16_t *weights, const size_t taps)
+{
+	int16_t sum = static_cast<int16_t>(rows[0][j] * weights[0]);
+	for (size_t k = 1; k < taps; k++)
+	{
+		sum = static_cast<int16_t>(sum + rows[k][j] * weights[k]);
+	}
+	return sum;
+}
+
+inline float ResampleTaps(const float *row, const int32_t *indices, const float *weights, const size_t taps, const size_t length, const size_t i)
+{
+	float sum = weights[i] * row[indices[i]];
+	for (size_t k = 1; k < taps; k++)
+	{
+		sum += weights[k * length + i] * row[indices[k * length + i]];
+	}
+	return sum;
+}
+
+inline float RecursiveStep(const float *c, const float x, const float w1, const float w2, const float w3)
+{
+	return (c[0] * x + c[1] * w1) + (c[2] * w2 + c[3] * w3);
+}
+
+inline void RecursiveLine(float *line, const size_t length, const size_t step, const float *coefficients)
+{
+	float w1 = line[0];
+	float w2 = w1;
+	float w3 = w1;
+	for (size_t n = 1; n < length; n++)
+	{
+		const float w = RecursiveStep(coefficients, line[n * step], w1, w2, w3);
+		line[n * step] = w;
+		w3 = w2;
+		w2 = w1;
+		w1 = w;
+	}
+
+	w1 = line[(length - 1) * step];
+	w2 = w1;
+	w3 = w1;
+	for (size_t n = length - 1; n-- > 0;)
+	{
+		const float w = RecursiveStep(coefficients, line[n * step], w1, w2, w3);
+		line[n * step] = w;
+		w3 = w2;
+		w2 = w1;
+		w1 = w;
+	}
+}
+
+inline uint8_t FixedToPixel(const int16_t value)
+{
+	const int16_t rounded = static_cast<int16_t>(static_cast<int16_t>(value + (1 << (ThunderVision::FilterFixedPixelBits - 1))) >> ThunderVision::FilterFixedPixelBits);
+	return static_cast<uint8_t>(std::min<int16_t>(std::max<int16_t>(rounded, 0), 255));
+}
+
+namespace Portable
+{
+struct FloatOps
+{
+	using Vector = float;
+	static constexpr size_t Width = 1;
+	static inline Vector Load(const float *p) { return *p; }
+	static inline void Store(float *p, const Vector v) { *p = v; }
+	static inline Vector Set1(const float v) { return v; }
+	static inline Vector Add(const Vector a, const Vector b) { return a + b; }
+	static inline Vector Mul(const Vector a, const Vector b) { return a * b; }
+	static inline Vector Gather(const float *base, const int32_t *indices) { return base[*indices]; }
+	static inline void StoreRounded(uint8_t *p, const Vector v) { *p = ThunderVision::FilterUtil::RoundAndSaturate<uint8_t>(v); }
+	static inline void StoreRounded(uint16_t *p, const Vector v) { *p = ThunderVision::FilterUtil::RoundAndSaturate<uint16_t>(v); }
+};
+
+struct FixedOps
+{
+	using Vector = int16_t;
+	static constexpr size_t Width = 1;
+	static inline Vector Load(const int16_t *p) { return *p; }
+	static inline void Store(int16_t *p, const Vector v) { *p = v; }
+	static inline void StorePixels(uint8_t *p, const Vector v) { *p = FixedToPixel(v); }
+	static inline Vector Set1(const int16_t v) { return v; }
+	static inline Vector Add(const Vector a, const Vector b) { return static_cast<int16_t>(a + b); }
+	static inline Vector MulRound(const Vector a, const Vector b) { return ::MulRound(a, b); }
+	static inline Vector Mul(const Vector a, const Vector b) { return static_cast<int16_t>(a * b); }
+};
+
+#define THUNDER_FILTER_TARGET
+#include "SeparableFilterRows.inl"
+#undef THUNDER_FILTER_TARGET
+} // namespace Portable
+
+#ifdef THUNDER_X86
+namespace SSE41
+{
+struct FloatOps
+{
+	using Vector = __m128;
+	static constexpr size_t Width = 4;
+	THUNDER_TARGET_SSE41 static inline Vector Load(const float *p) { return _mm_loadu_ps(p); }
+	THUNDER_TARGET_SSE41 static inline void Store(float *p, const Vector v) { _mm_storeu_ps(p, v); }
+	THUNDER_TARGET_SSE41 static inline Vector Set1(const float v) { return _mm_set1_ps(v); }
+	THUNDER_TARGET_SSE41 static inline Vector Add(const Vector a, const Vector b) { return _mm_add_ps(a, b); }
+	THUNDER_TARGET_SSE41 static inline Vector Mul(const Vector a, const Vector b) { return _mm_mul_ps(a, b); }
+	THUNDER_TARGET_SSE41 static inline Vector Gather(const float *base, const int32_t *indices)
+	{
+		return _mm_setr_ps(base[indices[0]], base[indices[1]], base[indices[2]], base[indices[3]]);
+	}
+	// Clamped first, the conversion rounds to nearest even like std::nearbyint
+	THUNDER_TARGET_SSE41 static inline __m128i RoundClamped(const Vector v, const float max)
+	{
+		return _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(max)));
+	}
+	THUNDER_TARGET_SSE41 static inline void StoreRounded(uint8_t *p, const Vector v)
+	{
+		const __m128i words = _mm_packus_epi32(RoundClamped(v, 255.0f), _mm_setzero_si128());
+		const int bytes = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+		std::memcpy(p, &bytes, sizeof(bytes));
+	}
+	THUNDER_TARGET_SSE41 static inline void StoreRounded(uint16_t *p, const Vector v)
+	{
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(p), _mm_packus_epi32(RoundClamped(v, 65535.0f), _mm_setzero_si128()));
+	}
+};
+
+struct FixedOps
+{
+	using Vector = __m128i;
+	static constexpr size_t Width = 8;
+	THUNDER_TARGET_SSE41 static inline Vector Load(const int16_t *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+	THUNDER_TARGET_SSE41 static inline void Store(int16_t *p, const Vector v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+	THUNDER_TARGET_SSE41 static inline void StorePixels(uint8_t *p, const Vector v)
+	{
+		const __m128i rounded = _mm_srai_epi16(_mm_add_epi16(v, _mm_set1_epi16(1 << (ThunderVision::FilterFixedPixelBits - 1))), ThunderVision::FilterFixedPixelBits);
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(p), _mm_packus_epi16(rounded, rounded));
+	}
+	THUNDER_TARGET_SSE41 static inline Vector Set1(const int16_t v) { return _mm_set1_epi16(v); }
+	THUNDER_TARGET_SSE41 static inline Vector Add(const Vector a, const Vector b) { return _mm_add_epi16(a, b); }
+	THUNDER_TARGET_SSE41 static inline Vector MulRound(const Vector a, const Vector b) { return _mm_mulhrs_epi16(a, b); }
+	THUNDER_TARGET_SSE41 static inline Vector Mul(const Vector a, const Vector b) { return _mm_mullo_epi16(a, b); }
+};
+
+#define THUNDER_FILTER_TARGET THUNDER_TARGET_SSE41
+#include "SeparableFilterRows.inl"
+#undef THUNDER_FILTER_TARGET
+} // namespace SSE41
+
+namespace AVX2
+{
+struct FloatOps
+{
+	using Vector = __m256;
+	static constexpr size_t Width = 8;
+	THUNDER_TARGET_AVX2 static inline Vector Load(const float *p) { return _mm256_loadu_ps(p); }
+	THUNDER_TARGET_AVX2 static inline void Store(float *p, const Vector v) { _mm256_storeu_ps(p, v); }
+	THUNDER_TARGET_AVX2 static inline Vector Set1(const float v) { return _mm256_set1_ps(v); }
+	THUNDER_TARGET_AVX2 static inline Vector Add(const Vector a, const Vector b) { return _mm256_add_ps(a, b); }
+	THUNDER_TARGET_AVX2 static inline Vector Mul(const Vector a, const Vector b) { return _mm256_mul_ps(a, b); }
+	THUNDER_TARGET_AVX2 static inline Vector Gather(const float *base, const int32_t *indices)
+	{
+		return _mm256_i32gather_ps(base, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(indices)), 4);
+	}
+	// Clamped first, the conversion rounds to nearest even like std::nearbyint
+	THUNDER_TARGET_AVX2 static inline __m128i RoundClampedWords(const Vector v, const float max)
+	{
+		const __m256i rounded = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), _mm256_set1_ps(max)));
+		return _mm_packus_epi32(_mm256_castsi256_si128(rounded), _mm256_extracti128_si256(rounded, 1));
+	}
+	THUNDER_TARGET_AVX2 static inline void StoreRounded(uint8_t *p, const Vector v)
+	{
+		const __m128i words = RoundClampedWords(v, 255.0f);
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(p), _mm_packus_epi16(words, words));
+	}
+	THUNDER_TARGET_AVX2 static inline void StoreRounded(uint16_t *p, const Vector v)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(p), RoundClampedWords(v, 65535.0f));
+	}
+};
+
+struct FixedOps
+{
+	using Vector = __m256i;
+	static constexpr size_t Width = 16;
+	THUNDER_TARGET_AVX2 static inline Vector Load(const int16_t *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+	THUNDER_TARGET_AVX2 static inline void Store(int16_t *p, const Vector v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+	THUNDER_TARGET_AVX2 static inline void StorePixels(uint8_t *p, const Vector v)
+	{
+		const __m256i rounded = _mm256_srai_epi16(_mm256_add_epi16(v, _mm256_set1_epi16(1 << (ThunderVision::FilterFixedPixelBits - 1))), ThunderVision::FilterFixedPixelBits);
+		// packus works per 128 bit lane, the permutation moves the pixels of both lanes into the lower half
+		const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(rounded, rounded), 0x08);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm256_castsi256_si128(packed));
+	}
+	THUNDER_TARGET_AVX2 static inline Vector Set1(const int16_t v) { return _mm256_set1_epi16(v); }
+	THUNDER_TARGET_AVX2 static inline Vector Add(const Vector a, const Vector b) { return _mm256_add_epi16(a, b); }
+	THUNDER_TARGET_AVX2 static inline Vector MulRound(const Vector a, const Vector b) { return _mm256_mulhrs_epi16(a, b); }
+	THUNDER_TARGET_AVX2 static inline Vector Mul(const Vector a, const Vector b) { return _mm256_mullo_epi16(a, b); }
+};
+
+#define THUNDER_FILTER_TARGET THUNDER_TARGET_AVX2
+#include "SeparableFilterRows.inl"
+#undef THUNDER_FILTER_TARGET
+} // namespace AVX2
+
+namespace AVX512
+{
+struct FloatOps
+{
+	using Vector = __m512;
+	static constexpr size_t Width = 16;
+	THUNDER_TARGET_AVX512 static inline Vector Load(const float *p) { return _mm512_loadu_ps(p); }
+	THUNDER_TARGET_AVX512 static inline void Store(float *p, const Vector v) { _mm512_storeu_ps(p, v); }
+	THUNDER_TARGET_AVX512 static inline Vector Set1(const float v) { return _mm512_set1_ps(v); }
+	THUNDER_TARGET_AVX512 static inline Vector Add(const Vector a, const Vector b) { return _mm512_add_ps(a, b); }
+	THUNDER_TARGET_AVX512 static inline Vector Mul(const Vector a, const Vector b) { return _mm512_mul_ps(a, b); }
+	THUNDER_TARGET_AVX512 static inline Vector Gather(const float *base, const int32_t *indices)
+	{
+		return _mm512_mask_i32gather_ps(_mm512_setzero_ps(), 0xFFFF, _mm512_loadu_si512(indices), base, 4);
+	}
+	// Clamped first, the conversion rounds to nearest even like std::nearbyint
+	THUNDER_TARGET_AVX512 static inline __m512i RoundClamped(const Vector v, const float max)
+	{
+		const __m512 low = _mm512_mask_max_ps(v, 0xFFFF, v, _mm512_setzero_ps());
+		return _mm512_maskz_cvtps_epi32(0xFFFF, _mm512_mask_min_ps(low, 0xFFFF, low, _mm512_set1_ps(max)));
+	}
+	THUNDER_TARGET_AVX512 static inline void StoreRounded(uint8_t *p, const Vector v) { _mm512_mask_cvtepi32_storeu_epi8(p, 0xFFFF, RoundClamped(v, 255.0f)); }
+	THUNDER_TARGET_AVX512 static inline void StoreRounded(uint16_t *p, const Vector v) { _mm512_mask_cvtepi32_storeu_epi16(p, 0xFFFF, RoundClamped(v, 65535.0f)); }
+};
+
+struct FixedOps
+{
+	using Vector = __m512i;
+	static constexpr size_t Width = 32;
+	THUNDER_TARGET_AVX512 static inline Vector Load(const int16_t *p) { return _mm512_loadu_si512(p); }
+	THUNDER_TARGET_AVX512 static inline void Store(int16_t *p, const Vector v) { _mm512_storeu_si512(p, v); }
+	THUNDER_TARGET_AVX512 static inline void StorePixels(uint8_t *p, const Vector v)
+	{
+		const __m512i rounded = _mm512_srai_epi16(_mm512_add_epi16(v, _mm512_set1_epi16(1 << (ThunderVision::FilterFixedPixelBits - 1))), ThunderVision::FilterFixedPixelBits);
+		const __m512i clamped = _mm512_min_epi16(_mm512_max_epi16(rounded, _mm512_setzero_si512()), _mm512_set1_epi16(255));
+		_mm512_mask_cvtepi16_storeu_epi8(p, 0xFFFFFFFF, clamped);
+	}
+	THUNDER_TARGET_AVX512 static inline Vector Set1(const int16_t v) { return _mm512_set1_epi16(v); }
+	THUNDER_TARGET_AVX512 static inline Vector Add(const Vector a, const Vector b) { return _mm512_add_epi16(a, b); }
+	THUNDER_TARGET_AVX512 static inline Vector MulRound(const Vector a, const Vector b) { return _mm512_mulhrs_epi16(a, b); }
+	THUNDER_TARGET_AVX512 static inline Vector Mul(const Vector a, const Vector b) { return _mm512_mullo_epi16(a, b); }
+};
+
+#define THUNDER_FILTER_TARGET THUNDER_TARGET_AVX512
+#include "SeparableFilterRows.inl"
+#undef THUNDER_FILTER_TARGET
+} // namespace AVX512
+#endif // THUNDER_X86
+} // namespace
+
+ThunderVision::SeparableFilterKernels ThunderVision::SelectSeparableFilterKernels(const SimdLevel maxLevel)
+{
+	const SimdLevel level = std::min(maxLevel, GetSupportedSimdLevel());
+#ifdef THUNDER_X86
+	if (level >= SimdLevel::AVX512)
+		return {AVX512::HorizontalFloat, AVX512::VerticalFloat, AVX512::HorizontalFixed, AVX512::VerticalFixed, AVX512::HorizontalInt, AVX512::VerticalInt, AVX512::RecursiveFloat, AVX512::ResampleFloat, AVX512::RoundUint8, AVX512::RoundUint16, SimdLevel::AVX512};
+	if (level >= SimdLevel::AVX2)
+		return {AVX2::HorizontalFloat, AVX2::VerticalFloat, AVX2::HorizontalFixed, AVX2::VerticalFixed, AVX2::HorizontalInt, AVX2::VerticalInt, AVX2::RecursiveFloat, AVX2::ResampleFloat, AVX2::RoundUint8, AVX2::RoundUint16, SimdLevel::AVX2};
+	if (level >= SimdLevel::SSE41)
+		return {SSE41::HorizontalFloat, SSE41::VerticalFloat, SSE41::HorizontalFixed, SSE41::VerticalFixed, SSE41::HorizontalInt, SSE41::VerticalInt, SSE41::RecursiveFloat, SSE41::ResampleFloat, SSE41::RoundUint8, SSE41::RoundUint16, SimdLevel::SSE41};
+#endif
+	return {Portable::HorizontalFloat, Portable::VerticalFloat, Portable::HorizontalFixed, Portable::VerticalFixed, Portable::HorizontalInt, Portable::VerticalInt, Portable::RecursiveFloat, Portable::ResampleFloat, Portable::RoundUint8, Portable::RoundUint16, SimdLevel::Portable};
+}
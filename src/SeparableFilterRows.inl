@@ -0,0 +1,267 @@
+// Row kernels of the separable filter. SeparableFilterKernels.cpp includes this file once per instruction set, with
+// THUNDER_FILTER_TARGET set to the target attribute of the instruction set. FloatOps and FixedOps provide the vector
+// types, their Width and the arithmetic, the scalar tails use the same order of operations as the vectors.
+// Taps > 0 fixes the kernel size at compile time, so the tap loops are unrolled and the weights stay in registers.
+
+template <size_t Taps>
+THUNDER_FILTER_TARGET inline void HorizontalFloatTaps(const float *row, const size_t length, const float *weights, const size_t runtimeTaps, const size_t step, float *out)
+{
+	using Vector = FloatOps::Vector;
+	constexpr size_t width = FloatOps::Width;
+	const size_t taps = Taps > 0 ? Taps : runtimeTaps;
+
+	size_t j = 0;
+	for (; j + width <= length; j += width)
+	{
+		Vector sum = FloatOps::Mul(FloatOps::Set1(weights[0]), FloatOps::Load(row + j));
+		for (size_t k = 1; k < taps; k++)
+		{
+			sum = FloatOps::Add(sum, FloatOps::Mul(FloatOps::Set1(weights[k]), FloatOps::Load(row + j + k * step)));
+		}
+		FloatOps::Store(out + j, sum);
+	}
+	for (; j < length; j++)
+	{
+		out[j] = FilterTaps(row + j, step, weights, taps);
+	}
+}
+
+template <size_t Taps>
+THUNDER_FILTER_TARGET inline void VerticalFloatTaps(const float *const *rows, const float *weights, const size_t runtimeTaps, const size_t length, float *out)
+{
+	using Vector = FloatOps::Vector;
+	constexpr size_t width = FloatOps::Width;
+	const size_t taps = Taps > 0 ? Taps : runtimeTaps;
+
+	size_t j = 0;
+	for (; j + width <= length; j += width)
+	{
+		Vector sum = FloatOps::Mul(FloatOps::Set1(weights[0]), FloatOps::Load(rows[0] + j));
+		for (size_t k = 1; k < taps; k++)
+		{
+			sum = FloatOps::Add(sum, FloatOps::Mul(FloatOps::Set1(weights[k]), FloatOps::Load(rows[k] + j)));
+		}
+		FloatOps::Store(out + j, sum);
+	}
+	for (; j < length; j++)
+	{
+		out[j] = FilterTaps(rows, j, weights, taps);
+	}
+}
+
+template <size_t Taps>
+THUNDER_FILTER_TARGET inline void HorizontalFixedTaps(const int16_t *row, const size_t length, const int16_t *weights, const size_t runtimeTaps, const size_t step, int16_t *out)
+{
+	using Vector = FixedOps::Vector;
+	constexpr size_t width = FixedOps::Width;
+	const size_t taps = Taps > 0 ? Taps : runtimeTaps;
+
+	size_t j = 0;
+	for (; j + width <= length; j += width)
+	{
+		Vector sum = FixedOps::MulRound(FixedOps::Load(row + j), FixedOps::Set1(weights[0]));
+		for (size_t k = 1; k < taps; k++)
+		{
+			sum = FixedOps::Add(sum, FixedOps::MulRound(FixedOps::Load(row + j + k * step), FixedOps::Set1(weights[k])));
+		}
+		FixedOps::Store(out + j, sum);
+	}
+	for (; j < length; j++)
+	{
+		out[j] = FilterTapsFixed(row + j, step, weights, taps);
+	}
+}
+
+template <size_t Taps>
+THUNDER_FILTER_TARGET inline void VerticalFixedTaps(const int16_t *const *rows, const int16_t *weights, const size_t runtimeTaps, const size_t length, uint8_t *out)
+{
+	using Vector = FixedOps::Vector;
+	constexpr size_t width = FixedOps::Width;
+	const size_t taps = Taps > 0 ? Taps : runtimeTaps;
+
+	size_t j = 0;
+	for (; j + width <= length; j += width)
+	{
+		Vector sum = FixedOps::MulRound(FixedOps::Load(rows[0] + j), FixedOps::Set1(weights[0]));
+		for (size_t k = 1; k < taps; k++)
+		{
+			sum = FixedOps::Add(sum, FixedOps::MulRound(FixedOps::Load(rows[k] + j), FixedOps::Set1(weights[k])));
+		}
+		FixedOps::StorePixels(out + j, sum);
+	}
+	for (; j < length; j++)
+	{
+		out[j] = FixedToPixel(FilterTapsFixed(rows, j, weights, taps));
+	}
+}
+
+template <size_t Taps>
+THUNDER_FILTER_TARGET inline void HorizontalIntTaps(const int16_t *row, const size_t length, const int16_t *weights, const size_t runtimeTaps, const size_t step, int16_t *out)
+{
+	using Vector = FixedOps::Vector;
+	constexpr size_t width = FixedOps::Width;
+	const size_t taps = Taps > 0 ? Taps : runtimeTaps;
+
+	size_t j = 0;
+	for (; j + width <= length; j += width)
+	{
+		Vector sum = FixedOps::Mul(FixedOps::Load(row + j), FixedOps::Set1(weights[0]));
+		for (size_t k = 1; k < taps; k++)
+		{
+			sum = FixedOps::Add(sum, FixedOps::Mul(FixedOps::Load(row + j + k * step), FixedOps::Set1(weights[k])));
+		}
+		FixedOps::Store(out + j, sum);
+	}
+	for (; j < length; j++)
+	{
+		out[j] = FilterTapsInt(row + j, step, weights, taps);
+	}
+}
+
+template <size_t Taps>
+THUNDER_FILTER_TARGET inline void VerticalIntTaps(const int16_t *const *rows, const int16_t *weights, const size_t runtimeTaps, const size_t length, int16_t *out)
+{
+	using Vector = FixedOps::Vector;
+	constexpr size_t width = FixedOps::Width;
+	const size_t taps = Taps > 0 ? Taps : runtimeTaps;
+
+	size_t j = 0;
+	for (; j + width <= length; j += width)
+	{
+		Vector sum = FixedOps::Mul(FixedOps::Load(rows[0] + j), FixedOps::Set1(weights[0]));
+		for (size_t k = 1; k < taps; k++)
+		{
+			sum = FixedOps::Add(sum, FixedOps::Mul(FixedOps::Load(rows[k] + j), FixedOps::Set1(weights[k])));
+		}
+		FixedOps::Store(out + j, sum);
+	}
+	for (; j < length; j++)
+	{
+		out[j] = FilterTapsInt(rows, j, weights, taps);
+	}
+}
+
+THUNDER_FILTER_TARGET void HorizontalFloat(const float *row, const size_t length, const float *weights, const size_t taps, const size_t step, float *out)
+{
+	THUNDER_FILTER_DISPATCH_TAPS(HorizontalFloatTaps, row, length, weights, taps, step, out)
+}
+
+THUNDER_FILTER_TARGET void VerticalFloat(const float *const *rows, const float *weights, const size_t taps, const size_t length, float *out)
+{
+	THUNDER_FILTER_DISPATCH_TAPS(VerticalFloatTaps, rows, weights, taps, length, out)
+}
+
+THUNDER_FILTER_TARGET void HorizontalFixed(const int16_t *row, const size_t length, const int16_t *weights, const size_t taps, const size_t step, int16_t *out)
+{
+	THUNDER_FILTER_DISPATCH_TAPS(HorizontalFixedTaps, row, length, weights, taps, step, out)
+}
+
+THUNDER_FILTER_TARGET void VerticalFixed(const int16_t *const *rows, const int16_t *weights, const size_t taps, const size_t length, uint8_t *out)
+{
+	THUNDER_FILTER_DISPATCH_TAPS(VerticalFixedTaps, rows, weights, taps, length, out)
+}
+
+THUNDER_FILTER_TARGET void HorizontalInt(const int16_t *row, const size_t length, const int16_t *weights, const size_t taps, const size_t step, int16_t *out)
+{
+	THUNDER_FILTER_DISPATCH_TAPS(HorizontalIntTaps, row, length, weights, taps, step, out)
+}
+
+THUNDER_FILTER_TARGET void VerticalInt(const int16_t *const *rows, const int16_t *weights, const size_t taps, const size_t length, int16_t *out)
+{
+	THUNDER_FILTER_DISPATCH_TAPS(VerticalIntTaps, rows, weights, taps, length, out)
+}
+
+THUNDER_FILTER_TARGET void RecursiveFloat(float *lines, const size_t length, const size_t lanes, const float *coefficients)
+{
+	using Vector = FloatOps::Vector;
+	constexpr size_t width = FloatOps::Width;
+
+	const Vector b = FloatOps::Set1(coefficients[0]);
+	const Vector a1 = FloatOps::Set1(coefficients[1]);
+	const Vector a2 = FloatOps::Set1(coefficients[2]);
+	const Vector a3 = FloatOps::Set1(coefficients[3]);
+
+	size_t lane = 0;
+	for (; lane + width <= lanes; lane += width)
+	{
+		float *line = lines + lane;
+
+		// A constant continuation is its own steady state, so the first value stays unchanged
+		Vector w1 = FloatOps::Load(line);
+		Vector w2 = w1;
+		Vector w3 = w1;
+		for (size_t n = 1; n < length; n++)
+		{
+			const Vector w = FloatOps::Add(FloatOps::Add(FloatOps::Mul(b, FloatOps::Load(line + n * lanes)), FloatOps::Mul(a1, w1)),
+										   FloatOps::Add(FloatOps::Mul(a2, w2), FloatOps::Mul(a3, w3)));
+			FloatOps::Store(line + n * lanes, w);
+			w3 = w2;
+			w2 = w1;
+			w1 = w;
+		}
+
+		w1 = FloatOps::Load(line + (length - 1) * lanes);
+		w2 = w1;
+		w3 = w1;
+		for (size_t n = length - 1; n-- > 0;)
+		{
+			const Vector w = FloatOps::Add(FloatOps::Add(FloatOps::Mul(b, FloatOps::Load(line + n * lanes)), FloatOps::Mul(a1, w1)),
+										   FloatOps::Add(FloatOps::Mul(a2, w2), FloatOps::Mul(a3, w3)));
+			FloatOps::Store(line + n * lanes, w);
+			w3 = w2;
+			w2 = w1;
+			w1 = w;
+		}
+	}
+	for (; lane < lanes; lane++)
+	{
+		RecursiveLine(lines + lane, length, lanes, coefficients);
+	}
+}
+
+THUNDER_FILTER_TARGET void ResampleFloat(const float *row, const int32_t *indices, const float *weights, const size_t taps, const size_t length, float *out)
+{
+	using Vector = FloatOps::Vector;
+	constexpr size_t width = FloatOps::Width;
+
+	size_t i = 0;
+	for (; i + width <= length; i += width)
+	{
+		Vector sum = FloatOps::Mul(FloatOps::Load(weights + i), FloatOps::Gather(row, indices + i));
+		for (size_t k = 1; k < taps; k++)
+		{
+			sum = FloatOps::Add(sum, FloatOps::Mul(FloatOps::Load(weights + k * length + i), FloatOps::Gather(row, indices + k * length + i)));
+		}
+		FloatOps::Store(out + i, sum);
+	}
+	for (; i < length; i++)
+	{
+		out[i] = ResampleTaps(row, indices, weights, taps, length, i);
+	}
+}
+
+template <typename T>
+THUNDER_FILTER_TARGET inline void RoundTo(const float *values, const size_t length, T *out)
+{
+	constexpr size_t width = FloatOps::Width;
+
+	size_t i = 0;
+	for (; i + width <= length; i += width)
+	{
+		FloatOps::StoreRounded(out + i, FloatOps::Load(values + i));
+	}
+	for (; i < length; i++)
+	{
+		out[i] = ThunderVision::FilterUtil::RoundAndSaturate<T>(values[i]);
+	}
+}
+
+THUNDER_FILTER_TARGET void RoundUint8(const float *values, const size_t length, uint8_t *out)
+{
+	RoundTo(values, length, out);
+}
+
+THUNDER_FILTER_TARGET void RoundUint16(const float *values, const size_t length, uint16_t *out)
+{
+	RoundTo(values, length, out);
+}
@@ -0,0 +1,137 @@
+#include "StereoSession.h"
+
+ThunderVision::StereoSession::StereoSession(size_t maxDisparity, bool consistencyCheck, AggregationDirections nrAggregations, size_t nrCensusThreads)
+	: _matcher(maxDisparity, consistencyCheck, nrAggregations), _censusPool(std::max<size_t>(1, nrCensusThreads))
+{
+	_censusThread = std::thread([this]() { CensusLoop(); });
+	_matchingThread = std::thread([this]() { MatchingLoop(); });
+}
+
+ThunderVision::StereoSession::~StereoSession()
+{
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_changed.wait(lock, [this]() { return _completed == _submitted; });
+		_stopping = true;
+	}
+	_changed.notify_all();
+	_censusThread.join();
+	_matchingThread.join();
+}
+
+ThunderVision::SemiGlobalMatching &ThunderVision::StereoSession::GetMatcher()
+{
+	return _matcher;
+}
+
+bool ThunderVision::StereoSession::Poll(uint64_t frame)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (frame >= _submitted)
+		throw new ThunderException("The frame has not been submitted.");
+	if (frame >= _completed)
+		return false;
+	RethrowException(frame);
+	return true;
+}
+
+void ThunderVision::StereoSession::Wait(uint64_t frame)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	if (frame >= _submitted)
+		throw new ThunderException("The frame has not been submitted.");
+	_changed.wait(lock, [this, frame]() { return frame < _completed; });
+	RethrowException(frame);
+}
+
+void ThunderVision::StereoSession::Flush()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	_changed.wait(lock, [this]() { return _completed == _submitted; });
+}
+
+uint64_t ThunderVision::StereoSession::Enqueue(Frame frame)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	Slot &slot = _slots[_submitted % _slots.size()];
+	_changed.wait(lock, [&slot]() { return slot.state == SlotState::Free; });
+	slot.frame = std::move(frame);
+	slot.exception = nullptr;
+	slot.state = SlotState::Submitted;
+	const uint64_t number = _submitted++;
+	lock.unlock();
+	_changed.notify_all();
+	return number;
+}
+
+void ThunderVision::StereoSession::CensusLoop()
+{
+	while (true)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		Slot &slot = _slots[_transformed % _slots.size()];
+		_changed.wait(lock, [this, &slot]() { return _stopping || slot.state == SlotState::Submitted; });
+		if (_stopping)
+			return;
+		lock.unlock();
+
+		try
+		{
+			slot.frame.census(slot);
+		}
+		catch (...)
+		{
+			slot.exception = std::current_exception();
+		}
+
+		lock.lock();
+		slot.state = SlotState::Transformed;
+		_transformed++;
+		lock.unlock();
+		_changed.notify_all();
+	}
+}
+
+void ThunderVision::StereoSession::MatchingLoop()
+{
+	while (true)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		Slot &slot = _slots[_completed % _slots.size()];
+		_changed.wait(lock, [this, &slot]() { return _stopping || slot.state == SlotState::Transformed; });
+		if (_stopping)
+			return;
+		lock.unlock();
+
+		if (!slot.exception)
+		{
+			try
+			{
+				slot.frame.match(slot);
+			}
+			catch (...)
+			{
+				slot.exception = std::current_exception();
+			}
+		}
+
+		lock.lock();
+		if (slot.exception)
+			_exceptions[_completed] = slot.exception;
+		slot.frame = Frame();
+		slot.state = SlotState::Free;
+		_completed++;
+		lock.unlock();
+		_changed.notify_all();
+	}
+}
+
+void ThunderVision::StereoSession::RethrowException(uint64_t frame)
+{
+	auto exception = _exceptions.find(frame);
+	if (exception == _exceptions.end())
+		return;
+	std::exception_ptr pointer = exception->second;
+	_exceptions.erase(exception);
+	std::rethrow_exception(pointer);
+}
@@ -0,0 +1,238 @@
+#include "TensorFile.h"
+
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+const char magic[8] = {'T', 'H', 'T', 'E', 'N', 'S', 'O', 'R'};
+const size_t fixedHeaderSize = 32;
+const size_t maxRank = 32;
+
+struct FixedHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t type;
+	uint32_t rank;
+	uint32_t elementSize;
+	uint64_t dataOffset;
+};
+static_assert(sizeof(FixedHeader) == fixedHeaderSize, "The header has to be packed");
+
+size_t GetElementSize(ThunderVision::TensorDataType type)
+{
+	switch (type)
+	{
+	case ThunderVision::TensorDataType::UInt8:
+	case ThunderVision::TensorDataType::Int8:
+		return 1;
+	case ThunderVision::TensorDataType::UInt16:
+	case ThunderVision::TensorDataType::Int16:
+		return 2;
+	case ThunderVision::TensorDataType::UInt32:
+	case ThunderVision::TensorDataType::Int32:
+	case ThunderVision::TensorDataType::Float32:
+		return 4;
+	case ThunderVision::TensorDataType::UInt64:
+	case ThunderVision::TensorDataType::Int64:
+	case ThunderVision::TensorDataType::Float64:
+		return 8;
+	}
+	return 0;
+}
+
+size_t GetDataOffset(size_t rank)
+{
+	const size_t headerSize = fixedHeaderSize + rank * 2 * sizeof(uint64_t);
+	return (headerSize + ThunderVision::TensorFile::DataAlignment - 1) / ThunderVision::TensorFile::DataAlignment * ThunderVision::TensorFile::DataAlignment;
+}
+} // namespace
+
+void ThunderVision::TensorFile::Write(const std::string &path, TensorDataType type, size_t elementSize, const std::vector<size_t> &dimensions, const void *data)
+{
+	if (GetElementSize(type) != elementSize)
+		throw new ThunderException("The element size does not match the data type of the tensor");
+	if (dimensions.size() > maxRank)
+		throw new ThunderException("Tensor files support at most rank " + std::to_string(maxRank));
+
+	size_t totalSize = 1;
+	for (const auto &dimension : dimensions)
+		totalSize *= dimension;
+
+	FixedHeader header;
+	std::memcpy(header.magic, magic, sizeof(magic));
+	header.version = Version;
+	header.type = static_cast<uint32_t>(type);
+	header.rank = static_cast<uint32_t>(dimensions.size());
+	header.elementSize = static_cast<uint32_t>(elementSize);
+	header.dataOffset = GetDataOffset(dimensions.size());
+
+	// Dimensions, contiguous strides and the padding up to the aligned data
+	std::vector<uint8_t> buffer(header.dataOffset, 0);
+	std::memcpy(buffer.data(), &header, sizeof(header));
+	uint64_t stride = 1;
+	for (size_t i = dimensions.size(); i > 0; i--)
+	{
+		const uint64_t dimension = dimensions[i - 1];
+		std::memcpy(buffer.data() + fixedHeaderSize + (i - 1) * sizeof(uint64_t), &dimension, sizeof(dimension));
+		std::memcpy(buffer.data() + fixedHeaderSize + (dimensions.size() + i - 1) * sizeof(uint64_t), &stride, sizeof(stride));
+		stride *= dimension;
+	}
+
+	std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+	if (!stream)
+		throw new ThunderException("The tensor file could not be created: " + path);
+	stream.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+	stream.write(static_cast<const char *>(data), totalSize * elementSize);
+	if (!stream)
+		throw new ThunderException("Writing the tensor file failed: " + path);
+}
+
+ThunderVision::MappedTensorFile::MappedTensorFile(const std::string &path)
+{
+	Open(path);
+}
+
+ThunderVision::MappedTensorFile::~MappedTensorFile()
+{
+	Close();
+}
+
+ThunderVision::MappedTensorFile::MappedTensorFile(MappedTensorFile &&other) noexcept
+{
+	*this = std::move(other);
+}
+
+ThunderVision::MappedTensorFile &ThunderVision::MappedTensorFile::operator=(MappedTensorFile &&other) noexcept
+{
+	if (this != &other)
+	{
+		Close();
+		_mapping = std::exchange(other._mapping, nullptr);
+		_size = std::exchange(other._size, 0);
+		_data = std::exchange(other._data, nullptr);
+		_type = other._type;
+		_dimensions = std::move(other._dimensions);
+		_strides = std::move(other._strides);
+	}
+	return *this;
+}
+
+void ThunderVision::MappedTensorFile::Open(const std::string &path)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		throw new ThunderException("The tensor file could not be opened: " + path);
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(fixedHeaderSize))
+	{
+		CloseHandle(file);
+		throw new ThunderException("The file is not a tensor file: " + path);
+	}
+	// The view keeps the mapping alive, so both handles are closed right away
+	HANDLE fileMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	void *mapping = fileMapping != nullptr ? MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (fileMapping != nullptr)
+		CloseHandle(fileMapping);
+	CloseHandle(file);
+	if (mapping == nullptr)
+		throw new ThunderException("Mapping the tensor file failed: " + path);
+	_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+	const int file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		throw new ThunderException("The tensor file could not be opened: " + path);
+	struct stat status;
+	if (fstat(file, &status) != 0 || status.st_size < static_cast<off_t>(fixedHeaderSize))
+	{
+		close(file);
+		throw new ThunderException("The file is not a tensor file: " + path);
+	}
+	// The mapping stays valid after the descriptor is closed
+	void *mapping = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (mapping == MAP_FAILED)
+		throw new ThunderException("Mapping the tensor file failed: " + path);
+	_size = static_cast<size_t>(status.st_size);
+#endif
+	_mapping = mapping;
+
+	const uint8_t *bytes = static_cast<const uint8_t *>(_mapping);
+	FixedHeader header;
+	std::memcpy(&header, bytes, sizeof(header));
+	const bool validHeader = std::memcmp(header.magic, magic, sizeof(magic)) == 0 && header.rank <= maxRank &&
+							 header.type <= static_cast<uint32_t>(TensorDataType::Float64) &&
+							 GetElementSize(static_cast<TensorDataType>(header.type)) == header.elementSize &&
+							 header.dataOffset % TensorFile::DataAlignment == 0 && header.dataOffset >= fixedHeaderSize + header.rank * 2 * sizeof(uint64_t) &&
+							 header.dataOffset <= _size;
+	if (!validHeader || header.version != TensorFile::Version)
+	{
+		Close();
+		throw new ThunderException((validHeader ? "Unsupported version of the tensor file: " : "The file is not a tensor file: ") + path);
+	}
+
+	_type = static_cast<TensorDataType>(header.type);
+	_dimensions.resize(header.rank);
+	_strides.resize(header.rank);
+	std::memcpy(_dimensions.data(), bytes + fixedHeaderSize, header.rank * sizeof(uint64_t));
+	std::memcpy(_strides.data(), bytes + fixedHeaderSize + header.rank * sizeof(uint64_t), header.rank * sizeof(int64_t));
+
+	// The element with the largest offset has to lie inside of the file, the strides written by TensorFile are positive
+	const uint64_t availableElements = (_size - header.dataOffset) / header.elementSize;
+	bool empty = false;
+	bool inside = availableElements > 0;
+	uint64_t lastElement = 0;
+	for (size_t i = 0; i < _dimensions.size(); i++)
+	{
+		empty |= _dimensions[i] == 0;
+		if (_strides[i] < 0)
+			inside = false;
+		else if (inside && _dimensions[i] > 0 && _strides[i] > 0)
+		{
+			// Divided instead of multiplied, so corrupted dimensions cannot overflow
+			const uint64_t stride = static_cast<uint64_t>(_strides[i]);
+			inside = _dimensions[i] - 1 <= (availableElements - 1 - lastElement) / stride;
+			lastElement += inside ? (_dimensions[i] - 1) * stride : 0;
+		}
+	}
+	if (!empty && !inside)
+	{
+		Close();
+		throw new ThunderException("The tensor file is truncated: " + path);
+	}
+	_data = bytes + header.dataOffset;
+}
+
+void ThunderVision::MappedTensorFile::Close()
+{
+	if (_mapping != nullptr)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(_mapping);
+#else
+		munmap(_mapping, _size);
+#endif
+	}
+	_mapping = nullptr;
+	_size = 0;
+	_data = nullptr;
+	_dimensions.clear();
+	_strides.clear();
+}
@@ -0,0 +1,141 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace
+{
+struct ParallelForState
+{
+	std::atomic<int64_t> nextChunk{0};
+	std::atomic<int64_t> finishedChunks{0};
+	int64_t nrChunks = 0;
+	int64_t chunkSize = 0;
+	int64_t begin = 0;
+	int64_t end = 0;
+
+	std::mutex mutex;
+	std::condition_variable finished;
+	std::exception_ptr exception;
+};
+
+// Processes chunks until none are left. Workers which start after all chunks were taken return immediately, hence
+// the caller only has to wait for the chunks and not for the workers.
+void ProcessChunks(ParallelForState &state, const std::function<void(int64_t, int64_t, size_t)> &function, const size_t threadIndex)
+{
+	int64_t chunk;
+	while ((chunk = state.nextChunk.fetch_add(1)) < state.nrChunks)
+	{
+		const int64_t chunkBegin = state.begin + chunk * state.chunkSize;
+		const int64_t chunkEnd = std::min(state.end, chunkBegin + state.chunkSize);
+		try
+		{
+			function(chunkBegin, chunkEnd, threadIndex);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(state.mutex);
+			if (!state.exception)
+				state.exception = std::current_exception();
+		}
+
+		if (state.finishedChunks.fetch_add(1) + 1 == state.nrChunks)
+		{
+			std::lock_guard<std::mutex> lock(state.mutex);
+			state.finished.notify_all();
+		}
+	}
+}
+} // namespace
+
+ThunderVision::ThreadPool::ThreadPool(size_t nrThreads)
+{
+	for (size_t i = 1; i < nrThreads; i++)
+	{
+		_workers.emplace_back([this]() { WorkerLoop(); });
+	}
+}
+
+ThunderVision::ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_condition.notify_all();
+	for (auto &worker : _workers)
+	{
+		worker.join();
+	}
+}
+
+size_t ThunderVision::ThreadPool::GetNrThreads() const
+{
+	return _workers.size() + 1;
+}
+
+void ThunderVision::ThreadPool::ParallelFor(int64_t begin, int64_t end, const std::function<void(int64_t, int64_t, size_t)> &function)
+{
+	if (end <= begin)
+		return;
+
+	const int64_t nrThreads = static_cast<int64_t>(GetNrThreads());
+	if (nrThreads == 1)
+	{
+		function(begin, end, 0);
+		return;
+	}
+
+	// Several chunks per thread balance paths of different lengths
+	auto state = std::make_shared<ParallelForState>();
+	state->begin = begin;
+	state->end = end;
+	state->chunkSize = std::max<int64_t>(1, (end - begin) / (nrThreads * 4));
+	state->nrChunks = (end - begin + state->chunkSize - 1) / state->chunkSize;
+
+	const int64_t nrHelpers = std::min(nrThreads, state->nrChunks) - 1;
+	for (int64_t i = 1; i <= nrHelpers; i++)
+	{
+		Enqueue([state, &function, i]() { ProcessChunks(*state, function, static_cast<size_t>(i)); });
+	}
+	ProcessChunks(*state, function, 0);
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->finished.wait(lock, [&state]() { return state->finishedChunks.load() == state->nrChunks; });
+	if (state->exception)
+		std::rethrow_exception(state->exception);
+}
+
+ThunderVision::ThreadPool &ThunderVision::ThreadPool::GetDefault()
+{
+	static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+	return pool;
+}
+
+void ThunderVision::ThreadPool::Enqueue(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_tasks.push(std::move(task));
+	}
+	_condition.notify_one();
+}
+
+void ThunderVision::ThreadPool::WorkerLoop()
+{
+	while (true)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_condition.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+			if (_stopping && _tasks.empty())
+				return;
+			task = std::move(_tasks.front());
+			_tasks.pop();
+		}
+		task();
+	}
+}
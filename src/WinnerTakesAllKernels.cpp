@@ -0,0 +1,342 @@
+#include "WinnerTakesAllKernels.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace
+{
+using ThunderVision::SubpixelMode;
+using ThunderVision::WinnerTakesAllParameters;
+
+struct Selection
+{
+	unsigned int best;
+	unsigned int second;
+	size_t index;
+};
+
+/**
+* Lanes of the SIMD search: lane l sees the disparities d with d % width == l, so the neighbours of a disparity are
+* always in other lanes if the lanes are at least three apart. Every lane tracks its best cost, the index of the best
+* cost and its second best cost.
+*/
+template <size_t Width>
+struct Lanes
+{
+	unsigned int best[Width];
+	unsigned int second[Width];
+	int32_t index[Width];
+
+	void Update(const size_t lane, const unsigned int value, const int32_t d)
+	{
+		if (value < best[lane])
+		{
+			second[lane] = best[lane];
+			best[lane] = value;
+			index[lane] = d;
+		}
+		else
+		{
+			second[lane] = std::min(second[lane], value);
+		}
+	}
+
+	/**
+	* The best lane holds the minimum. The second best cost is the best cost of every other lane, unless that one is a
+	* neighbour of the minimum, then the second best cost of the lane.
+	*/
+	Selection Reduce() const
+	{
+		size_t bestLane = 0;
+		for (size_t l = 1; l < Width; l++)
+		{
+			if (best[l] < best[bestLane] || (best[l] == best[bestLane] && index[l] < index[bestLane]))
+				bestLane = l;
+		}
+
+		const int32_t index0 = index[bestLane];
+		unsigned int second0 = second[bestLane];
+		for (size_t l = 0; l < Width; l++)
+		{
+			if (l != bestLane)
+				second0 = std::min(second0, index[l] == index0 - 1 || index[l] == index0 + 1 ? second[l] : best[l]);
+		}
+		return {best[bestLane], second0, static_cast<size_t>(std::max(index0, 0))};
+	}
+};
+
+template <typename TAggregated>
+Selection SearchPortable(const TAggregated *aggregated, const size_t nrDisparities)
+{
+	Lanes<4> lanes;
+	std::fill(lanes.best, lanes.best + 4, UINT_MAX);
+	std::fill(lanes.second, lanes.second + 4, UINT_MAX);
+	std::fill(lanes.index, lanes.index + 4, -2);
+	for (size_t d = 0; d < nrDisparities; d++)
+	{
+		lanes.Update(d % 4, aggregated[d], static_cast<int32_t>(d));
+	}
+	return lanes.Reduce();
+}
+
+/**
+* Invalidates ambiguous disparities and adds the subpixel offset.
+*/
+template <typename TAggregated>
+float Refine(const TAggregated *aggregated, const size_t nrDisparities, const Selection &selection, const WinnerTakesAllParameters &parameters)
+{
+	if (parameters.uniquenessRatio > 0.0f && static_cast<float>(selection.second) < static_cast<float>(selection.best) * (1.0f + parameters.uniquenessRatio))
+		return parameters.invalidValue;
+
+	const size_t d = selection.index;
+	if (parameters.subpixel == SubpixelMode::None || d == 0 || d + 1 >= nrDisparities)
+		return static_cast<float>(d);
+
+	const float minus = static_cast<float>(aggregated[d - 1]);
+	const float center = static_cast<float>(selection.best);
+	const float plus = static_cast<float>(aggregated[d + 1]);
+	const float denominator = parameters.subpixel == SubpixelMode::Parabolic ? 2.0f * (minus - 2.0f * center + plus) : 2.0f * (std::max(minus, plus) - center);
+	if (denominator <= 0.0f)
+		return static_cast<float>(d);
+	return static_cast<float>(d) + (minus - plus) / denominator;
+}
+
+template <typename TAggregated, Selection (*Search)(const TAggregated *, const size_t)>
+void SelectDisparities(const TAggregated *aggregated, const size_t width, const size_t stride, const size_t nrDisparities, const WinnerTakesAllParameters &parameters, float *disparities)
+{
+	for (size_t x = 0; x < width; x++, aggregated += stride)
+	{
+		disparities[x] = Refine(aggregated, nrDisparities, Search(aggregated, nrDisparities), parameters);
+	}
+}
+
+/**
+* The best costs and their disparities of the right pixels are stored in reverse order, right pixel x at width - 1 - x,
+* so the right pixels of the diagonal costs of a left pixel are contiguous. The entries behind width belong to right
+* pixels left of the image. Update(left pixel x, first disparity d, count) takes over the smaller costs of
+* aggregated[x, d + i] for right pixel x - d - i, the first disparity wins for equal costs.
+*/
+template <typename TAggregated, void (*Update)(const TAggregated *, TAggregated *, TAggregated *, const size_t, const size_t)>
+void SelectRightDisparities(const TAggregated *aggregated, const size_t width, const size_t nrDisparities, const WinnerTakesAllParameters &parameters, TAggregated *buffer, float *disparities)
+{
+	TAggregated *bestCosts = buffer;
+	TAggregated *bestIndices = buffer + width + nrDisparities;
+	std::fill(bestCosts, bestCosts + width + nrDisparities, static_cast<TAggregated>(-1));
+	std::fill(bestIndices, bestIndices + width + nrDisparities, static_cast<TAggregated>(0));
+
+	for (size_t x = 0; x < width; x++)
+	{
+		Update(aggregated + x * nrDisparities, bestCosts + width - 1 - x, bestIndices + width - 1 - x, 0, nrDisparities);
+	}
+
+	for (size_t x = 0; x < width; x++)
+	{
+		const size_t d = static_cast<size_t>(bestIndices[width - 1 - x]);
+		const size_t count = std::min(nrDisparities, width - x);
+		float disparity = static_cast<float>(d);
+		if (parameters.subpixel != SubpixelMode::None && d > 0 && d + 1 < count)
+		{
+			const float minus = static_cast<float>(aggregated[(x + d - 1) * nrDisparities + d - 1]);
+			const float center = static_cast<float>(bestCosts[width - 1 - x]);
+			const float plus = static_cast<float>(aggregated[(x + d + 1) * nrDisparities + d + 1]);
+			const float denominator = parameters.subpixel == SubpixelMode::Parabolic ? 2.0f * (minus - 2.0f * center + plus) : 2.0f * (std::max(minus, plus) - center);
+			if (denominator > 0.0f)
+				disparity += (minus - plus) / denominator;
+		}
+		disparities[x] = disparity;
+	}
+}
+
+template <typename TAggregated>
+void UpdateRightPortable(const TAggregated *costs, TAggregated *bestCosts, TAggregated *bestIndices, const size_t begin, const size_t end)
+{
+	for (size_t d = begin; d < end; d++)
+	{
+		if (costs[d] < bestCosts[d])
+		{
+			bestCosts[d] = costs[d];
+			bestIndices[d] = static_cast<TAggregated>(d);
+		}
+	}
+}
+
+#ifdef THUNDER_X86
+// The unsigned comparisons flip the sign bit, the indices are kept in lanes of the width of the costs.
+// best starts at the largest cost, so lanes without a smaller cost have no index.
+
+template <typename TAggregated>
+THUNDER_TARGET_SSE41 Selection SearchSSE41(const TAggregated *aggregated, const size_t nrDisparities)
+{
+	constexpr size_t width = 16 / sizeof(TAggregated);
+	const __m128i bias = sizeof(TAggregated) == 4 ? _mm_set1_epi32(INT32_MIN) : _mm_set1_epi16(SHRT_MIN);
+	const __m128i step = sizeof(TAggregated) == 4 ? _mm_set1_epi32(width) : _mm_set1_epi16(width);
+	__m128i best = _mm_set1_epi8(-1);
+	__m128i second = best;
+	__m128i index = _mm_set1_epi8(-1);
+	__m128i d = sizeof(TAggregated) == 4 ? _mm_setr_epi32(0, 1, 2, 3) : _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+
+	size_t i = 0;
+	for (; i + width <= nrDisparities; i += width)
+	{
+		const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(aggregated + i));
+		__m128i less;
+		if constexpr (sizeof(TAggregated) == 4)
+		{
+			less = _mm_cmpgt_epi32(_mm_xor_si128(best, bias), _mm_xor_si128(value, bias));
+			second = _mm_blendv_epi8(_mm_min_epu32(second, value), best, less);
+		}
+		else
+		{
+			less = _mm_cmpgt_epi16(_mm_xor_si128(best, bias), _mm_xor_si128(value, bias));
+			second = _mm_blendv_epi8(_mm_min_epu16(second, value), best, less);
+		}
+		best = _mm_blendv_epi8(best, value, less);
+		index = _mm_blendv_epi8(index, d, less);
+		d = sizeof(TAggregated) == 4 ? _mm_add_epi32(d, step) : _mm_add_epi16(d, step);
+	}
+
+	Lanes<width> lanes;
+	alignas(16) TAggregated bestLanes[width];
+	alignas(16) TAggregated secondLanes[width];
+	alignas(16) TAggregated indexLanes[width];
+	_mm_store_si128(reinterpret_cast<__m128i *>(bestLanes), best);
+	_mm_store_si128(reinterpret_cast<__m128i *>(secondLanes), second);
+	_mm_store_si128(reinterpret_cast<__m128i *>(indexLanes), index);
+	for (size_t l = 0; l < width; l++)
+	{
+		// A lane whose costs are all saturated keeps its first disparity
+		lanes.best[l] = i == 0 ? UINT_MAX : bestLanes[l];
+		lanes.second[l] = i == 0 ? UINT_MAX : secondLanes[l];
+		lanes.index[l] = i == 0 ? -2 : (indexLanes[l] == static_cast<TAggregated>(-1) ? static_cast<int32_t>(l) : static_cast<int32_t>(indexLanes[l]));
+	}
+	for (; i < nrDisparities; i++)
+	{
+		lanes.Update(i % width, aggregated[i], static_cast<int32_t>(i));
+	}
+	return lanes.Reduce();
+}
+
+template <typename TAggregated>
+THUNDER_TARGET_AVX2 Selection SearchAVX2(const TAggregated *aggregated, const size_t nrDisparities)
+{
+	constexpr size_t width = 32 / sizeof(TAggregated);
+	const __m256i bias = sizeof(TAggregated) == 4 ? _mm256_set1_epi32(INT32_MIN) : _mm256_set1_epi16(SHRT_MIN);
+	const __m256i step = sizeof(TAggregated) == 4 ? _mm256_set1_epi32(width) : _mm256_set1_epi16(width);
+	__m256i best = _mm256_set1_epi8(-1);
+	__m256i second = best;
+	__m256i index = _mm256_set1_epi8(-1);
+	__m256i d = sizeof(TAggregated) == 4 ? _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7) : _mm256_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+	size_t i = 0;
+	for (; i + width <= nrDisparities; i += width)
+	{
+		const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(aggregated + i));
+		__m256i less;
+		if constexpr (sizeof(TAggregated) == 4)
+		{
+			less = _mm256_cmpgt_epi32(_mm256_xor_si256(best, bias), _mm256_xor_si256(value, bias));
+			second = _mm256_blendv_epi8(_mm256_min_epu32(second, value), best, less);
+		}
+		else
+		{
+			less = _mm256_cmpgt_epi16(_mm256_xor_si256(best, bias), _mm256_xor_si256(value, bias));
+			second = _mm256_blendv_epi8(_mm256_min_epu16(second, value), best, less);
+		}
+		best = _mm256_blendv_epi8(best, value, less);
+		index = _mm256_blendv_epi8(index, d, less);
+		d = sizeof(TAggregated) == 4 ? _mm256_add_epi32(d, step) : _mm256_add_epi16(d, step);
+	}
+
+	Lanes<width> lanes;
+	alignas(32) TAggregated bestLanes[width];
+	alignas(32) TAggregated secondLanes[width];
+	alignas(32) TAggregated indexLanes[width];
+	_mm256_store_si256(reinterpret_cast<__m256i *>(bestLanes), best);
+	_mm256_store_si256(reinterpret_cast<__m256i *>(secondLanes), second);
+	_mm256_store_si256(reinterpret_cast<__m256i *>(indexLanes), index);
+	for (size_t l = 0; l < width; l++)
+	{
+		// A lane whose costs are all saturated keeps its first disparity
+		lanes.best[l] = i == 0 ? UINT_MAX : bestLanes[l];
+		lanes.second[l] = i == 0 ? UINT_MAX : secondLanes[l];
+		lanes.index[l] = i == 0 ? -2 : (indexLanes[l] == static_cast<TAggregated>(-1) ? static_cast<int32_t>(l) : static_cast<int32_t>(indexLanes[l]));
+	}
+	for (; i < nrDisparities; i++)
+	{
+		lanes.Update(i % width, aggregated[i], static_cast<int32_t>(i));
+	}
+	return lanes.Reduce();
+}
+
+template <typename TAggregated>
+THUNDER_TARGET_SSE41 void UpdateRightSSE41(const TAggregated *costs, TAggregated *bestCosts, TAggregated *bestIndices, const size_t begin, const size_t end)
+{
+	constexpr size_t width = 16 / sizeof(TAggregated);
+	const __m128i bias = sizeof(TAggregated) == 4 ? _mm_set1_epi32(INT32_MIN) : _mm_set1_epi16(SHRT_MIN);
+	const __m128i step = sizeof(TAggregated) == 4 ? _mm_set1_epi32(width) : _mm_set1_epi16(width);
+	__m128i d = sizeof(TAggregated) == 4 ? _mm_add_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(static_cast<int>(begin)))
+										  : _mm_add_epi16(_mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7), _mm_set1_epi16(static_cast<short>(begin)));
+
+	size_t i = begin;
+	for (; i + width <= end; i += width)
+	{
+		const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(costs + i));
+		const __m128i best = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bestCosts + i));
+		const __m128i index = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bestIndices + i));
+		const __m128i less = sizeof(TAggregated) == 4 ? _mm_cmpgt_epi32(_mm_xor_si128(best, bias), _mm_xor_si128(value, bias))
+													  : _mm_cmpgt_epi16(_mm_xor_si128(best, bias), _mm_xor_si128(value, bias));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(bestCosts + i), _mm_blendv_epi8(best, value, less));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(bestIndices + i), _mm_blendv_epi8(index, d, less));
+		d = sizeof(TAggregated) == 4 ? _mm_add_epi32(d, step) : _mm_add_epi16(d, step);
+	}
+	UpdateRightPortable(costs, bestCosts, bestIndices, i, end);
+}
+
+template <typename TAggregated>
+THUNDER_TARGET_AVX2 void UpdateRightAVX2(const TAggregated *costs, TAggregated *bestCosts, TAggregated *bestIndices, const size_t begin, const size_t end)
+{
+	constexpr size_t width = 32 / sizeof(TAggregated);
+	const __m256i bias = sizeof(TAggregated) == 4 ? _mm256_set1_epi32(INT32_MIN) : _mm256_set1_epi16(SHRT_MIN);
+	const __m256i step = sizeof(TAggregated) == 4 ? _mm256_set1_epi32(width) : _mm256_set1_epi16(width);
+	__m256i d = sizeof(TAggregated) == 4 ? _mm256_add_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(static_cast<int>(begin)))
+										  : _mm256_add_epi16(_mm256_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), _mm256_set1_epi16(static_cast<short>(begin)));
+
+	size_t i = begin;
+	for (; i + width <= end; i += width)
+	{
+		const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(costs + i));
+		const __m256i best = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bestCosts + i));
+		const __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bestIndices + i));
+		const __m256i less = sizeof(TAggregated) == 4 ? _mm256_cmpgt_epi32(_mm256_xor_si256(best, bias), _mm256_xor_si256(value, bias))
+													  : _mm256_cmpgt_epi16(_mm256_xor_si256(best, bias), _mm256_xor_si256(value, bias));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(bestCosts + i), _mm256_blendv_epi8(best, value, less));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(bestIndices + i), _mm256_blendv_epi8(index, d, less));
+		d = sizeof(TAggregated) == 4 ? _mm256_add_epi32(d, step) : _mm256_add_epi16(d, step);
+	}
+	UpdateRightPortable(costs, bestCosts, bestIndices, i, end);
+}
+#endif // THUNDER_X86
+
+template <typename TAggregated, Selection (*Search)(const TAggregated *, const size_t), void (*UpdateRight)(const TAggregated *, TAggregated *, TAggregated *, const size_t, const size_t)>
+ThunderVision::WinnerTakesAllKernels<TAggregated> MakeKernels(const ThunderVision::SimdLevel level)
+{
+	return {SelectDisparities<TAggregated, Search>, SelectRightDisparities<TAggregated, UpdateRight>, level};
+}
+} // namespace
+
+template <typename TAggregated>
+ThunderVision::WinnerTakesAllKernels<TAggregated> ThunderVision::SelectWinnerTakesAllKernels(const SimdLevel maxLevel)
+{
+	const SimdLevel level = std::min(maxLevel, GetSupportedSimdLevel());
+#ifdef THUNDER_X86
+	if (level >= SimdLevel::AVX2)
+		return MakeKernels<TAggregated, SearchAVX2<TAggregated>, UpdateRightAVX2<TAggregated>>(SimdLevel::AVX2);
+	if (level >= SimdLevel::SSE41)
+		return MakeKernels<TAggregated, SearchSSE41<TAggregated>, UpdateRightSSE41<TAggregated>>(SimdLevel::SSE41);
+#endif
+	return MakeKernels<TAggregated, SearchPortable<TAggregated>, UpdateRightPortable<TAggregated>>(SimdLevel::Portable);
+}
+
+template ThunderVision::WinnerTakesAllKernels<unsigned int> ThunderVision::SelectWinnerTakesAllKernels<unsigned int>(const SimdLevel);
+template ThunderVision::WinnerTakesAllKernels<uint16_t> ThunderVision::SelectWinnerTakesAllKernels<uint16_t>(const SimdLevel);
@@ -0,0 +1,372 @@
+// Benchmark.cpp : Times the SGM pipeline over a sweep of configurations and writes the results as JSON.
+//
+// Usage: Benchmark [--sizes 320x240,640x480] [--disparities 64,128] [--directions 8,4diag,4axis] [--consistency 0,1]
+//                  [--warmup 2] [--repetitions 10] [--threads 0] [--json results.json]
+//                  [--left left.png --right right.png [--truth disparities.png|.pfm]]
+// Without --left and --right random dot pairs of the given sizes are matched. Real pairs are loaded from PNG files,
+// the optional ground truth is a KITTI style 16 bit PNG (disparity * 256, 0 is invalid) or a Middlebury PFM file.
+// The time per stage requires the library to be configured with THUNDER_PROFILING.
+#define NOMINMAX
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <Profiler.h>
+#include <SemiGlobalMatching.h>
+
+#include "ImageLoader.h"
+#include "SyntheticStereo.h"
+
+using namespace ThunderVision;
+
+namespace
+{
+struct Options
+{
+	std::vector<std::pair<size_t, size_t>> sizes = {{320, 240}, {640, 480}};
+	std::vector<size_t> disparities = {64, 128};
+	std::vector<AggregationDirections> directions = {AggregationDirections::Nr8, AggregationDirections::Nr4_Axis};
+	std::vector<bool> consistencyChecks = {false, true};
+	size_t warmup = 2;
+	size_t repetitions = 10;
+	size_t threads = 0;
+	std::string json;
+	std::string left;
+	std::string right;
+	std::string truth;
+};
+
+struct Statistics
+{
+	double median;
+	double p95;
+};
+
+struct Result
+{
+	size_t width;
+	size_t height;
+	size_t disparities;
+	AggregationDirections directions;
+	bool consistencyCheck;
+	Statistics total;
+	std::map<std::string, Statistics> stages;
+	double throughput;
+	// Fraction of the pixels with ground truth which are within one of it and which are invalid
+	double withinOne;
+	double invalid;
+};
+
+const char *DirectionsName(const AggregationDirections directions)
+{
+	switch (directions)
+	{
+	case AggregationDirections::Nr4_Diag:
+		return "4diag";
+	case AggregationDirections::Nr4_Axis:
+		return "4axis";
+	default:
+		return "8";
+	}
+}
+
+std::vector<std::string> Split(const std::string &text)
+{
+	std::vector<std::string> parts;
+	std::stringstream stream(text);
+	std::string part;
+	while (std::getline(stream, part, ','))
+	{
+		if (!part.empty())
+			parts.push_back(part);
+	}
+	return parts;
+}
+
+Options ParseOptions(int argc, char **argv)
+{
+	Options options;
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string name = argv[i];
+		if (i + 1 >= argc)
+			throw new ThunderException("Missing value of option " + name);
+		const std::string value = argv[++i];
+
+		if (name == "--sizes")
+		{
+			options.sizes.clear();
+			for (const std::string &size : Split(value))
+			{
+				const size_t separator = size.find('x');
+				if (separator == std::string::npos)
+					throw new ThunderException("Sizes are given as <width>x<height>: " + size);
+				options.sizes.emplace_back(std::stoul(size.substr(0, separator)), std::stoul(size.substr(separator + 1)));
+			}
+		}
+		else if (name == "--disparities")
+		{
+			options.disparities.clear();
+			for (const std::string &disparities : Split(value))
+				options.disparities.push_back(std::stoul(disparities));
+		}
+		else if (name == "--directions")
+		{
+			options.directions.clear();
+			for (const std::string &directions : Split(value))
+			{
+				if (directions == "8")
+					options.directions.push_back(AggregationDirections::Nr8);
+				else if (directions == "4diag")
+					options.directions.push_back(AggregationDirections::Nr4_Diag);
+				else if (directions == "4axis")
+					options.directions.push_back(AggregationDirections::Nr4_Axis);
+				else
+					throw new ThunderException("Unknown aggregation directions " + directions + " (8, 4diag or 4axis)");
+			}
+		}
+		else if (name == "--consistency")
+		{
+			options.consistencyChecks.clear();
+			for (const std::string &check : Split(value))
+				options.consistencyChecks.push_back(check == "1");
+		}
+		else if (name == "--warmup")
+			options.warmup = std::stoul(value);
+		else if (name == "--repetitions")
+			options.repetitions = std::max<size_t>(1, std::stoul(value));
+		else if (name == "--threads")
+			options.threads = std::stoul(value);
+		else if (name == "--json")
+			options.json = value;
+		else if (name == "--left")
+			options.left = value;
+		else if (name == "--right")
+			options.right = value;
+		else if (name == "--truth")
+			options.truth = value;
+		else
+			throw new ThunderException("Unknown option " + name);
+	}
+	if (options.left.empty() != options.right.empty())
+		throw new ThunderException("--left and --right have to be given together");
+	return options;
+}
+
+// Nearest rank percentile
+Statistics ComputeStatistics(std::vector<double> values)
+{
+	std::sort(values.begin(), values.end());
+	const auto rank = [&values](double percentile) { return values[std::min(values.size() - 1, static_cast<size_t>(std::ceil(percentile * values.size())) - 1)]; };
+	return {rank(0.5), rank(0.95)};
+}
+
+// Ground truth with negative values for unknown disparities
+Tensor<float> LoadTruth(const std::string &path)
+{
+	if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".pfm") == 0)
+	{
+		std::ifstream file(path, std::ios::binary);
+		std::string type;
+		size_t width, height;
+		float scale;
+		file >> type >> width >> height >> scale;
+		file.get();
+		if (!file || type != "Pf")
+			throw new ThunderException("Only single channel PFM files are supported: " + path);
+
+		// Rows are stored bottom to top, a negative scale marks little endian values
+		Tensor<float> truth({height, width});
+		std::vector<uint8_t> row(width * 4);
+		for (size_t y = height; y-- > 0;)
+		{
+			file.read(reinterpret_cast<char *>(row.data()), static_cast<std::streamsize>(row.size()));
+			for (size_t x = 0; x < width; x++)
+			{
+				uint8_t *bytes = row.data() + 4 * x;
+				if (scale > 0.0f)
+					std::reverse(bytes, bytes + 4);
+				float value;
+				std::memcpy(&value, bytes, sizeof(value));
+				truth[y * width + x] = std::isfinite(value) ? value : -1.0f;
+			}
+		}
+		if (!file)
+			throw new ThunderException("Truncated PFM file: " + path);
+		return truth;
+	}
+
+	std::vector<unsigned char> image;
+	unsigned width, height;
+	auto error = lodepng::decode(image, width, height, path.c_str(), LCT_GREY, 16);
+	if (error)
+		throw new ThunderException("Ground truth loading failed: " + std::string(lodepng_error_text(error)));
+	Tensor<float> truth({height, width});
+	for (size_t i = 0; i < truth.GetTotalSize(); i++)
+	{
+		const unsigned value = (static_cast<unsigned>(image[2 * i]) << 8) | image[2 * i + 1];
+		truth[i] = value == 0 ? -1.0f : static_cast<float>(value) / 256.0f;
+	}
+	return truth;
+}
+
+Tensor<uint8_t> LoadGrayscale(const std::string &path)
+{
+	Tensor<uint8_t> image;
+	ImageLoader::LoadImage(path, image, LCT_GREY);
+	return image;
+}
+
+Result Run(const StereoPair &pair, const size_t disparities, const AggregationDirections directions, const bool consistencyCheck, const Options &options)
+{
+	Result result;
+	result.height = pair.left.GetDimension(0);
+	result.width = pair.left.GetDimension(1);
+	result.disparities = disparities;
+	result.directions = directions;
+	result.consistencyCheck = consistencyCheck;
+
+	SemiGlobalMatching sgm(disparities, consistencyCheck, directions);
+	sgm.SetNrThreads(options.threads);
+	sgm.Prepare(result.width, result.height);
+
+	Tensor<float> output;
+	for (size_t i = 0; i < options.warmup; i++)
+	{
+		output = sgm.ComputeDisparities(pair.left, pair.right);
+	}
+
+	std::vector<double> totals;
+	std::map<std::string, std::vector<double>> stages;
+	for (size_t i = 0; i < options.repetitions; i++)
+	{
+		Profiler::Clear();
+		const auto start = std::chrono::steady_clock::now();
+		output = sgm.ComputeDisparities(pair.left, pair.right);
+		const auto end = std::chrono::steady_clock::now();
+		totals.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+		for (const ProfileSummary &stage : Profiler::Summarize())
+		{
+			stages[stage.name].push_back(stage.total);
+		}
+	}
+
+	result.total = ComputeStatistics(totals);
+	for (auto &stage : stages)
+	{
+		result.stages[stage.first] = ComputeStatistics(stage.second);
+	}
+	result.throughput = static_cast<double>(result.width * result.height * disparities) / (result.total.median * 1e3);
+
+	size_t known = 0, withinOne = 0, invalid = 0;
+	for (size_t i = 0; i < pair.disparity.GetTotalSize() && i < output.GetTotalSize(); i++)
+	{
+		if (pair.disparity[i] < 0.0f)
+			continue;
+		known++;
+		if (output[i] == std::numeric_limits<float>::max())
+			invalid++;
+		else if (std::abs(output[i] - pair.disparity[i]) <= 1.0f)
+			withinOne++;
+	}
+	result.withinOne = known > 0 ? static_cast<double>(withinOne) / known : 0.0;
+	result.invalid = known > 0 ? static_cast<double>(invalid) / known : 0.0;
+	return result;
+}
+
+void Print(const Result &result)
+{
+	std::cout << result.width << "x" << result.height << ", " << result.disparities << " disparities, " << DirectionsName(result.directions) << " directions, consistency check "
+			  << result.consistencyCheck << ": median " << result.total.median << "ms, p95 " << result.total.p95 << "ms, " << result.throughput << " MPix*D/s";
+	if (result.withinOne > 0.0)
+		std::cout << ", " << 100.0 * result.withinOne << "% within one, " << 100.0 * result.invalid << "% invalid";
+	std::cout << std::endl;
+	for (const auto &stage : result.stages)
+	{
+		std::cout << "    " << stage.first << ": median " << stage.second.median << "ms, p95 " << stage.second.p95 << "ms" << std::endl;
+	}
+}
+
+void WriteJson(const std::vector<Result> &results, const Options &options, std::ostream &stream)
+{
+	stream << "{\n  \"profiling\": " << (Profiler::IsCompiled() ? "true" : "false") << ",\n  \"warmup\": " << options.warmup << ",\n  \"repetitions\": " << options.repetitions
+		   << ",\n  \"results\": [";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const Result &result = results[i];
+		stream << (i == 0 ? "\n" : ",\n") << "    {\"width\": " << result.width << ", \"height\": " << result.height << ", \"disparities\": " << result.disparities
+			   << ", \"directions\": \"" << DirectionsName(result.directions) << "\", \"consistencyCheck\": " << (result.consistencyCheck ? "true" : "false")
+			   << ", \"medianMs\": " << result.total.median << ", \"p95Ms\": " << result.total.p95 << ", \"mpixDisparitiesPerSecond\": " << result.throughput
+			   << ", \"withinOne\": " << result.withinOne << ", \"invalid\": " << result.invalid << ", \"stages\": {";
+		bool first = true;
+		for (const auto &stage : result.stages)
+		{
+			stream << (first ? "" : ", ") << "\"" << stage.first << "\": {\"medianMs\": " << stage.second.median << ", \"p95Ms\": " << stage.second.p95 << "}";
+			first = false;
+		}
+		stream << "}}";
+	}
+	stream << "\n  ]\n}\n";
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+	try
+	{
+		const Options options = ParseOptions(argc, argv);
+		if (!Profiler::IsCompiled())
+			std::cout << "The library was built without THUNDER_PROFILING, only the total time is measured" << std::endl;
+
+		StereoPair loaded;
+		if (!options.left.empty())
+		{
+			loaded.left = LoadGrayscale(options.left);
+			loaded.right = LoadGrayscale(options.right);
+			if (!options.truth.empty())
+				loaded.disparity = LoadTruth(options.truth);
+		}
+		const size_t nrSizes = options.left.empty() ? options.sizes.size() : 1;
+
+		std::vector<Result> results;
+		for (size_t size = 0; size < nrSizes; size++)
+		{
+			for (size_t disparities : options.disparities)
+			{
+				// Random dot pairs are generated for the disparity count, so their ground truth is within range
+				const StereoPair pair = options.left.empty() ? SyntheticStereo::GenerateRandomDot(options.sizes[size].first, options.sizes[size].second, disparities, 1) : loaded;
+				for (AggregationDirections directions : options.directions)
+				{
+					for (bool consistencyCheck : options.consistencyChecks)
+					{
+						results.push_back(Run(pair, disparities, directions, consistencyCheck, options));
+						Print(results.back());
+					}
+				}
+			}
+		}
+
+		if (!options.json.empty())
+		{
+			std::ofstream file(options.json);
+			WriteJson(results, options, file);
+			if (!file)
+				throw new ThunderException("Writing " + options.json + " failed");
+		}
+		return 0;
+	}
+	catch (ThunderException *e)
+	{
+		std::cout << "Caught exception " << e->getMessage() << std::endl;
+		return -1;
+	}
+}
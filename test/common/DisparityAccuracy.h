@@ -0,0 +1,50 @@
+#pragma once
+#include <Tensor.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace ThunderVision;
+
+/**
+* Counts of the disparities compared with a ground truth: correct ones are within one of the ground truth, invalid
+* ones are FLT_MAX.
+*/
+struct DisparityAccuracy
+{
+	size_t correct = 0;
+	size_t invalid = 0;
+	size_t total = 0;
+
+	/**
+	* Compares the pixels at least margin away from the border and not left of firstX. Pixels without ground truth
+	* and pixels whose match lies left of the right image are skipped.
+	*/
+	static DisparityAccuracy Evaluate(const Tensor<float> &disparities, const Tensor<float> &truth, const size_t margin, const size_t firstX)
+	{
+		const size_t height = truth.GetDimension(0);
+		const size_t width = truth.GetDimension(1);
+		DisparityAccuracy accuracy;
+		for (size_t y = margin; y < height - margin; y++)
+		{
+			for (size_t x = std::max(margin, firstX); x < width - margin; x++)
+			{
+				const float expected = truth[y * width + x];
+				if (expected < 0.0f || expected > x)
+					continue;
+				accuracy.total++;
+				if (disparities[y * width + x] == std::numeric_limits<float>::max())
+					accuracy.invalid++;
+				else if (std::abs(disparities[y * width + x] - expected) <= 1.0f)
+					accuracy.correct++;
+			}
+		}
+		return accuracy;
+	}
+
+	// At least 95% of the valid disparities are correct and at most 15% of the disparities are invalid
+	bool Passed() const
+	{
+		return correct * 100 >= (total - invalid) * 95 && invalid * 100 <= total * 15;
+	}
+};
@@ -0,0 +1,241 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <Tensor.h>
+
+using namespace ThunderVision;
+
+/**
+* Straightforward scalar SGM with the parameters of SemiGlobalMatching: dense 5x5 CENSUS, Hamming costs, P1 = 20,
+* P2 = 40, 32 bit sums of the paths, the first minimum as winner and a 3x3 median with the border values of
+* MedianFilter. Every path is computed on its own from the border pixel where it enters the image. Optimized variants
+* have to reproduce these disparities, the harness in TestReference compares them.
+*/
+class ReferenceSGM
+{
+  public:
+	enum class RightDisparities
+	{
+		None,
+		Diagonal,
+		Recompute
+	};
+
+	struct Directions
+	{
+		int x;
+		int y;
+	};
+
+	static std::vector<Directions> AllDirections()
+	{
+		return {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+	}
+
+	ReferenceSGM(size_t maxDisparity, std::vector<Directions> directions = AllDirections()) : _maxDisparity(maxDisparity), _directions(directions)
+	{
+	}
+
+	Tensor<float> Compute(const Tensor<uint8_t> &left, const Tensor<uint8_t> &right, RightDisparities rightDisparities)
+	{
+		_width = left.GetDimension(1);
+		_height = left.GetDimension(0);
+		const std::vector<uint64_t> censusLeft = Census(left);
+		const std::vector<uint64_t> censusRight = Census(right);
+
+		const std::vector<unsigned int> aggregatedLeft = Aggregate(Costs(censusLeft, censusRight, true));
+		Tensor<float> disparitiesLeft = Median(WinnerTakesAll(aggregatedLeft));
+		if (rightDisparities == RightDisparities::None)
+			return disparitiesLeft;
+
+		Tensor<float> disparitiesRight;
+		if (rightDisparities == RightDisparities::Diagonal)
+			disparitiesRight = Median(DiagonalWinnerTakesAll(aggregatedLeft));
+		else
+			disparitiesRight = Median(WinnerTakesAll(Aggregate(Costs(censusLeft, censusRight, false))));
+		return ConsistencyCheck(disparitiesLeft, disparitiesRight);
+	}
+
+  private:
+	const uint16_t P1 = 20;
+	const uint16_t P2 = 40;
+	const uint16_t errorValue = UINT16_MAX - 40;
+	const uint64_t invalidCensus = UINT16_MAX;
+
+	size_t _maxDisparity;
+	std::vector<Directions> _directions;
+	size_t _width = 0;
+	size_t _height = 0;
+
+	std::vector<uint64_t> Census(const Tensor<uint8_t> &image)
+	{
+		std::vector<uint64_t> census(_width * _height, invalidCensus);
+		for (size_t y = 2; y + 2 < _height; y++)
+		{
+			for (size_t x = 2; x + 2 < _width; x++)
+			{
+				uint64_t vector = 0;
+				for (size_t k = 0; k < 25; k++)
+				{
+					const size_t windowY = y + k / 5 - 2;
+					const size_t windowX = x + k % 5 - 2;
+					if (image[y * _width + x] < image[windowY * _width + windowX])
+						vector |= uint64_t(1) << k;
+				}
+				census[y * _width + x] = vector;
+			}
+		}
+		return census;
+	}
+
+	// Matching costs of the left (matching x - d in the right image) or of the right image (x + d in the left image)
+	std::vector<uint16_t> Costs(const std::vector<uint64_t> &censusLeft, const std::vector<uint64_t> &censusRight, bool leftImage)
+	{
+		std::vector<uint16_t> costs(_width * _height * _maxDisparity, errorValue);
+		for (size_t y = 0; y < _height; y++)
+		{
+			for (size_t x = 0; x < _width; x++)
+			{
+				const uint64_t base = leftImage ? censusLeft[y * _width + x] : censusRight[y * _width + x];
+				if (base == invalidCensus)
+					continue;
+				for (size_t d = 0; d < _maxDisparity; d++)
+				{
+					if (leftImage ? d > x : x + d >= _width)
+						break;
+					const uint64_t other = leftImage ? censusRight[y * _width + x - d] : censusLeft[y * _width + x + d];
+					costs[(y * _width + x) * _maxDisparity + d] = static_cast<uint16_t>(__builtin_popcountll(base ^ other));
+				}
+			}
+		}
+		return costs;
+	}
+
+	std::vector<unsigned int> Aggregate(const std::vector<uint16_t> &costs)
+	{
+		const int64_t width = static_cast<int64_t>(_width);
+		const int64_t height = static_cast<int64_t>(_height);
+		const size_t nrDisparities = _maxDisparity;
+		std::vector<unsigned int> aggregated(costs.size(), 0);
+		std::vector<unsigned int> pathCosts(costs.size());
+		for (const Directions &direction : _directions)
+		{
+			// Pixels in the order of the direction, so the predecessor of a pixel is always computed before it
+			for (int64_t step = 0; step < width * height; step++)
+			{
+				const int64_t y = direction.y >= 0 ? step / width : height - 1 - step / width;
+				const int64_t x = direction.x >= 0 ? step % width : width - 1 - step % width;
+				const int64_t previousX = x - direction.x;
+				const int64_t previousY = y - direction.y;
+				const size_t pixel = static_cast<size_t>(y * width + x) * nrDisparities;
+				if (previousX < 0 || previousX >= width || previousY < 0 || previousY >= height)
+				{
+					for (size_t d = 0; d < nrDisparities; d++)
+						pathCosts[pixel + d] = costs[pixel + d];
+				}
+				else
+				{
+					const unsigned int *previous = pathCosts.data() + static_cast<size_t>(previousY * width + previousX) * nrDisparities;
+					const unsigned int previousMin = *std::min_element(previous, previous + nrDisparities);
+					for (size_t d = 0; d < nrDisparities; d++)
+					{
+						unsigned int best = std::min(previous[d], previousMin + P2);
+						if (d > 0)
+							best = std::min(best, previous[d - 1] + P1);
+						if (d + 1 < nrDisparities)
+							best = std::min(best, previous[d + 1] + P1);
+						pathCosts[pixel + d] = costs[pixel + d] + best - previousMin;
+					}
+				}
+				for (size_t d = 0; d < nrDisparities; d++)
+					aggregated[pixel + d] += pathCosts[pixel + d];
+			}
+		}
+		return aggregated;
+	}
+
+	Tensor<float> WinnerTakesAll(const std::vector<unsigned int> &aggregated)
+	{
+		Tensor<float> disparities({_height, _width});
+		for (size_t pixel = 0; pixel < _width * _height; pixel++)
+		{
+			const unsigned int *costs = aggregated.data() + pixel * _maxDisparity;
+			disparities[pixel] = static_cast<float>(std::min_element(costs, costs + _maxDisparity) - costs);
+		}
+		return disparities;
+	}
+
+	// Right pixel x matches left pixel x + d, whose costs of disparity d lie on a diagonal of the left volume
+	Tensor<float> DiagonalWinnerTakesAll(const std::vector<unsigned int> &aggregated)
+	{
+		Tensor<float> disparities({_height, _width});
+		for (size_t y = 0; y < _height; y++)
+		{
+			for (size_t x = 0; x < _width; x++)
+			{
+				size_t best = 0;
+				for (size_t d = 1; d < _maxDisparity && x + d < _width; d++)
+				{
+					if (aggregated[(y * _width + x + d) * _maxDisparity + d] < aggregated[(y * _width + x + best) * _maxDisparity + best])
+						best = d;
+				}
+				disparities[y * _width + x] = static_cast<float>(best);
+			}
+		}
+		return disparities;
+	}
+
+	// 3x3 median with the border rule of MedianFilter: every window element outside of the image is the error value
+	// max - 1, whose sign alternates with each such element in row major order over the whole image
+	Tensor<float> Median(const Tensor<float> &disparities)
+	{
+		Tensor<float> filtered({_height, _width});
+		float errorValue = std::numeric_limits<float>::max() - 1;
+		std::array<float, 9> window;
+		for (size_t y = 0; y < _height; y++)
+		{
+			for (size_t x = 0; x < _width; x++)
+			{
+				for (size_t k = 0; k < 9; k++)
+				{
+					const int64_t windowY = static_cast<int64_t>(y + k / 3) - 1;
+					const int64_t windowX = static_cast<int64_t>(x + k % 3) - 1;
+					if (windowY >= 0 && windowX >= 0 && windowY < static_cast<int64_t>(_height) && windowX < static_cast<int64_t>(_width))
+					{
+						window[k] = disparities[static_cast<size_t>(windowY) * _width + static_cast<size_t>(windowX)];
+					}
+					else
+					{
+						window[k] = errorValue;
+						errorValue = -errorValue;
+					}
+				}
+				std::sort(window.begin(), window.end());
+				filtered[y * _width + x] = window[4];
+			}
+		}
+		return filtered;
+	}
+
+	Tensor<float> ConsistencyCheck(const Tensor<float> &left, const Tensor<float> &right)
+	{
+		const float invalid = std::numeric_limits<float>::max();
+		Tensor<float> checked({_height, _width});
+		for (size_t y = 0; y < _height; y++)
+		{
+			for (size_t x = 0; x < _width; x++)
+			{
+				const float disparity = left[y * _width + x];
+				const float rightX = static_cast<float>(x) - disparity;
+				const float matching = disparity != invalid && rightX > -1.0f ? right[y * _width + static_cast<size_t>(static_cast<int>(rightX))] : invalid;
+				checked[y * _width + x] = std::abs(disparity - matching) < 1.1f ? (disparity + matching) / 2.0f : invalid;
+			}
+		}
+		return checked;
+	}
+};
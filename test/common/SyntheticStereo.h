@@ -0,0 +1,67 @@
+#pragma once
+#include <Tensor.h>
+#include <cstdint>
+#include <random>
+
+using namespace ThunderVision;
+
+struct StereoPair
+{
+	Tensor<uint8_t> left;
+	Tensor<uint8_t> right;
+	// Ground truth disparity of the left image, negative where the left pixel is not visible in the right image
+	Tensor<float> disparity;
+};
+
+class SyntheticStereo
+{
+  public:
+	/**
+	* Generates a random-dot stereo pair. The scene consists of a slanted background plane and a fronto-parallel box
+	* in front of it, all disparities are integers in [0, maxDisparity).
+	*/
+	static StereoPair GenerateRandomDot(const size_t width, const size_t height, const size_t maxDisparity, const unsigned int seed)
+	{
+		std::mt19937 generator(seed);
+		std::uniform_int_distribution<int> intensity(0, 255);
+
+		StereoPair pair;
+		pair.left.Resize({height, width});
+		pair.right.Resize({height, width});
+		pair.disparity.Resize({height, width});
+
+		for (size_t i = 0; i < width * height; i++)
+		{
+			pair.right[i] = static_cast<uint8_t>(intensity(generator));
+		}
+
+		const size_t backgroundMin = maxDisparity / 8;
+		const size_t backgroundRange = maxDisparity / 4;
+		const size_t boxDisparity = (maxDisparity * 3) / 4;
+
+		for (size_t y = 0; y < height; y++)
+		{
+			for (size_t x = 0; x < width; x++)
+			{
+				const size_t pos = y * width + x;
+				size_t d = backgroundMin + (backgroundRange * x) / width;
+				if (x > width / 3 && x < (width * 2) / 3 && y > height / 4 && y < (height * 3) / 4)
+				{
+					d = boxDisparity;
+				}
+
+				if (x >= d)
+				{
+					pair.left[pos] = pair.right[pos - d];
+					pair.disparity[pos] = static_cast<float>(d);
+				}
+				else
+				{
+					pair.left[pos] = static_cast<uint8_t>(intensity(generator));
+					pair.disparity[pos] = -1.0f;
+				}
+			}
+		}
+		return pair;
+	}
+};
@@ -0,0 +1,72 @@
+// RegressionTest.cpp : Checks the optimized algorithms against their reference behaviour.
+//
+#include <iostream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <Exceptions.h>
+
+#include "TestAllocation.h"
+#include "TestCensus.h"
+#include "TestCompactCostVolume.h"
+#include "TestConvolution.h"
+#include "TestGrayscale.h"
+#include "TestHammingCost.h"
+#include "TestCostStorage.h"
+#include "TestHierarchical.h"
+#include "TestImageLoader.h"
+#include "TestMedian.h"
+#include "TestProfiler.h"
+#include "TestRecursiveGaussian.h"
+#include "TestReference.h"
+#include "TestResize.h"
+#include "TestSeparableFilter.h"
+#include "TestStereoSession.h"
+#include "TestTensorFile.h"
+#include "TestTensorView.h"
+#include "TestThreading.h"
+#include "TestWinnerTakesAll.h"
+
+int main()
+{
+	std::vector<std::pair<std::string, std::function<bool()>>> tests = {
+		{"CostStorage", []() { return TestCostStorage().Run(); }},
+		{"TensorView", []() { return TestTensorView().Run(); }},
+		{"Allocation", []() { return TestAllocation().Run(); }},
+		{"Median", []() { return TestMedian().Run(); }},
+		{"SeparableFilter", []() { return TestSeparableFilter().Run(); }},
+		{"RecursiveGaussian", []() { return TestRecursiveGaussian().Run(); }},
+		{"Convolution", []() { return TestConvolution().Run(); }},
+		{"Resize", []() { return TestResize().Run(); }},
+		{"Hierarchical", []() { return TestHierarchical().Run(); }},
+		{"CompactCostVolume", []() { return TestCompactCostVolume().Run(); }},
+		{"HammingCost", []() { return TestHammingCost().Run(); }},
+		{"WinnerTakesAll", []() { return TestWinnerTakesAll().Run(); }},
+		{"Threading", []() { return TestThreading().Run(); }},
+		{"StereoSession", []() { return TestStereoSession().Run(); }},
+		{"Profiler", []() { return TestProfiler().Run(); }},
+		{"Reference", []() { return TestReference().Run(); }},
+		{"TensorFile", []() { return TestTensorFile().Run(); }},
+		{"ImageLoader", []() { return TestImageLoader().Run(); }},
+		{"Census", []() { return TestCensus().Run(); }},
+		{"Grayscale", []() { return TestGrayscale().Run(); }},
+	};
+
+	int failures = 0;
+	for (auto &test : tests)
+	{
+		try
+		{
+			bool success = test.second();
+			std::cout << (success ? "[PASSED] " : "[FAILED] ") << test.first << std::endl;
+			failures += success ? 0 : 1;
+		}
+		catch (ThunderVision::ThunderException *e)
+		{
+			std::cout << "[FAILED] " << test.first << ": caught exception " << e->getMessage() << std::endl;
+			failures++;
+		}
+	}
+	return failures;
+}
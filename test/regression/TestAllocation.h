@@ -0,0 +1,68 @@
+#pragma once
+#include <iostream>
+
+#include <SemiGlobalMatching.h>
+#include <MedianFilter.h>
+#include <GaussianBlur.h>
+#include <ImageResizing.h>
+#include <ColorspaceConversion.h>
+#include <MemoryPool.h>
+
+#include "SyntheticStereo.h"
+
+using namespace ThunderVision;
+
+/**
+* Processes a sequence of frames of the same size and checks that the tensor storage is 64 byte aligned and that no
+* heap memory is allocated for tensors once the buffers of the first frame are recycled by the pool.
+*/
+class TestAllocation
+{
+  public:
+	bool Run()
+	{
+		auto pair = SyntheticStereo::GenerateRandomDot(width, height, maxDisparity, 5);
+		Tensor<uint8_t> rgb({height, width, 3});
+		for (size_t i = 0; i < rgb.GetTotalSize(); i++)
+		{
+			rgb[i] = pair.left[i / 3];
+		}
+
+		SemiGlobalMatching sgm(maxDisparity, true, AggregationDirections::Nr8);
+		bool aligned = true;
+		auto processFrame = [&]() {
+			auto gray = ColorspaceConversion::ConvertToGrayscale<uint8_t>(rgb);
+			auto disparities = sgm.ComputeDisparities(pair.left, pair.right);
+			auto median = medianFilter.ApplyMedianFilter<3, 3>(pair.left);
+			auto blurred = gaussianBlur.ApplyGaussian(pair.left, 1.0);
+			auto downscaled = resizing.DownscaleImage<uint8_t, float>(pair.left, width / 2, height / 2);
+			aligned &= IsAligned(gray.Data()) && IsAligned(disparities.Data()) && IsAligned(median.Data()) && IsAligned(blurred.Data()) && IsAligned(downscaled.Data());
+		};
+
+		processFrame();
+		const auto before = GetHeapAllocationCounters();
+		for (int frame = 0; frame < 3; frame++)
+		{
+			processFrame();
+		}
+		const auto after = GetHeapAllocationCounters();
+
+		std::cout << "Allocation: " << after.allocations - before.allocations << " heap allocations in the steady state, buffers "
+				  << (aligned ? "aligned" : "not aligned") << std::endl;
+		return aligned && after.allocations == before.allocations;
+	}
+
+  private:
+	const size_t width = 128;
+	const size_t height = 64;
+	const size_t maxDisparity = 32;
+
+	MedianFilter medianFilter;
+	GaussianBlur gaussianBlur;
+	ImageResizing resizing;
+
+	bool IsAligned(const void *pointer)
+	{
+		return reinterpret_cast<uintptr_t>(pointer) % TensorAlignment == 0;
+	}
+};
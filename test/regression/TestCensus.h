@@ -0,0 +1,105 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include <CensusTransform.h>
+
+using namespace ThunderVision;
+
+/**
+* Compares the 8 bit CENSUS row kernels of every SIMD level with a scalar computation of the bits for all windows and
+* types. The widths cover images narrower than the window and interiors which are not multiples of the vector widths,
+* a crop checks rows whose stride differs from the width.
+*/
+class TestCensus
+{
+  public:
+	bool Run()
+	{
+		bool success = true;
+		for (CensusWindow window : {CensusWindow::W5x5, CensusWindow::W7x7, CensusWindow::W9x7})
+		{
+			for (CensusType type : {CensusType::Dense, CensusType::CenterSymmetric})
+			{
+				const CensusTransform census(window, type);
+				for (SimdLevel level : {SimdLevel::Portable, SimdLevel::SSE41, SimdLevel::AVX2})
+				{
+					if (level > GetSupportedSimdLevel())
+					{
+						std::cout << "Census: level " << static_cast<int>(level) << " is not supported by the CPU" << std::endl;
+						continue;
+					}
+					for (size_t width : {size_t{4}, size_t{9}, size_t{24}, size_t{27}, size_t{40}, size_t{41}, size_t{57}, size_t{77}})
+					{
+						const Tensor<uint8_t> image = Pattern(height, width);
+						success &= Compare(census, TensorView<const uint8_t>(image), level, Name(census) + ", level " + std::to_string(static_cast<int>(level)) + ", width " + std::to_string(width));
+					}
+					const Tensor<uint8_t> image = Pattern(height + 4, 90);
+					success &= Compare(census, TensorView<const uint8_t>(image).Crop(2, 3, height, 71), level, Name(census) + ", level " + std::to_string(static_cast<int>(level)) + ", crop");
+				}
+			}
+		}
+		if (success)
+			std::cout << "Census: all row kernels match" << std::endl;
+		return success;
+	}
+
+  private:
+	const size_t height = 11;
+
+	// Random values with runs of equal pixels and the extremes, which the signed SIMD comparisons have to order
+	Tensor<uint8_t> Pattern(size_t rows, size_t columns)
+	{
+		Tensor<uint8_t> image({rows, columns});
+		for (size_t i = 0; i < image.GetTotalSize(); i++)
+		{
+			const uint32_t value = static_cast<uint32_t>((i * 2654435761u) >> 13);
+			image[i] = value % 7 == 0 ? 0 : (value % 7 == 1 ? 255 : static_cast<uint8_t>(i % 5 == 0 ? 128 : value));
+		}
+		return image;
+	}
+
+	bool Compare(const CensusTransform &census, const TensorView<const uint8_t> &image, const SimdLevel level, const std::string &name)
+	{
+		Tensor<uint64_t> result;
+		census.Compute(image, result, ThreadPool::GetDefault(), level);
+
+		const size_t radiusX = census.GetWindowWidth() / 2;
+		const size_t radiusY = census.GetWindowHeight() / 2;
+		for (size_t y = 0; y < image.GetDimension(0); y++)
+		{
+			for (size_t x = 0; x < image.GetDimension(1); x++)
+			{
+				const bool inside = y >= radiusY && y + radiusY < image.GetDimension(0) && x >= radiusX && x + radiusX < image.GetDimension(1);
+				const uint64_t expected = inside ? Reference(census, image, y, x) : census.GetInvalidValue();
+				if (result.At(y, x) != expected)
+				{
+					std::cout << "Census " << name << ": mismatch at (" << y << ", " << x << ")" << std::endl;
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	uint64_t Reference(const CensusTransform &census, const TensorView<const uint8_t> &image, const size_t y, const size_t x)
+	{
+		const size_t windowWidth = census.GetWindowWidth();
+		const size_t windowSize = windowWidth * census.GetWindowHeight();
+		auto pixel = [&](size_t k) { return image.At(y + k / windowWidth - census.GetWindowHeight() / 2, x + k % windowWidth - windowWidth / 2); };
+
+		uint64_t vector = 0;
+		for (size_t k = 0; k < census.GetNrBits(); k++)
+		{
+			const bool bit = census.GetType() == CensusType::Dense ? image.At(y, x) < pixel(k) : pixel(k) < pixel(windowSize - 1 - k);
+			vector |= static_cast<uint64_t>(bit) << k;
+		}
+		return vector;
+	}
+
+	std::string Name(const CensusTransform &census)
+	{
+		return std::to_string(census.GetWindowWidth()) + "x" + std::to_string(census.GetWindowHeight()) + (census.GetType() == CensusType::Dense ? " dense" : " center symmetric");
+	}
+};
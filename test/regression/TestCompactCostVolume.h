@@ -0,0 +1,124 @@
+#pragma once
+#include <iostream>
+#include <limits>
+
+#include <SemiGlobalMatching.h>
+
+#include "DisparityAccuracy.h"
+#include "SyntheticStereo.h"
+
+using namespace ThunderVision;
+
+/**
+* Compares the compact cost volume with the dense volume on a random dot pair. With the full range the disparities
+* away from the left border have to match the dense disparities, since only paths through the border pixels see
+* different costs. With ranges of +-4 around the ground truth at least 95% of the visible pixels have to be within
+* one of the ground truth. The margins of the CENSUS transform and the median filter are excluded. Pixels left of
+* their minimum disparity have empty ranges and have to be invalid.
+*/
+class TestCompactCostVolume
+{
+  public:
+	bool Run()
+	{
+		bool success = true;
+		for (bool consistencyCheck : {false, true})
+		{
+			success &= CompareFullRange(consistencyCheck) && CheckRestricted(consistencyCheck) && CheckEmptyRanges(consistencyCheck);
+		}
+		return success;
+	}
+
+  private:
+	const size_t width = 192;
+	const size_t height = 96;
+	const size_t maxDisparity = 64;
+	// CENSUS radius (5x5) plus median radius (3x3)
+	const size_t margin = 3;
+
+	bool CompareFullRange(const bool consistencyCheck)
+	{
+		auto pair = SyntheticStereo::GenerateRandomDot(width, height, maxDisparity, 5);
+
+		// The compact volume recomputes the right disparities for the consistency check
+		SemiGlobalMatching dense(maxDisparity, consistencyCheck, AggregationDirections::Nr8);
+		dense.SetConsistencyMode(ConsistencyMode::Recompute);
+		auto denseDisparities = dense.ComputeDisparities(pair.left, pair.right);
+
+		SemiGlobalMatching compact(maxDisparity, consistencyCheck, AggregationDirections::Nr8);
+		compact.SetCompactCostVolume(true);
+		auto compactDisparities = compact.ComputeDisparities(pair.left, pair.right);
+
+		size_t mismatches = 0;
+		size_t total = 0;
+		for (size_t y = margin; y < height - margin; y++)
+		{
+			for (size_t x = margin + maxDisparity; x < width - margin; x++)
+			{
+				total++;
+				if (denseDisparities[y * width + x] != compactDisparities[y * width + x])
+					mismatches++;
+			}
+		}
+
+		std::cout << "CompactCostVolume (consistency check " << consistencyCheck << ", full range): " << mismatches << " of " << total
+				  << " disparities differ from the dense volume" << std::endl;
+		return mismatches * 100 <= total;
+	}
+
+	bool CheckRestricted(const bool consistencyCheck)
+	{
+		auto pair = SyntheticStereo::GenerateRandomDot(width, height, maxDisparity, 5);
+
+		Tensor<int32_t> minima({height, width});
+		Tensor<int32_t> maxima({height, width});
+		for (size_t i = 0; i < width * height; i++)
+		{
+			const int32_t truth = pair.disparity[i] < 0.0f ? 0 : static_cast<int32_t>(pair.disparity[i]);
+			minima[i] = truth - 4;
+			maxima[i] = truth + 4;
+		}
+
+		SemiGlobalMatching sgm(maxDisparity, consistencyCheck, AggregationDirections::Nr8);
+		sgm.SetDisparityRanges(minima, maxima);
+		auto disparities = sgm.ComputeDisparities(pair.left, pair.right);
+
+		const DisparityAccuracy accuracy = DisparityAccuracy::Evaluate(disparities, pair.disparity, margin, 0);
+		std::cout << "CompactCostVolume (consistency check " << consistencyCheck << ", ranges +-4): " << accuracy.correct << " of " << accuracy.total
+				  << " disparities within one of the ground truth, " << accuracy.invalid << " invalid" << std::endl;
+		return accuracy.Passed();
+	}
+
+	bool CheckEmptyRanges(const bool consistencyCheck)
+	{
+		const size_t imageWidth = 128;
+		const size_t imageHeight = 64;
+		const int32_t minimum = 10;
+		const int32_t maximum = 32;
+		auto pair = SyntheticStereo::GenerateRandomDot(imageWidth, imageHeight, maximum, 3);
+
+		Tensor<int32_t> minima({imageHeight, imageWidth});
+		Tensor<int32_t> maxima({imageHeight, imageWidth});
+		minima.Fill(minimum);
+		maxima.Fill(maximum);
+
+		SemiGlobalMatching sgm(static_cast<size_t>(maximum), consistencyCheck, AggregationDirections::Nr8);
+		sgm.SetDisparityRanges(minima, maxima);
+		auto disparities = sgm.ComputeDisparities(pair.left, pair.right);
+
+		size_t wrong = 0;
+		for (size_t y = margin; y < imageHeight - margin; y++)
+		{
+			for (size_t x = 0; x < imageWidth; x++)
+			{
+				const float disparity = disparities[y * imageWidth + x];
+				const bool invalid = disparity == std::numeric_limits<float>::max();
+				if (x < static_cast<size_t>(minimum) ? !invalid : !invalid && (disparity < minimum || disparity >= maximum))
+					wrong++;
+			}
+		}
+
+		std::cout << "CompactCostVolume (consistency check " << consistencyCheck << ", empty ranges): " << wrong << " disparities outside of their range" << std::endl;
+		return wrong == 0;
+	}
+};
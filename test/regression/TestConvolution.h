@@ -0,0 +1,176 @@
+#pragma once
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include <FilterUtil.h>
+#include <SeparableFilter.h>
+
+using namespace ThunderVision;
+
+/**
+* Compares the convolutions of FilterUtil (Sobel, Scharr, box, separable and 2D kernels) against a double precision
+* reference for all border modes and instruction sets. Integer kernels have to be exact, float results within 1e-3
+* and rounded integers within one.
+*/
+class TestConvolution
+{
+  public:
+	bool Run()
+	{
+		bool success = true;
+		for (BorderMode border : {BorderMode::Reflect, BorderMode::Replicate, BorderMode::Constant})
+		{
+			for (size_t channels : {1, 3})
+			{
+				success &= CheckAll(border, channels);
+			}
+		}
+		std::cout << "Convolution: " << (success ? "matches the reference" : "mismatch") << std::endl;
+		return success;
+	}
+
+  private:
+	const size_t width = 101;
+	const size_t height = 37;
+	const double borderValue = 77.0;
+
+	bool CheckAll(BorderMode border, size_t channels)
+	{
+		const Tensor<uint8_t> image8 = RandomImage<uint8_t>(channels, 256);
+		const Tensor<uint16_t> image16 = RandomImage<uint16_t>(channels, 65536);
+		const Tensor<float> imageFloat = RandomImage<float>(channels, 10000);
+
+		const std::vector<double> derivative = {-1, 0, 1};
+		const std::vector<double> sobel = {1, 2, 1};
+		const std::vector<double> scharr = {3, 10, 3};
+		const std::vector<double> box = {1, 1, 1, 1, 1};
+		const std::vector<double> gaussianX = {0.1, 0.2, 0.4, 0.2, 0.1};
+		const std::vector<double> gaussianY = {0.25, 0.5, 0.25};
+
+		std::mt19937 random(static_cast<uint32_t>(channels));
+		Tensor<double> integer2D({5, 3});
+		Tensor<double> float2D({3, 7});
+		for (size_t i = 0; i < integer2D.GetTotalSize(); i++)
+		{
+			integer2D[i] = static_cast<double>(static_cast<int>(random() % 9) - 4);
+		}
+		for (size_t i = 0; i < float2D.GetTotalSize(); i++)
+		{
+			float2D[i] = static_cast<double>(random() % 1000) / 1000.0 - 0.5;
+		}
+
+		bool success = true;
+		for (int level = 0; level <= static_cast<int>(GetSupportedSimdLevel()); level++)
+		{
+			SeparableFilter filter(static_cast<SimdLevel>(level));
+			const TensorView<const uint8_t> view8(image8);
+
+			Tensor<int16_t> gradient;
+			filter.Apply(view8, ToTensor(derivative), ToTensor(sobel), gradient, border, borderValue);
+			success &= Compare("Sobel x", image8, Outer(sobel, derivative), border, gradient, 0.0);
+			filter.Apply(view8, ToTensor(scharr), ToTensor(derivative), gradient, border, borderValue);
+			success &= Compare("Scharr y", image8, Outer(derivative, scharr), border, gradient, 0.0);
+
+			Tensor<int16_t> boxSum;
+			filter.Apply(view8, ToTensor(box), ToTensor(box), boxSum, border, borderValue);
+			success &= Compare("Box sum", image8, Outer(box, box), border, boxSum, 0.0);
+
+			Tensor<uint8_t> blurred;
+			filter.Apply(view8, ToTensor(gaussianX), ToTensor(gaussianY), blurred, border, borderValue);
+			success &= Compare("Gaussian", image8, Outer(gaussianY, gaussianX), border, blurred, 1.0);
+
+			Tensor<int16_t> integer;
+			filter.Apply2D(view8, integer2D, integer, border, borderValue);
+			success &= Compare("Integer 2D", image8, integer2D, border, integer, 0.0);
+
+			Tensor<float> sobel16;
+			filter.Apply(TensorView<const uint16_t>(image16), ToTensor(derivative), ToTensor(sobel), sobel16, border, borderValue);
+			success &= Compare("Sobel x uint16_t", image16, Outer(sobel, derivative), border, sobel16, 0.0);
+
+			Tensor<float> filtered;
+			filter.Apply2D(TensorView<const float>(imageFloat), float2D, filtered, border, borderValue);
+			success &= Compare("Float 2D", imageFloat, float2D, border, filtered, 1e-3);
+		}
+
+		// The FilterUtil wrappers use the same engine
+		FilterUtil util;
+		Tensor<int16_t> gradient;
+		util.ApplyDerivative<0, 1>(TensorView<const uint8_t>(image8), gradient, FilterUtil::DerivativeKernel::Scharr, border, borderValue);
+		success &= Compare("FilterUtil Scharr", image8, Outer(derivative, scharr), border, gradient, 0.0);
+		Tensor<uint8_t> mean;
+		util.ApplyBoxFilter<5>(TensorView<const uint8_t>(image8), mean, true, border, borderValue);
+		success &= Compare("FilterUtil box", image8, Outer({0.2, 0.2, 0.2, 0.2, 0.2}, {0.2, 0.2, 0.2, 0.2, 0.2}), border, mean, 1.0);
+		return success;
+	}
+
+	template <typename T>
+	Tensor<T> RandomImage(size_t channels, uint32_t range)
+	{
+		std::mt19937 random(static_cast<uint32_t>(channels * 7 + range));
+		Tensor<T> image({height, width, channels});
+		for (size_t i = 0; i < image.GetTotalSize(); i++)
+		{
+			image[i] = std::is_same<T, float>::value ? static_cast<T>((random() % range) / 37.0) : static_cast<T>(random() % range);
+		}
+		return image;
+	}
+
+	// 2D kernel of shape (y.size, x.size) with the weights y[i] * x[j]
+	Tensor<double> Outer(const std::vector<double> &y, const std::vector<double> &x)
+	{
+		Tensor<double> kernel({y.size(), x.size()});
+		for (size_t i = 0; i < y.size(); i++)
+		{
+			for (size_t j = 0; j < x.size(); j++)
+			{
+				kernel[i * x.size() + j] = y[i] * x[j];
+			}
+		}
+		return kernel;
+	}
+
+	Tensor<double> ToTensor(const std::vector<double> &weights)
+	{
+		Tensor<double> kernel({weights.size()});
+		std::copy(weights.begin(), weights.end(), kernel.Data());
+		return kernel;
+	}
+
+	template <typename TIn, typename TOut>
+	bool Compare(const char *name, const Tensor<TIn> &image, const Tensor<double> &kernel, BorderMode border, const Tensor<TOut> &actual, double tolerance)
+	{
+		const int64_t channels = static_cast<int64_t>(image.GetDimension(2));
+		const int64_t rows = static_cast<int64_t>(kernel.GetDimension(0));
+		const int64_t columns = static_cast<int64_t>(kernel.GetDimension(1));
+		const double fill = static_cast<double>(FilterUtil::RoundAndSaturate<TIn>(static_cast<float>(borderValue)));
+
+		for (int64_t y = 0; y < static_cast<int64_t>(height); y++)
+		{
+			for (int64_t x = 0; x < static_cast<int64_t>(width); x++)
+			{
+				for (int64_t c = 0; c < channels; c++)
+				{
+					double expected = 0.0;
+					for (int64_t i = 0; i < rows; i++)
+					{
+						for (int64_t j = 0; j < columns; j++)
+						{
+							const int64_t sourceY = FilterUtil::BorderIndex(y + i - rows / 2, static_cast<int64_t>(height), border);
+							const int64_t sourceX = FilterUtil::BorderIndex(x + j - columns / 2, static_cast<int64_t>(width), border);
+							const double pixel = sourceY < 0 || sourceX < 0 ? fill : static_cast<double>(image[(sourceY * static_cast<int64_t>(width) + sourceX) * channels + c]);
+							expected += kernel[i * columns + j] * pixel;
+						}
+					}
+					const double value = static_cast<double>(actual[(y * static_cast<int64_t>(width) + x) * channels + c]);
+					if (std::abs(value - expected) > tolerance)
+					{
+						std::cout << "Convolution " << name << " differs from the reference at (" << x << ", " << y << "): " << value << " != " << expected << std::endl;
+						return false;
+					}
+				}
+			}
+		}
+		return true;
+	}
+};
@@ -0,0 +1,66 @@
+#pragma once
+#include <iostream>
+
+#include <SemiGlobalMatching.h>
+
+#include "SyntheticStereo.h"
+
+using namespace ThunderVision;
+
+/**
+* Compares the disparities of the 16 bit saturated cost storage with the 32 bit storage. Only the sums of invalid
+* matching costs saturate, which are found at pixels without a valid CENSUS vector. These pixels and their neighbours
+* within the median filter are excluded. With the consistency check the left pixels which can be matched to the border
+* of the right image are excluded as well.
+*/
+class TestCostStorage
+{
+  public:
+	bool Run()
+	{
+		bool success = true;
+		for (bool consistencyCheck : {false, true})
+		{
+			for (auto directions : {AggregationDirections::Nr8, AggregationDirections::Nr4_Axis, AggregationDirections::Nr4_Diag})
+			{
+				success &= Compare(consistencyCheck, directions);
+			}
+		}
+		return success;
+	}
+
+  private:
+	const size_t width = 192;
+	const size_t height = 96;
+	const size_t maxDisparity = 64;
+	// CENSUS radius (5x5) plus median radius (3x3)
+	const size_t margin = 3;
+
+	bool Compare(const bool consistencyCheck, const AggregationDirections directions)
+	{
+		auto pair = SyntheticStereo::GenerateRandomDot(width, height, maxDisparity, 7);
+
+		SemiGlobalMatching sgm32(maxDisparity, consistencyCheck, directions);
+		auto disparities32 = sgm32.ComputeDisparities(pair.left, pair.right);
+
+		SemiGlobalMatching sgm16(maxDisparity, consistencyCheck, directions);
+		sgm16.SetCostStorage(CostStorage::UInt16Saturated);
+		auto disparities16 = sgm16.ComputeDisparities(pair.left, pair.right);
+
+		const size_t startX = consistencyCheck ? margin + maxDisparity : margin;
+
+		size_t mismatches = 0;
+		for (size_t y = margin; y < height - margin; y++)
+		{
+			for (size_t x = startX; x < width - margin; x++)
+			{
+				if (disparities32[y * width + x] != disparities16[y * width + x])
+					mismatches++;
+			}
+		}
+
+		std::cout << "CostStorage (consistency check " << consistencyCheck << ", directions " << static_cast<int>(directions) << "): "
+				  << mismatches << " mismatching disparities" << std::endl;
+		return mismatches == 0;
+	}
+};
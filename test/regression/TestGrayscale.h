@@ -0,0 +1,164 @@
+#pragma once
+#include <iostream>
+#include <string>
+
+#include <CensusTransform.h>
+#include <ColorspaceConversion.h>
+#include <SemiGlobalMatching.h>
+#include <StereoSession.h>
+
+#include "SyntheticStereo.h"
+
+using namespace ThunderVision;
+
+/**
+* Checks the fixed point grayscale conversion of every SIMD level against a scalar computation of the weights, the
+* CENSUS transform of RGB rows against the transform of the converted image and the disparities of RGB pairs against
+* the disparities of their grayscale images.
+*/
+class TestGrayscale
+{
+  public:
+	bool Run()
+	{
+		bool success = true;
+		for (size_t width : {size_t{1}, size_t{15}, size_t{16}, size_t{33}, size_t{70}})
+		{
+			const Tensor<uint8_t> rgb = Pattern(9, width, 3);
+			for (GrayscaleWeights weights : {GrayscaleWeights::Average, GrayscaleWeights::BT601, GrayscaleWeights::BT709})
+			{
+				const Tensor<uint8_t> expected = Reference(TensorView<const uint8_t>(rgb), weights);
+				for (SimdLevel level : {SimdLevel::Portable, SimdLevel::SSE41, SimdLevel::AVX2})
+				{
+					Tensor<uint8_t> grayscale;
+					ColorspaceConversion::ConvertToGrayscale(rgb, grayscale, weights, ThreadPool::GetDefault(), level);
+					success &= Check("conversion (width " + std::to_string(width) + ", " + Name(weights) + ", level " + std::to_string(static_cast<int>(level)) + ")",
+									 Equal(grayscale, expected));
+				}
+			}
+		}
+
+		const Tensor<uint8_t> rgb = Pattern(20, 50, 3);
+		Tensor<uint8_t> average;
+		ColorspaceConversion::ConvertToGrayscale(rgb, average);
+		Tensor<uint8_t> legacy = ColorspaceConversion::ConvertToGrayscale<uint8_t>(rgb);
+		legacy.Squeeze();
+		success &= Check("average equals the float conversion", Equal(average, legacy));
+
+		const Tensor<uint8_t> rgba = Pattern(24, 60, 4);
+		const auto crop = TensorView<const uint8_t>(rgba).Crop(2, 3, 20, 50);
+		Tensor<uint8_t> strided;
+		ColorspaceConversion::ConvertToGrayscale(crop, strided, GrayscaleWeights::BT601);
+		success &= Check("strided RGBA", Equal(strided, Reference(crop, GrayscaleWeights::BT601)));
+
+		auto pair = SyntheticStereo::GenerateRandomDot(width, height, maxDisparity, 23);
+		const Tensor<uint8_t> leftRGB = Colorize(pair.left, 1);
+		const Tensor<uint8_t> rightRGB = Colorize(pair.right, 2);
+		Tensor<uint8_t> leftGray, rightGray;
+		ColorspaceConversion::ConvertToGrayscale(leftRGB, leftGray, GrayscaleWeights::BT709);
+		ColorspaceConversion::ConvertToGrayscale(rightRGB, rightGray, GrayscaleWeights::BT709);
+
+		for (CensusWindow window : {CensusWindow::W5x5, CensusWindow::W9x7})
+		{
+			CensusTransform census(window, window == CensusWindow::W5x5 ? CensusType::Dense : CensusType::CenterSymmetric);
+			Tensor<uint64_t> fromRGB, fromGray;
+			census.ComputeFromRGB(leftRGB, fromRGB, GrayscaleWeights::BT709);
+			census.Compute(leftGray, fromGray);
+			success &= Check(std::string("CENSUS from RGB (") + (window == CensusWindow::W5x5 ? "5x5" : "9x7") + ")", Equal(fromRGB, fromGray));
+		}
+
+		for (int mode = 0; mode < 4; mode++)
+		{
+			SemiGlobalMatching sgmRGB(maxDisparity, true, AggregationDirections::Nr8);
+			SemiGlobalMatching sgmGray(maxDisparity, true, AggregationDirections::Nr8);
+			for (SemiGlobalMatching *sgm : {&sgmRGB, &sgmGray})
+			{
+				sgm->SetGrayscaleWeights(GrayscaleWeights::BT709);
+				sgm->SetCompactCostVolume(mode == 1);
+				sgm->SetRowStreaming(mode == 2);
+				if (mode == 3)
+					sgm->SetHierarchical(2);
+			}
+			const char *names[] = {"dense", "compact", "row streaming", "hierarchical"};
+			success &= Check(std::string("SGM of RGB images (") + names[mode] + ")", Equal(sgmRGB.ComputeDisparities(leftRGB, rightRGB), sgmGray.ComputeDisparities(leftGray, rightGray)));
+		}
+
+		StereoSession session(maxDisparity, true, AggregationDirections::Nr8);
+		session.GetMatcher().SetGrayscaleWeights(GrayscaleWeights::BT709);
+		Tensor<float> sessionDisparities;
+		session.Wait(session.Submit(leftRGB, rightRGB, sessionDisparities));
+		SemiGlobalMatching sgm(maxDisparity, true, AggregationDirections::Nr8);
+		success &= Check("StereoSession of RGB images", Equal(sessionDisparities, sgm.ComputeDisparities(leftGray, rightGray)));
+		if (success)
+			std::cout << "Grayscale: all conversions, CENSUS images and disparities match" << std::endl;
+		return success;
+	}
+
+  private:
+	const size_t width = 128;
+	const size_t height = 64;
+	const size_t maxDisparity = 32;
+
+	Tensor<uint8_t> Pattern(size_t rows, size_t columns, size_t channels)
+	{
+		Tensor<uint8_t> image({rows, columns, channels});
+		for (size_t i = 0; i < image.GetTotalSize(); i++)
+			image[i] = static_cast<uint8_t>((i * 2654435761u) >> 11);
+		// The extremes of every channel
+		image[0] = image[1] = image[2] = 255;
+		return image;
+	}
+
+	// RGB image whose channels vary around the intensities of a grayscale image
+	Tensor<uint8_t> Colorize(const Tensor<uint8_t> &image, size_t seed)
+	{
+		Tensor<uint8_t> rgb({image.GetDimension(0), image.GetDimension(1), 3});
+		for (size_t i = 0; i < rgb.GetTotalSize(); i++)
+			rgb[i] = static_cast<uint8_t>(std::min(255, image[i / 3] + static_cast<int>(((i + seed) * 2654435761u) >> 29)));
+		return rgb;
+	}
+
+	Tensor<uint8_t> Reference(const TensorView<const uint8_t> &rgb, GrayscaleWeights weights)
+	{
+		Tensor<uint8_t> result({rgb.GetDimension(0), rgb.GetDimension(1)});
+		for (size_t y = 0; y < rgb.GetDimension(0); y++)
+		{
+			for (size_t x = 0; x < rgb.GetDimension(1); x++)
+			{
+				const int r = rgb.At(y, x, 0), g = rgb.At(y, x, 1), b = rgb.At(y, x, 2);
+				if (weights == GrayscaleWeights::Average)
+					result.At(y, x) = static_cast<uint8_t>((r + g + b) / 3);
+				else if (weights == GrayscaleWeights::BT601)
+					result.At(y, x) = static_cast<uint8_t>((77 * r + 150 * g + 29 * b + 128) / 256);
+				else
+					result.At(y, x) = static_cast<uint8_t>((54 * r + 183 * g + 19 * b + 128) / 256);
+			}
+		}
+		return result;
+	}
+
+	std::string Name(GrayscaleWeights weights)
+	{
+		return weights == GrayscaleWeights::Average ? "average" : (weights == GrayscaleWeights::BT601 ? "BT.601" : "BT.709");
+	}
+
+	template <typename T>
+	bool Equal(const Tensor<T> &first, const Tensor<T> &second)
+	{
+		if (first.GetDimensions() != second.GetDimensions())
+			return false;
+		for (size_t i = 0; i < first.GetTotalSize(); i++)
+		{
+			if (first[i] != second[i])
+				return false;
+		}
+		return true;
+	}
+
+	bool Check(const std::string &name, const bool success)
+	{
+		if (!success)
+			std::cout << "Grayscale " << name << ": different" << std::endl;
+		return success;
+	}
+};
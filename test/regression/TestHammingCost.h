@@ -0,0 +1,68 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <HammingCostKernels.h>
+
+using namespace ThunderVision;
+
+/**
+* Compares the forward and the backward Hamming cost kernels of every SIMD level with the portable kernels, including
+* counts which are not multiples of the vector widths, so the remainders are covered as well.
+*/
+class TestHammingCost
+{
+  public:
+	bool Run()
+	{
+		std::vector<uint64_t> vectors(maxCount);
+		for (size_t i = 0; i < vectors.size(); i++)
+		{
+			vectors[i] = (i + 1) * 0x9E3779B97F4A7C15ull;
+		}
+		vectors[3] = 0;
+		vectors[5] = UINT64_MAX;
+		const uint64_t base = 0xD1B54A32D192ED03ull;
+
+		const HammingCostKernels portable = SelectHammingCostKernels(SimdLevel::Portable);
+		bool success = true;
+		for (SimdLevel level : {SimdLevel::AVX2, SimdLevel::AVX512})
+		{
+			const HammingCostKernels kernels = SelectHammingCostKernels(level);
+			if (kernels.level != level)
+			{
+				std::cout << "HammingCost: level " << static_cast<int>(level) << " is not supported by the CPU" << std::endl;
+				continue;
+			}
+			for (size_t count = 0; count <= maxCount; count++)
+			{
+				success &= Check("forward", level, count, Compare(portable.forward, kernels.forward, base, vectors.data(), count));
+				success &= Check("backward", level, count, Compare(portable.backward, kernels.backward, base, vectors.data() + maxCount - 1, count));
+			}
+		}
+		if (success)
+			std::cout << "HammingCost: all kernels match" << std::endl;
+		return success;
+	}
+
+  private:
+	const size_t maxCount = 45;
+
+	bool Compare(HammingCostKernel expected, HammingCostKernel kernel, const uint64_t base, const uint64_t *vectors, const size_t count)
+	{
+		// One sentinel after the costs detects writes beyond count
+		std::vector<uint16_t> expectedCosts(count + 1, 0xABCD);
+		std::vector<uint16_t> costs(count + 1, 0xABCD);
+		expected(base, vectors, count, expectedCosts.data());
+		kernel(base, vectors, count, costs.data());
+		return costs == expectedCosts;
+	}
+
+	bool Check(const std::string &name, const SimdLevel level, const size_t count, const bool success)
+	{
+		if (!success)
+			std::cout << "HammingCost: " << name << " kernel of level " << static_cast<int>(level) << " differs for count " << count << std::endl;
+		return success;
+	}
+};
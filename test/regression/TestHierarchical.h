@@ -0,0 +1,66 @@
+#pragma once
+#include <cfenv>
+#include <iostream>
+#include <vector>
+
+#include <SemiGlobalMatching.h>
+
+#include "DisparityAccuracy.h"
+#include "SyntheticStereo.h"
+
+using namespace ThunderVision;
+
+/**
+* Compares the coarse to fine disparities with the ground truth of a random dot pair. The margins of the CENSUS
+* transform and the median filter, the left border without matches and the occluded pixels are excluded. At least
+* 95% of the remaining valid disparities have to be within one of the ground truth, and the consistency check may
+* invalidate at most 15% of them, as for the full search. With a uniqueness ratio the coarser levels contain invalid
+* disparities, which must neither steer the bands nor raise floating point exceptions.
+*/
+class TestHierarchical
+{
+  public:
+	bool Run()
+	{
+		bool success = true;
+		for (bool consistencyCheck : {false, true})
+		{
+			// The full range fits into the band of the coarser levels for less than 64 / band
+			for (const auto &levelsAndBand : std::vector<std::pair<size_t, size_t>>{{1, 32}, {2, 32}, {3, 16}})
+			{
+				success &= Compare(consistencyCheck, levelsAndBand.first, levelsAndBand.second, 0.0f);
+			}
+			for (float ratio : {0.05f, 0.2f})
+			{
+				success &= Compare(consistencyCheck, 3, 16, ratio);
+			}
+		}
+		return success;
+	}
+
+  private:
+	const size_t width = 256;
+	const size_t height = 128;
+	const size_t maxDisparity = 64;
+	// CENSUS radius (5x5) plus median radius (3x3), doubled for the coarser levels
+	const size_t margin = 6;
+
+	bool Compare(const bool consistencyCheck, const size_t levels, const size_t band, const float uniquenessRatio)
+	{
+		auto pair = SyntheticStereo::GenerateRandomDot(width, height, maxDisparity, 11);
+
+		SemiGlobalMatching sgm(maxDisparity, consistencyCheck, AggregationDirections::Nr8);
+		sgm.SetHierarchical(levels, band);
+		sgm.SetUniquenessRatio(uniquenessRatio);
+		std::feclearexcept(FE_INVALID);
+		auto disparities = sgm.ComputeDisparities(pair.left, pair.right);
+		const bool invalidOperation = std::fetestexcept(FE_INVALID) != 0;
+
+		const DisparityAccuracy accuracy = DisparityAccuracy::Evaluate(disparities, pair.disparity, margin, margin + maxDisparity);
+		std::cout << "Hierarchical (consistency check " << consistencyCheck << ", " << levels << " levels, band " << band << ", uniqueness ratio " << uniquenessRatio
+				  << "): " << accuracy.correct << " of " << accuracy.total
+				  << " disparities within one of the ground truth, " << accuracy.invalid << " invalid"
+				  << (invalidOperation ? ", invalid floating point operation" : "") << std::endl;
+		return accuracy.Passed() && !invalidOperation;
+	}
+};
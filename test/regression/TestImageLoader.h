@@ -0,0 +1,141 @@
+#pragma once
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <ColorspaceConversion.h>
+#include <ThreadPool.h>
+
+#include "ImageLoader.h"
+
+using namespace ThunderVision;
+
+/**
+* Saves grey, RGB and RGBA images as PNG and checks that they are decoded into each channel layout with the expected
+* values, and that the parallel batch decode gives the same images as decoding the files one by one.
+*/
+class TestImageLoader
+{
+  public:
+	bool Run()
+	{
+		const std::filesystem::path directory = std::filesystem::temp_directory_path();
+		const std::string path = (directory / "ThunderVisionTestImageLoader.png").string();
+		bool success = true;
+
+		Tensor<uint8_t> rgb = Pattern({height, width, 3}, 1);
+		ImageLoader::SaveTensor(rgb, path);
+		Tensor<uint8_t> loaded;
+		ImageLoader::LoadImage(path, loaded, LCT_RGB);
+		success &= Check("RGB as RGB", Equal(loaded, rgb));
+		ImageLoader::LoadImage(path, loaded, LCT_RGBA);
+		success &= Check("RGB as RGBA", Equal(loaded, AddAlpha(rgb)));
+		Tensor<uint8_t> grayscale = ColorspaceConversion::ConvertToGrayscale<uint8_t>(rgb);
+		grayscale.Squeeze();
+		ImageLoader::LoadImage(path, loaded, LCT_GREY);
+		success &= Check("RGB as grey", Equal(loaded, grayscale));
+
+		Tensor<uint8_t> grey = Pattern({height, width}, 2);
+		ImageLoader::SaveTensor(grey, path);
+		const uint8_t *data = loaded.Data();
+		ImageLoader::LoadImage(path, loaded, LCT_GREY);
+		success &= Check("grey as grey", Equal(loaded, grey) && loaded.Data() == data);
+		ImageLoader::LoadImage(path, loaded, LCT_RGB);
+		success &= Check("grey as RGB", Equal(loaded, Replicate(grey)));
+
+		Tensor<uint8_t> rgba = Pattern({height, width, 4}, 3);
+		ImageLoader::SaveTensor(rgba, path);
+		ImageLoader::LoadImage(path, loaded, LCT_RGBA);
+		success &= Check("RGBA as RGBA", Equal(loaded, rgba));
+
+		std::vector<std::string> paths;
+		std::vector<Tensor<uint8_t>> expected;
+		for (size_t i = 0; i < 7; i++)
+		{
+			paths.push_back((directory / ("ThunderVisionTestImageLoader" + std::to_string(i) + ".png")).string());
+			expected.push_back(Pattern({height + i, width + 2 * i, 3}, 10 + i));
+			ImageLoader::SaveTensor(expected.back(), paths.back());
+		}
+		ThreadPool pool(3);
+		std::vector<Tensor<uint8_t>> images;
+		ImageLoader::LoadImages(paths, images, LCT_RGB, pool);
+		bool batchEqual = images.size() == expected.size();
+		for (size_t i = 0; i < images.size() && batchEqual; i++)
+			batchEqual &= Equal(images[i], expected[i]);
+		success &= Check("parallel batch", batchEqual);
+
+		for (const auto &file : paths)
+			std::remove(file.c_str());
+		std::remove(path.c_str());
+		success &= Check("missing file", Throws([&path, &loaded]() { ImageLoader::LoadImage(path, loaded, LCT_RGB); }));
+		success &= Check("missing file in batch", Throws([&paths, &images, &pool]() { ImageLoader::LoadImages(paths, images, LCT_GREY, pool); }));
+		return success;
+	}
+
+  private:
+	const size_t width = 37;
+	const size_t height = 23;
+
+	Tensor<uint8_t> Pattern(std::vector<size_t> dimensions, size_t seed)
+	{
+		Tensor<uint8_t> image(dimensions);
+		for (size_t i = 0; i < image.GetTotalSize(); i++)
+			image[i] = static_cast<uint8_t>(((i + seed * 7919) * 2654435761u) >> 13);
+		return image;
+	}
+
+	Tensor<uint8_t> AddAlpha(const Tensor<uint8_t> &rgb)
+	{
+		Tensor<uint8_t> rgba({height, width, 4});
+		for (size_t i = 0; i < height * width; i++)
+		{
+			for (size_t c = 0; c < 3; c++)
+				rgba[4 * i + c] = rgb[3 * i + c];
+			rgba[4 * i + 3] = 255;
+		}
+		return rgba;
+	}
+
+	Tensor<uint8_t> Replicate(const Tensor<uint8_t> &grey)
+	{
+		Tensor<uint8_t> rgb({height, width, 3});
+		for (size_t i = 0; i < rgb.GetTotalSize(); i++)
+			rgb[i] = grey[i / 3];
+		return rgb;
+	}
+
+	bool Equal(const Tensor<uint8_t> &first, const Tensor<uint8_t> &second)
+	{
+		if (first.GetDimensions() != second.GetDimensions())
+			return false;
+		for (size_t i = 0; i < first.GetTotalSize(); i++)
+		{
+			if (first[i] != second[i])
+				return false;
+		}
+		return true;
+	}
+
+	template <typename TFunction>
+	bool Throws(TFunction function)
+	{
+		try
+		{
+			function();
+		}
+		catch (ThunderException *e)
+		{
+			delete e;
+			return true;
+		}
+		return false;
+	}
+
+	bool Check(const std::string &name, const bool success)
+	{
+		std::cout << "ImageLoader " << name << ": " << (success ? "ok" : "failed") << std::endl;
+		return success;
+	}
+};
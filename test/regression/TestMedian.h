@@ -0,0 +1,131 @@
+#pragma once
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <limits>
+
+#include <MedianFilter.h>
+#include <MedianKernels.h>
+#include <Tensor.h>
+
+using namespace ThunderVision;
+
+/**
+* Compares the sorting network and histogram medians of every instruction set against sorting the window. The
+* MedianFilter is compared with sorting the windows of the whole image, whose elements outside of the image are the
+* alternating error values of the filter.
+*/
+class TestMedian
+{
+  public:
+	bool Run()
+	{
+		bool success = true;
+		for (int level = 0; level <= static_cast<int>(GetSupportedSimdLevel()); level++)
+		{
+			const SimdLevel simdLevel = static_cast<SimdLevel>(level);
+			success &= Check<float>(simdLevel, 1, 1, 0) && Check<float>(simdLevel, 2, 2, 0);
+			success &= Check<uint8_t>(simdLevel, 1, 1, 256) && Check<uint8_t>(simdLevel, 2, 2, 256) && Check<uint8_t>(simdLevel, 3, 3, 256) &&
+					   Check<uint8_t>(simdLevel, 4, 1, 7);
+			success &= Check<uint16_t>(simdLevel, 1, 1, 65536) && Check<uint16_t>(simdLevel, 2, 2, 65536) && Check<uint16_t>(simdLevel, 3, 2, 300);
+		}
+		success &= CheckFilter<float, 3, 3>(64, 9) && CheckFilter<float, 3, 3>(3, 3) && CheckFilter<uint8_t, 5, 3>(37, 8);
+		std::cout << "Median: " << (success ? "all kernels match" : "mismatch") << std::endl;
+		return success;
+	}
+
+  private:
+	const size_t width = 301;
+	const size_t height = 47;
+
+	template <typename T>
+	bool Check(SimdLevel level, size_t radiusX, size_t radiusY, uint32_t range)
+	{
+		std::mt19937 random(static_cast<uint32_t>(radiusX * 7 + radiusY));
+		Tensor<T> image({height, width});
+		for (size_t i = 0; i < image.GetTotalSize(); i++)
+		{
+			image[i] = range == 0 ? static_cast<T>(random() % 100000) / 7 : static_cast<T>(random() % range);
+		}
+
+		Tensor<T> medians({height, width});
+		if (!ComputeMedians(image.Data(), width, radiusX, radiusY, radiusX, width - radiusX, radiusY, height - radiusY, medians.Data(), width,
+							ThreadPool::GetDefault(), level))
+			return false;
+
+		std::vector<T> window;
+		for (size_t y = radiusY; y < height - radiusY; y++)
+		{
+			for (size_t x = radiusX; x < width - radiusX; x++)
+			{
+				window.clear();
+				for (size_t v = y - radiusY; v <= y + radiusY; v++)
+				{
+					for (size_t u = x - radiusX; u <= x + radiusX; u++)
+					{
+						window.push_back(image[v * width + u]);
+					}
+				}
+				std::sort(window.begin(), window.end());
+				if (medians[y * width + x] != window[(window.size() - 1) / 2])
+				{
+					std::cout << "Median " << 2 * radiusX + 1 << "x" << 2 * radiusY + 1 << " of " << sizeof(T) << " byte values differs at level "
+							  << static_cast<int>(level) << ", x " << x << " y " << y << std::endl;
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	template <typename T, size_t filterWidth, size_t filterHeight>
+	bool CheckFilter(size_t imageWidth, size_t imageHeight)
+	{
+		std::mt19937 random(static_cast<uint32_t>(imageWidth * 3 + imageHeight));
+		Tensor<T> image({imageHeight, imageWidth});
+		for (size_t i = 0; i < image.GetTotalSize(); i++)
+		{
+			image[i] = static_cast<T>(random() % 50);
+		}
+
+		ThreadPool pool(3);
+		MedianFilter filter;
+		const Tensor<T> filtered = filter.ApplyMedianFilter<filterWidth, filterHeight>(image, pool);
+
+		const size_t radiusX = filterWidth / 2;
+		const size_t radiusY = filterHeight / 2;
+		auto errorValue = std::numeric_limits<T>::max() - 1;
+		std::vector<T> window;
+		for (size_t y = 0; y < imageHeight; y++)
+		{
+			for (size_t x = 0; x < imageWidth; x++)
+			{
+				window.clear();
+				for (size_t v = y; v < y + filterHeight; v++)
+				{
+					for (size_t u = x; u < x + filterWidth; u++)
+					{
+						if (v >= radiusY && u >= radiusX && v - radiusY < imageHeight && u - radiusX < imageWidth)
+						{
+							window.push_back(image[(v - radiusY) * imageWidth + u - radiusX]);
+						}
+						else
+						{
+							window.push_back(static_cast<T>(errorValue));
+							errorValue *= -1;
+						}
+					}
+				}
+				std::sort(window.begin(), window.end());
+				if (filtered[y * imageWidth + x] != window[(window.size() - 1) / 2])
+				{
+					std::cout << "MedianFilter " << filterWidth << "x" << filterHeight << " of " << imageWidth << "x" << imageHeight << " differs at x " << x << " y " << y << std::endl;
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+};
@@ -0,0 +1,69 @@
+#pragma once
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <Profiler.h>
+
+using namespace ThunderVision;
+
+/**
+* Records scopes on two threads and checks the summary, the ring buffer which keeps the last RingSize records of a
+* thread and the Chrome trace. The timers are used directly, so the test does not depend on THUNDER_PROFILING.
+*/
+class TestProfiler
+{
+  public:
+	bool Run()
+	{
+		Profiler::Clear();
+		{
+			ScopedTimer outer("Outer");
+			ScopedTimer inner("Inner \"quoted\"");
+		}
+		std::thread([]() {
+			for (size_t i = 0; i < Profiler::RingSize + 10; i++)
+			{
+				ScopedTimer timer("Worker");
+			}
+		}).join();
+		Profiler::SetEnabled(false);
+		{
+			ScopedTimer disabled("Disabled");
+		}
+		Profiler::SetEnabled(true);
+
+		bool success = true;
+		size_t nrStages = 0;
+		for (const ProfileSummary &stage : Profiler::Summarize())
+		{
+			nrStages++;
+			const size_t expected = stage.name == "Worker" ? Profiler::RingSize : 1;
+			if (stage.count != expected || stage.minimum > stage.maximum || stage.total < stage.maximum)
+			{
+				std::cout << "Profiler: stage " << stage.name << " has " << stage.count << " records instead of " << expected << std::endl;
+				success = false;
+			}
+		}
+		if (nrStages != 3)
+		{
+			std::cout << "Profiler: " << nrStages << " stages instead of 3" << std::endl;
+			success = false;
+		}
+
+		std::ostringstream trace;
+		Profiler::WriteChromeTrace(trace);
+		const std::string text = trace.str();
+		if (text.find("\"traceEvents\"") == std::string::npos || text.find("\"name\": \"Inner \\\"quoted\\\"\"") == std::string::npos)
+		{
+			std::cout << "Profiler: unexpected Chrome trace" << std::endl;
+			success = false;
+		}
+
+		Profiler::Clear();
+		success &= Profiler::GetRecords().empty();
+		std::cout << "Profiler (compiled into the library: " << Profiler::IsCompiled() << "): " << (success ? "ok" : "failed") << std::endl;
+		return success;
+	}
+};
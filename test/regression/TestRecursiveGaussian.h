@@ -0,0 +1,61 @@
+#pragma once
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include <GaussianBlur.h>
+#include <RecursiveGaussian.h>
+
+using namespace ThunderVision;
+
+/**
+* Reports the accuracy of the recursive Gaussian against the FIR kernel of GaussianBlur with a radius of 4 sigma and
+* checks that ApplyGaussian switches to it above RecursiveSigmaThreshold.
+*/
+class TestRecursiveGaussian
+{
+  public:
+	bool Run()
+	{
+		std::mt19937 random(3);
+		Tensor<float> image({height, width});
+		for (size_t i = 0; i < image.GetTotalSize(); i++)
+		{
+			image[i] = static_cast<float>(random() % 256);
+		}
+
+		bool success = true;
+		for (double sigma : {8.0, 15.0, 25.0})
+		{
+			const int filterSize = 2 * static_cast<int>(std::ceil(4.0 * sigma)) + 1;
+			const Tensor<float> fir = gaussianBlur.ApplyGaussian(image, sigma, filterSize);
+			const Tensor<float> automatic = gaussianBlur.ApplyGaussian(image, sigma);
+
+			Tensor<float> recursive;
+			recursiveGaussian.Apply(TensorView<const float>(image), sigma, recursive);
+
+			double maxError = 0.0;
+			double meanError = 0.0;
+			for (size_t i = 0; i < fir.GetTotalSize(); i++)
+			{
+				const double error = std::abs(static_cast<double>(recursive[i]) - fir[i]);
+				maxError = std::max(maxError, error);
+				meanError += error;
+			}
+			meanError /= fir.GetTotalSize();
+
+			const bool selected = std::equal(recursive.Data(), recursive.Data() + recursive.GetTotalSize(), automatic.Data());
+			std::cout << "RecursiveGaussian sigma " << sigma << ": max error " << maxError << ", mean error " << meanError << " of 255"
+					  << (selected ? "" : ", not selected by ApplyGaussian") << std::endl;
+			success &= selected && maxError < 1.0 && meanError < 0.25;
+		}
+		return success;
+	}
+
+  private:
+	const size_t width = 320;
+	const size_t height = 240;
+
+	GaussianBlur gaussianBlur;
+	RecursiveGaussian recursiveGaussian;
+};
@@ -0,0 +1,173 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <SemiGlobalMatching.h>
+
+#include "ReferenceSGM.h"
+#include "SyntheticStereo.h"
+
+using namespace ThunderVision;
+
+/**
+* Accuracy and speed harness: every SGM variant matches random dot pairs with known disparities and is compared with
+* the scalar ReferenceSGM, both bit exact and within one disparity. The report lists the share of equal pixels, the
+* bad pixel rate (error > 1), the RMS error and the density against the ground truth next to the median time, so
+* changes of speed and quality are seen together. The margins of the CENSUS transform and the median are excluded.
+*/
+class TestReference
+{
+  public:
+	bool Run()
+	{
+		bool success = true;
+		for (size_t maxDisparity : {48, 37})
+		{
+			success &= RunVariants(maxDisparity);
+		}
+		return success;
+	}
+
+  private:
+	const size_t width = 192;
+	const size_t height = 96;
+	const size_t margin = 3;
+	const size_t repetitions = 3;
+
+	struct Variant
+	{
+		std::string name;
+		AggregationDirections directions;
+		bool consistencyCheck;
+		std::function<void(SemiGlobalMatching &)> configure;
+		ReferenceSGM::RightDisparities reference;
+		// Required shares of pixels equal to and within one of the reference, at most maxBad pixels may be bad
+		double minEqual;
+		double minWithinOne;
+		double maxBad;
+	};
+
+	struct Report
+	{
+		double equal = 0.0;
+		double withinOne = 0.0;
+		double bad = 0.0;
+		double rms = 0.0;
+		double density = 0.0;
+		double milliseconds = 0.0;
+	};
+
+	std::vector<Variant> GetVariants()
+	{
+		const auto none = ReferenceSGM::RightDisparities::None;
+		const auto level = [](SimdLevel level) { return [level](SemiGlobalMatching &sgm) { sgm.SetMaxSimdLevel(level); }; };
+		return {
+			{"Portable", AggregationDirections::Nr8, false, level(SimdLevel::Portable), none, 1.0, 1.0, 0.05},
+			{"SSE4.1", AggregationDirections::Nr8, false, level(SimdLevel::SSE41), none, 1.0, 1.0, 0.05},
+			{"AVX2", AggregationDirections::Nr8, false, level(SimdLevel::AVX2), none, 1.0, 1.0, 0.05},
+			{"Default", AggregationDirections::Nr8, false, [](SemiGlobalMatching &) {}, none, 1.0, 1.0, 0.05},
+			{"Nr4_Axis", AggregationDirections::Nr4_Axis, false, [](SemiGlobalMatching &) {}, none, 1.0, 1.0, 0.05},
+			{"Nr4_Diag", AggregationDirections::Nr4_Diag, false, [](SemiGlobalMatching &) {}, none, 1.0, 1.0, 0.05},
+			{"UInt16Saturated", AggregationDirections::Nr8, false, [](SemiGlobalMatching &sgm) { sgm.SetCostStorage(CostStorage::UInt16Saturated); }, none, 0.99, 0.99, 0.05},
+			{"RowStreaming", AggregationDirections::Nr8, false, [](SemiGlobalMatching &sgm) { sgm.SetRowStreaming(true); }, none, 1.0, 1.0, 0.05},
+			{"CompactCostVolume", AggregationDirections::Nr8, false, [](SemiGlobalMatching &sgm) { sgm.SetCompactCostVolume(true); }, none, 0.98, 0.99, 0.05},
+			{"Hierarchical", AggregationDirections::Nr8, false, [](SemiGlobalMatching &sgm) { sgm.SetHierarchical(2, 32); }, none, 0.0, 0.9, 0.05},
+			{"Parabolic", AggregationDirections::Nr8, false, [](SemiGlobalMatching &sgm) { sgm.SetSubpixelRefinement(SubpixelMode::Parabolic); }, none, 0.0, 0.99, 0.05},
+			{"Consistency Recompute", AggregationDirections::Nr8, true, [](SemiGlobalMatching &sgm) { sgm.SetConsistencyMode(ConsistencyMode::Recompute); },
+			 ReferenceSGM::RightDisparities::Recompute, 1.0, 1.0, 0.02},
+			{"Consistency Diagonal", AggregationDirections::Nr8, true, [](SemiGlobalMatching &sgm) { sgm.SetConsistencyMode(ConsistencyMode::Diagonal); },
+			 ReferenceSGM::RightDisparities::Diagonal, 1.0, 1.0, 0.02},
+		};
+	}
+
+	static std::vector<ReferenceSGM::Directions> GetReferenceDirections(AggregationDirections directions)
+	{
+		if (directions == AggregationDirections::Nr4_Axis)
+			return {{1, 0}, {0, 1}, {-1, 0}, {0, -1}};
+		if (directions == AggregationDirections::Nr4_Diag)
+			return {{1, 1}, {-1, 1}, {-1, -1}, {1, -1}};
+		return ReferenceSGM::AllDirections();
+	}
+
+	bool RunVariants(const size_t maxDisparity)
+	{
+		const StereoPair pair = SyntheticStereo::GenerateRandomDot(width, height, maxDisparity, 17);
+		std::cout << "Reference (" << width << "x" << height << ", " << maxDisparity << " disparities)" << std::endl;
+		std::cout << "    " << std::left << std::setw(24) << "variant" << std::right << std::setw(8) << "equal" << std::setw(10) << "within 1" << std::setw(8) << "bad"
+				  << std::setw(8) << "rms" << std::setw(9) << "density" << std::setw(10) << "ms" << std::endl;
+
+		bool success = true;
+		for (const Variant &variant : GetVariants())
+		{
+			ReferenceSGM reference(maxDisparity, GetReferenceDirections(variant.directions));
+			const Tensor<float> expected = reference.Compute(pair.left, pair.right, variant.reference);
+
+			SemiGlobalMatching sgm(maxDisparity, variant.consistencyCheck, variant.directions);
+			variant.configure(sgm);
+			Tensor<float> disparities = sgm.ComputeDisparities(pair.left, pair.right);
+			std::vector<double> times;
+			for (size_t i = 0; i < repetitions; i++)
+			{
+				const auto start = std::chrono::steady_clock::now();
+				disparities = sgm.ComputeDisparities(pair.left, pair.right);
+				times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+			}
+			std::sort(times.begin(), times.end());
+
+			Report report = Evaluate(disparities, expected, pair.disparity);
+			report.milliseconds = times[times.size() / 2];
+			const bool passed = report.equal >= variant.minEqual && report.withinOne >= variant.minWithinOne && report.bad <= variant.maxBad;
+			success &= passed;
+			std::cout << "    " << std::left << std::setw(24) << variant.name << std::right << std::fixed << std::setprecision(4) << std::setw(8) << report.equal
+					  << std::setw(10) << report.withinOne << std::setw(8) << report.bad << std::setw(8) << report.rms << std::setw(9) << report.density
+					  << std::setprecision(2) << std::setw(10) << report.milliseconds << (passed ? "" : "  FAILED") << std::endl;
+			std::cout.unsetf(std::ios::floatfield);
+			std::cout << std::setprecision(6);
+		}
+		return success;
+	}
+
+	Report Evaluate(const Tensor<float> &disparities, const Tensor<float> &expected, const Tensor<float> &truth)
+	{
+		const float invalid = std::numeric_limits<float>::max();
+		size_t total = 0, equal = 0, withinOne = 0;
+		size_t known = 0, valid = 0, bad = 0;
+		double squaredError = 0.0;
+		for (size_t y = margin; y < height - margin; y++)
+		{
+			for (size_t x = margin; x < width - margin; x++)
+			{
+				const size_t pixel = y * width + x;
+				const float disparity = disparities[pixel];
+				total++;
+				equal += disparity == expected[pixel] ? 1 : 0;
+				withinOne += disparity == expected[pixel] || (disparity != invalid && expected[pixel] != invalid && std::abs(disparity - expected[pixel]) <= 1.0f) ? 1 : 0;
+
+				if (truth[pixel] < 0.0f)
+					continue;
+				known++;
+				if (disparity == invalid)
+					continue;
+				valid++;
+				const double error = static_cast<double>(disparity) - truth[pixel];
+				squaredError += error * error;
+				bad += std::abs(error) > 1.0 ? 1 : 0;
+			}
+		}
+
+		Report report;
+		report.equal = static_cast<double>(equal) / total;
+		report.withinOne = static_cast<double>(withinOne) / total;
+		report.bad = valid > 0 ? static_cast<double>(bad) / valid : 1.0;
+		report.rms = valid > 0 ? std::sqrt(squaredError / valid) : 0.0;
+		report.density = known > 0 ? static_cast<double>(valid) / known : 0.0;
+		return report;
+	}
+};
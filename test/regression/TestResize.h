@@ -0,0 +1,117 @@
+#pragma once
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include <ImageResizing.h>
+
+using namespace ThunderVision;
+
+/**
+* Compares ImageResizing::Resize against a double precision reference for bilinear and area resizing, downscaling
+* by fractional and large factors and upscaling, on every instruction set. Float results have to be within 1e-3,
+* integer results within one.
+*/
+class TestResize
+{
+  public:
+	bool Run()
+	{
+		bool success = true;
+		for (size_t channels : {1, 3})
+		{
+			for (ResizeMode mode : {ResizeMode::Bilinear, ResizeMode::Area})
+			{
+				for (const auto &size : std::vector<std::pair<size_t, size_t>>{{160, 90}, {97, 61}, {20, 9}, {333, 250}})
+				{
+					success &= Check<float, float>(channels, mode, size.first, size.second, 1e-3) && Check<uint8_t, uint8_t>(channels, mode, size.first, size.second, 1.0) &&
+							   Check<uint16_t, float>(channels, mode, size.first, size.second, 1e-3);
+				}
+			}
+		}
+		std::cout << "Resize: " << (success ? "matches the reference" : "mismatch") << std::endl;
+		return success;
+	}
+
+  private:
+	const size_t width = 320;
+	const size_t height = 180;
+
+	// Bilinear sample at (scale * x, scale * y) and the coverage weighted mean of the covered pixels for area
+	double Reference(const Tensor<double> &image, ResizeMode mode, size_t outputWidth, size_t outputHeight, size_t x, size_t y, size_t c)
+	{
+		const size_t channels = image.GetDimension(2);
+		const double scaleX = static_cast<double>(width) / outputWidth;
+		const double scaleY = static_cast<double>(height) / outputHeight;
+		auto pixel = [&](int64_t px, int64_t py) {
+			px = std::min<int64_t>(px, width - 1);
+			py = std::min<int64_t>(py, height - 1);
+			return image[(py * width + px) * channels + c];
+		};
+
+		if (mode == ResizeMode::Bilinear)
+		{
+			const double px = scaleX * x;
+			const double py = scaleY * y;
+			const int64_t x0 = static_cast<int64_t>(px);
+			const int64_t y0 = static_cast<int64_t>(py);
+			const double ex = px - x0;
+			const double ey = py - y0;
+			return (1 - ex) * (1 - ey) * pixel(x0, y0) + ex * (1 - ey) * pixel(x0 + 1, y0) + (1 - ex) * ey * pixel(x0, y0 + 1) + ex * ey * pixel(x0 + 1, y0 + 1);
+		}
+
+		const double beginX = scaleX * x;
+		const double endX = std::min(scaleX * (x + 1), static_cast<double>(width));
+		const double beginY = scaleY * y;
+		const double endY = std::min(scaleY * (y + 1), static_cast<double>(height));
+		double sum = 0.0;
+		for (int64_t py = static_cast<int64_t>(beginY); py < endY; py++)
+		{
+			for (int64_t px = static_cast<int64_t>(beginX); px < endX; px++)
+			{
+				const double coverageX = std::min(endX, px + 1.0) - std::max(beginX, static_cast<double>(px));
+				const double coverageY = std::min(endY, py + 1.0) - std::max(beginY, static_cast<double>(py));
+				sum += coverageX * coverageY * pixel(px, py);
+			}
+		}
+		return sum / ((endX - beginX) * (endY - beginY));
+	}
+
+	template <typename TIn, typename TOut>
+	bool Check(size_t channels, ResizeMode mode, size_t outputWidth, size_t outputHeight, double tolerance)
+	{
+		std::mt19937 random(static_cast<uint32_t>(channels * 1000 + outputWidth));
+		Tensor<TIn> image({height, width, channels});
+		Tensor<double> reference({height, width, channels});
+		for (size_t i = 0; i < image.GetTotalSize(); i++)
+		{
+			image[i] = static_cast<TIn>(random() % 256);
+			reference[i] = static_cast<double>(image[i]);
+		}
+
+		for (int level = 0; level <= static_cast<int>(GetSupportedSimdLevel()); level++)
+		{
+			ImageResizing resizing(static_cast<SimdLevel>(level));
+			Tensor<TOut> resized;
+			resizing.Resize(TensorView<const TIn>(image), outputWidth, outputHeight, resized, mode);
+			for (size_t y = 0; y < outputHeight; y++)
+			{
+				for (size_t x = 0; x < outputWidth; x++)
+				{
+					for (size_t c = 0; c < channels; c++)
+					{
+						const double expected = Reference(reference, mode, outputWidth, outputHeight, x, y, c);
+						const double value = static_cast<double>(resized[(y * outputWidth + x) * channels + c]);
+						if (std::abs(value - expected) > tolerance)
+						{
+							std::cout << "Resize to " << outputWidth << "x" << outputHeight << (mode == ResizeMode::Area ? " area" : " bilinear") << " differs at (" << x << ", "
+									  << y << ") on level " << level << ": " << value << " != " << expected << std::endl;
+							return false;
+						}
+					}
+				}
+			}
+		}
+		return true;
+	}
+};
@@ -0,0 +1,94 @@
+#pragma once
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include <FilterUtil.h>
+#include <SeparableFilter.h>
+
+using namespace ThunderVision;
+
+/**
+* Compares the SIMD separable filter of every instruction set against the double precision FilterUtil reference:
+* float results within 1e-3, integer results within one after rounding. The fixed point results have to be identical
+* for all instruction sets.
+*/
+class TestSeparableFilter
+{
+  public:
+	bool Run()
+	{
+		bool success = true;
+		for (size_t channels : {1, 3})
+		{
+			for (size_t taps : {3, 7, 13})
+			{
+				success &= Check<float>(channels, taps, 1e-3) && Check<uint8_t>(channels, taps, 1.0) && Check<uint16_t>(channels, taps, 1.0);
+			}
+		}
+		std::cout << "SeparableFilter: " << (success ? "matches the reference" : "mismatch") << std::endl;
+		return success;
+	}
+
+  private:
+	const size_t width = 203;
+	const size_t height = 45;
+
+	Tensor<double> GaussianKernel(size_t taps)
+	{
+		const double sigma = taps / 4.0;
+		const int64_t half = static_cast<int64_t>(taps / 2);
+		Tensor<double> kernel({taps});
+		double sum = 0.0;
+		for (int64_t i = 0; i < static_cast<int64_t>(taps); i++)
+		{
+			kernel[i] = std::exp(-static_cast<double>((i - half) * (i - half)) / (2 * sigma * sigma));
+			sum += kernel[i];
+		}
+		for (size_t i = 0; i < taps; i++)
+		{
+			kernel[i] /= sum;
+		}
+		return kernel;
+	}
+
+	template <typename T>
+	bool Check(size_t channels, size_t taps, double tolerance)
+	{
+		std::mt19937 random(static_cast<uint32_t>(channels * 100 + taps));
+		Tensor<T> image({height, width, channels});
+		for (size_t i = 0; i < image.GetTotalSize(); i++)
+		{
+			image[i] = std::is_same<T, float>::value ? static_cast<T>((random() % 10000) / 37.0) : static_cast<T>(random() % (std::is_same<T, uint8_t>::value ? 256 : 65536));
+		}
+
+		const Tensor<double> kernel = GaussianKernel(taps);
+		FilterUtil reference;
+		const Tensor<double> expected = reference.ApplyFilter<0, 1, double>(reference.ApplyFilter<1, 0, double>(image, kernel), kernel);
+
+		Tensor<T> first;
+		for (int level = 0; level <= static_cast<int>(GetSupportedSimdLevel()); level++)
+		{
+			SeparableFilter filter(static_cast<SimdLevel>(level));
+			Tensor<T> filtered;
+			filter.Apply(TensorView<const T>(image), kernel, kernel, filtered);
+			for (size_t i = 0; i < filtered.GetTotalSize(); i++)
+			{
+				if (std::abs(static_cast<double>(filtered[i]) - expected[i]) > tolerance)
+				{
+					std::cout << "SeparableFilter " << taps << " taps, " << sizeof(T) << " byte values differ from the reference at level " << level << std::endl;
+					return false;
+				}
+			}
+
+			if (level == 0)
+				first = filtered;
+			else if (std::is_same<T, uint8_t>::value && !std::equal(first.Data(), first.Data() + first.GetTotalSize(), filtered.Data()))
+			{
+				std::cout << "SeparableFilter fixed point results differ between the instruction sets" << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+};
@@ -0,0 +1,96 @@
+#pragma once
+#include <iostream>
+#include <vector>
+
+#include <StereoSession.h>
+
+#include "SyntheticStereo.h"
+
+using namespace ThunderVision;
+
+/**
+* Submits a sequence of random dot pairs to a session and compares the disparities with the synchronous matcher, with
+* and without the consistency check. The output tensors are reused over the sequence and must not be reallocated.
+*/
+class TestStereoSession
+{
+  public:
+	bool Run()
+	{
+		bool success = true;
+		for (bool consistencyCheck : {false, true})
+		{
+			success &= Compare(consistencyCheck);
+		}
+		return success;
+	}
+
+  private:
+	const size_t width = 160;
+	const size_t height = 96;
+	const size_t maxDisparity = 48;
+	const size_t nrFrames = 6;
+
+	bool Compare(const bool consistencyCheck)
+	{
+		std::vector<StereoPair> pairs;
+		std::vector<Tensor<float>> expected;
+		SemiGlobalMatching sgm(maxDisparity, consistencyCheck, AggregationDirections::Nr8);
+		for (size_t i = 0; i < nrFrames; i++)
+		{
+			pairs.push_back(SyntheticStereo::GenerateRandomDot(width, height, maxDisparity, static_cast<unsigned int>(i + 11)));
+			expected.push_back(sgm.ComputeDisparities(pairs[i].left, pairs[i].right));
+		}
+
+		StereoSession session(maxDisparity, consistencyCheck, AggregationDirections::Nr8);
+		std::vector<Tensor<float>> outputs(2);
+		std::vector<const float *> buffers(2, nullptr);
+		bool success = true;
+		for (size_t i = 0; i < nrFrames; i++)
+		{
+			// Frame i - 2 used the same output, it has to be completed and checked before the output is reused
+			if (i >= 2)
+			{
+				session.Wait(i - 2);
+				success &= Check(i - 2, outputs[i % 2], expected[i - 2], buffers[i % 2]);
+			}
+			const uint64_t frame = session.Submit(pairs[i].left, pairs[i].right, outputs[i % 2]);
+			if (frame != i)
+			{
+				std::cout << "StereoSession: frame " << i << " was numbered " << frame << std::endl;
+				success = false;
+			}
+		}
+		session.Flush();
+		for (size_t i = nrFrames - 2; i < nrFrames; i++)
+		{
+			success &= session.Poll(i) && Check(i, outputs[i % 2], expected[i], buffers[i % 2]);
+		}
+		std::cout << "StereoSession (consistency check " << consistencyCheck << "): " << (success ? "all frames match" : "mismatch") << std::endl;
+		return success;
+	}
+
+	bool Check(const size_t frame, const Tensor<float> &output, const Tensor<float> &expected, const float *&buffer)
+	{
+		if (buffer != nullptr && buffer != output.Data())
+		{
+			std::cout << "StereoSession: the output of frame " << frame << " was reallocated" << std::endl;
+			return false;
+		}
+		buffer = output.Data();
+		if (output.GetDimensions() != expected.GetDimensions())
+		{
+			std::cout << "StereoSession: frame " << frame << " has different dimensions" << std::endl;
+			return false;
+		}
+		for (size_t i = 0; i < expected.GetTotalSize(); i++)
+		{
+			if (output[i] != expected[i])
+			{
+				std::cout << "StereoSession: frame " << frame << " differs at " << i << ": " << output[i] << " instead of " << expected[i] << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+};
@@ -0,0 +1,111 @@
+#pragma once
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <CensusTransform.h>
+#include <SemiGlobalMatching.h>
+#include <TensorFile.h>
+
+#include "SyntheticStereo.h"
+
+using namespace ThunderVision;
+
+/**
+* Writes images, CENSUS images, disparities and a strided view to raw tensor files and checks that the mapped views
+* and the copies read back are identical, and that wrong element types and damaged files are rejected.
+*/
+class TestTensorFile
+{
+  public:
+	bool Run()
+	{
+		const std::string path = (std::filesystem::temp_directory_path() / "ThunderVisionTestTensorFile.tensor").string();
+		auto pair = SyntheticStereo::GenerateRandomDot(width, height, maxDisparity, 5);
+		SemiGlobalMatching sgm(maxDisparity, false, AggregationDirections::Nr8);
+		Tensor<uint64_t> census;
+		sgm.GetCensusTransform().Compute(TensorView<const uint8_t>(pair.left), census);
+
+		bool success = true;
+		success &= Check("uint8_t image", RoundTrip(path, pair.left));
+		success &= Check("uint64_t census", RoundTrip(path, census));
+		success &= Check("float disparities", RoundTrip(path, sgm.ComputeDisparities(pair.left, pair.right)));
+		success &= Check("empty", RoundTrip(path, Tensor<int16_t>({0, 7})));
+
+		auto crop = TensorView<const uint8_t>(pair.left).Crop(3, 5, 20, 30).Transpose(0, 1);
+		TensorFile::Write(path, crop);
+		success &= Check("strided view", Equal(MappedTensorFile(path).GetView<uint8_t>(), crop));
+
+		MappedTensorFile mapped(path);
+		success &= Check("aligned data", reinterpret_cast<uintptr_t>(mapped.GetView<uint8_t>().Data()) % TensorFile::DataAlignment == 0);
+		success &= Check("wrong element type", Throws([&mapped]() { mapped.GetView<int8_t>(); }));
+		mapped.Close();
+
+		Truncate(path, 100);
+		success &= Check("truncated file", Throws([&path]() { MappedTensorFile file(path); }));
+		Truncate(path, 0);
+		success &= Check("empty file", Throws([&path]() { MappedTensorFile file(path); }));
+		std::remove(path.c_str());
+		success &= Check("missing file", Throws([&path]() { MappedTensorFile file(path); }));
+		return success;
+	}
+
+  private:
+	const size_t width = 96;
+	const size_t height = 48;
+	const size_t maxDisparity = 16;
+
+	template <typename T>
+	bool RoundTrip(const std::string &path, const Tensor<T> &tensor)
+	{
+		TensorFile::Write(path, tensor);
+		MappedTensorFile mapped(path);
+		Tensor<T> copy;
+		TensorFile::Read(path, copy);
+		return mapped.GetDimensions() == tensor.GetDimensions() && Equal(mapped.GetView<T>(), TensorView<const T>(tensor)) &&
+			   Equal(TensorView<const T>(copy), TensorView<const T>(tensor));
+	}
+
+	template <typename T>
+	bool Equal(const TensorView<const T> &first, const TensorView<const T> &second)
+	{
+		if (first.GetDimensions() != second.GetDimensions())
+			return false;
+		const Tensor<T> firstCopy = first.ToTensor();
+		const Tensor<T> secondCopy = second.ToTensor();
+		for (size_t i = 0; i < firstCopy.GetTotalSize(); i++)
+		{
+			if (firstCopy[i] != secondCopy[i])
+				return false;
+		}
+		return true;
+	}
+
+	void Truncate(const std::string &path, size_t size)
+	{
+		std::filesystem::resize_file(path, size);
+	}
+
+	template <typename TFunction>
+	bool Throws(TFunction function)
+	{
+		try
+		{
+			function();
+		}
+		catch (ThunderException *e)
+		{
+			delete e;
+			return true;
+		}
+		return false;
+	}
+
+	bool Check(const std::string &name, const bool success)
+	{
+		std::cout << "TensorFile " << name << ": " << (success ? "ok" : "failed") << std::endl;
+		return success;
+	}
+};
@@ -0,0 +1,97 @@
+#pragma once
+#include <iostream>
+
+#include <SemiGlobalMatching.h>
+#include <MedianFilter.h>
+#include <GaussianBlur.h>
+#include <ImageResizing.h>
+#include <TensorView.h>
+
+#include "SyntheticStereo.h"
+
+using namespace ThunderVision;
+
+/**
+* Embeds a stereo pair as one channel of larger RGB images and checks that the algorithms give the same results for
+* the strided views as for contiguous copies of the same pixels.
+*/
+class TestTensorView
+{
+  public:
+	bool Run()
+	{
+		auto pair = SyntheticStereo::GenerateRandomDot(width, height, maxDisparity, 11);
+		Tensor<uint8_t> leftFrame = Embed(pair.left);
+		Tensor<uint8_t> rightFrame = Embed(pair.right);
+
+		auto leftView = TensorView<const uint8_t>(leftFrame).Crop(offsetY, offsetX, height, width).Slice(2, 1);
+		auto rightView = TensorView<const uint8_t>(rightFrame).Crop(offsetY, offsetX, height, width).Slice(2, 1);
+
+		bool success = true;
+		success &= Check("ToTensor", Equal(leftView.ToTensor(), pair.left));
+		success &= Check("Transpose", leftView.Transpose(0, 1).At(5, 3) == pair.left.At({3, 5}));
+
+		for (bool streaming : {false, true})
+		{
+			SemiGlobalMatching sgmView(maxDisparity, true, AggregationDirections::Nr8);
+			sgmView.SetRowStreaming(streaming);
+			SemiGlobalMatching sgmTensor(maxDisparity, true, AggregationDirections::Nr8);
+			sgmTensor.SetRowStreaming(streaming);
+			success &= Check(streaming ? "SemiGlobalMatching (streaming)" : "SemiGlobalMatching", Equal(sgmView.ComputeDisparities(leftView, rightView), sgmTensor.ComputeDisparities(pair.left, pair.right)));
+		}
+
+		MedianFilter median;
+		success &= Check("MedianFilter", Equal(median.ApplyMedianFilter<3, 3>(leftView), median.ApplyMedianFilter<3, 3>(pair.left)));
+
+		GaussianBlur gaussian;
+		success &= Check("GaussianBlur", Equal(gaussian.ApplyGaussian(leftView, 1.5), gaussian.ApplyGaussian(pair.left, 1.5)));
+
+		ImageResizing resizing;
+		success &= Check("ImageResizing", Equal(resizing.DownscaleImage<uint8_t, float>(leftView, width / 3, height / 2), resizing.DownscaleImage<uint8_t, float>(pair.left, width / 3, height / 2)));
+		return success;
+	}
+
+  private:
+	const size_t width = 160;
+	const size_t height = 80;
+	const size_t maxDisparity = 32;
+	const size_t offsetX = 13;
+	const size_t offsetY = 7;
+
+	// Copies image into channel 1 of a larger RGB image at (offsetY, offsetX), all other values are random
+	Tensor<uint8_t> Embed(const Tensor<uint8_t> &image)
+	{
+		Tensor<uint8_t> frame({height + 2 * offsetY, width + 2 * offsetX, 3});
+		for (size_t i = 0; i < frame.GetTotalSize(); i++)
+		{
+			frame[i] = static_cast<uint8_t>((i * 2654435761u) >> 13);
+		}
+		for (size_t y = 0; y < height; y++)
+		{
+			for (size_t x = 0; x < width; x++)
+			{
+				frame.At(y + offsetY, x + offsetX, 1) = image.At(y, x);
+			}
+		}
+		return frame;
+	}
+
+	template <typename T>
+	bool Equal(const Tensor<T> &first, const Tensor<T> &second)
+	{
+		if (first.GetTotalSize() != second.GetTotalSize())
+			return false;
+		for (size_t i = 0; i < first.GetTotalSize(); i++)
+		{
+			if (first[i] != second[i])
+				return false;
+		}
+		return true;
+	}
+
+	bool Check(const std::string &name, const bool success)
+	{
+		std::cout << "TensorView " << name << ": " << (success ? "identical" : "different") << std::endl;
+		return success;
+	}
+};
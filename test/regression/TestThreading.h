@@ -0,0 +1,77 @@
+#pragma once
+#include <iostream>
+#include <string>
+
+#include <SemiGlobalMatching.h>
+
+#include "SyntheticStereo.h"
+
+using namespace ThunderVision;
+
+/**
+* Compares the disparities of one thread with those of four threads, so the split of the rows, columns and diagonals
+* of the aggregation and the per thread path buffers are covered on machines whose default pool has a single thread.
+* All cost storages, the row streaming and the compact volume are run with every direction set and consistency mode,
+* the disparities have to be bit identical. The odd image size gives chunks of different lengths.
+*/
+class TestThreading
+{
+  public:
+	bool Run()
+	{
+		auto pair = SyntheticStereo::GenerateRandomDot(width, height, maxDisparity, 17);
+		const char *modes[] = {"dense", "UInt16Saturated", "row streaming", "compact"};
+		const char *directionNames[] = {"Nr8", "Nr4_Axis", "Nr4_Diag"};
+		const AggregationDirections directions[] = {AggregationDirections::Nr8, AggregationDirections::Nr4_Axis, AggregationDirections::Nr4_Diag};
+
+		bool success = true;
+		for (int mode = 0; mode < 4; mode++)
+		{
+			for (int direction = 0; direction < 3; direction++)
+			{
+				for (int consistency = 0; consistency < 3; consistency++)
+				{
+					Tensor<float> disparities[2];
+					for (int run = 0; run < 2; run++)
+					{
+						SemiGlobalMatching sgm(maxDisparity, consistency > 0, directions[direction]);
+						sgm.SetNrThreads(run == 0 ? 1 : 4);
+						sgm.SetCostStorage(mode == 1 ? CostStorage::UInt16Saturated : CostStorage::UInt32);
+						sgm.SetRowStreaming(mode == 2);
+						sgm.SetCompactCostVolume(mode == 3);
+						sgm.SetConsistencyMode(consistency == 2 ? ConsistencyMode::Diagonal : ConsistencyMode::Recompute);
+						disparities[run] = sgm.ComputeDisparities(pair.left, pair.right);
+					}
+
+					const std::string name = std::string(modes[mode]) + ", " + directionNames[direction] +
+											 (consistency == 0 ? "" : (consistency == 1 ? ", recompute" : ", diagonal"));
+					if (!Equal(disparities[0], disparities[1]))
+					{
+						std::cout << "Threading (" << name << "): 1 and 4 threads differ" << std::endl;
+						success = false;
+					}
+				}
+			}
+		}
+		if (success)
+			std::cout << "Threading: 1 and 4 threads give identical disparities" << std::endl;
+		return success;
+	}
+
+  private:
+	const size_t width = 133;
+	const size_t height = 71;
+	const size_t maxDisparity = 32;
+
+	bool Equal(const Tensor<float> &first, const Tensor<float> &second)
+	{
+		if (first.GetDimensions() != second.GetDimensions())
+			return false;
+		for (size_t i = 0; i < first.GetTotalSize(); i++)
+		{
+			if (first[i] != second[i])
+				return false;
+		}
+		return true;
+	}
+};
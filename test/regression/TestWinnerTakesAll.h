@@ -0,0 +1,173 @@
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <SemiGlobalMatching.h>
+#include <WinnerTakesAllKernels.h>
+
+#include "SyntheticStereo.h"
+
+using namespace ThunderVision;
+
+/**
+* Compares the winner takes all kernels of every instruction set with a two pass reference: the first minimum, the
+* minimum over the disparities which are not its neighbours and the refined disparity. The costs contain many equal
+* values and saturated pixels, the disparity counts cover the vector tails. The right kernels are compared with the
+* minimum along the diagonals of the aggregated costs. The fixed point disparities of the matcher are compared with its
+* rounded float disparities.
+*/
+class TestWinnerTakesAll
+{
+  public:
+	bool Run()
+	{
+		bool success = true;
+		for (int level = 0; level <= static_cast<int>(SimdLevel::AVX2); level++)
+		{
+			const SimdLevel simdLevel = static_cast<SimdLevel>(level);
+			for (SubpixelMode mode : {SubpixelMode::None, SubpixelMode::Parabolic, SubpixelMode::Equiangular})
+			{
+				for (float ratio : {0.0f, 0.1f})
+				{
+					success &= Check<unsigned int>(simdLevel, mode, ratio) && Check<uint16_t>(simdLevel, mode, ratio);
+				}
+				success &= CheckRight<unsigned int>(simdLevel, mode) && CheckRight<uint16_t>(simdLevel, mode);
+			}
+		}
+		success &= CheckFixedPoint();
+		std::cout << "WinnerTakesAll: " << (success ? "all kernels match" : "mismatch") << std::endl;
+		return success;
+	}
+
+  private:
+	const size_t nrPixels = 97;
+
+	template <typename TAggregated>
+	float Reference(const TAggregated *costs, const size_t nrDisparities, const WinnerTakesAllParameters &parameters)
+	{
+		const size_t best = static_cast<size_t>(std::min_element(costs, costs + nrDisparities) - costs);
+		unsigned int second = UINT_MAX;
+		for (size_t d = 0; d < nrDisparities; d++)
+		{
+			if (d + 1 < best || d > best + 1)
+				second = std::min<unsigned int>(second, costs[d]);
+		}
+		if (parameters.uniquenessRatio > 0.0f && static_cast<float>(second) < static_cast<float>(costs[best]) * (1.0f + parameters.uniquenessRatio))
+			return parameters.invalidValue;
+		if (parameters.subpixel == SubpixelMode::None || best == 0 || best + 1 >= nrDisparities)
+			return static_cast<float>(best);
+
+		const float minus = static_cast<float>(costs[best - 1]);
+		const float center = static_cast<float>(costs[best]);
+		const float plus = static_cast<float>(costs[best + 1]);
+		const float denominator = parameters.subpixel == SubpixelMode::Parabolic ? 2.0f * (minus - 2.0f * center + plus) : 2.0f * (std::max(minus, plus) - center);
+		return denominator > 0.0f ? static_cast<float>(best) + (minus - plus) / denominator : static_cast<float>(best);
+	}
+
+	template <typename TAggregated>
+	bool Check(SimdLevel level, SubpixelMode mode, float ratio)
+	{
+		std::mt19937 random(static_cast<uint32_t>(static_cast<int>(mode) * 3 + sizeof(TAggregated)));
+		const WinnerTakesAllKernels<TAggregated> kernels = SelectWinnerTakesAllKernels<TAggregated>(level);
+		WinnerTakesAllParameters parameters;
+		parameters.subpixel = mode;
+		parameters.uniquenessRatio = ratio;
+
+		bool success = true;
+		for (size_t nrDisparities : {1, 3, 8, 16, 37, 64, 128})
+		{
+			const size_t stride = nrDisparities + 5;
+			std::vector<TAggregated> costs(nrPixels * stride);
+			for (size_t i = 0; i < costs.size(); i++)
+			{
+				const uint32_t range = i / stride % 3 == 0 ? 6 : 60000;
+				costs[i] = static_cast<TAggregated>(random() % range);
+			}
+			std::fill(costs.begin(), costs.begin() + stride, static_cast<TAggregated>(UINT16_MAX));
+
+			std::vector<float> disparities(nrPixels);
+			kernels.disparities(costs.data(), nrPixels, stride, nrDisparities, parameters, disparities.data());
+			for (size_t x = 0; x < nrPixels; x++)
+			{
+				const float expected = Reference(costs.data() + x * stride, nrDisparities, parameters);
+				if (disparities[x] != expected)
+				{
+					std::cout << "WinnerTakesAll mismatch (level " << static_cast<int>(level) << ", " << nrDisparities << " disparities, pixel " << x << "): "
+							  << disparities[x] << " instead of " << expected << std::endl;
+					success = false;
+					break;
+				}
+			}
+		}
+		return success;
+	}
+
+	bool CheckFixedPoint()
+	{
+		const StereoPair pair = SyntheticStereo::GenerateRandomDot(96, 48, 24, 7);
+		SemiGlobalMatching sgm(24, true, AggregationDirections::Nr8);
+		sgm.SetSubpixelRefinement(SubpixelMode::Parabolic);
+		sgm.SetUniquenessRatio(0.05f);
+		const Tensor<float> disparities = sgm.ComputeDisparities(pair.left, pair.right);
+		const Tensor<uint16_t> fixedDisparities = sgm.ComputeFixedPointDisparities(pair.left, pair.right);
+		for (size_t i = 0; i < disparities.GetTotalSize(); i++)
+		{
+			const uint16_t expected = disparities[i] == std::numeric_limits<float>::max() ? UINT16_MAX : static_cast<uint16_t>(std::lround(disparities[i] * (1 << DisparityFractionBits)));
+			if (fixedDisparities[i] != expected)
+			{
+				std::cout << "WinnerTakesAll fixed point mismatch (pixel " << i << "): " << fixedDisparities[i] << " instead of " << expected << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template <typename TAggregated>
+	bool CheckRight(SimdLevel level, SubpixelMode mode)
+	{
+		std::mt19937 random(static_cast<uint32_t>(static_cast<int>(mode) * 5 + sizeof(TAggregated)));
+		const WinnerTakesAllKernels<TAggregated> kernels = SelectWinnerTakesAllKernels<TAggregated>(level);
+		WinnerTakesAllParameters parameters;
+		parameters.subpixel = mode;
+
+		bool success = true;
+		for (size_t nrDisparities : {1, 3, 8, 16, 37, 64, 128})
+		{
+			for (size_t width : {size_t{1}, size_t{20}, nrPixels})
+			{
+				std::vector<TAggregated> costs(width * nrDisparities);
+				for (size_t i = 0; i < costs.size(); i++)
+				{
+					costs[i] = static_cast<TAggregated>(random() % (nrDisparities % 2 == 0 ? 6 : 60000));
+				}
+
+				std::vector<TAggregated> buffer(2 * (width + nrDisparities));
+				std::vector<float> disparities(width);
+				kernels.rightDisparities(costs.data(), width, nrDisparities, parameters, buffer.data(), disparities.data());
+				for (size_t x = 0; x < width; x++)
+				{
+					// The diagonal of right pixel x, the first minimum wins like in the left kernels
+					std::vector<TAggregated> diagonal(std::min(nrDisparities, width - x));
+					for (size_t d = 0; d < diagonal.size(); d++)
+					{
+						diagonal[d] = costs[(x + d) * nrDisparities + d];
+					}
+					const float expected = Reference(diagonal.data(), diagonal.size(), parameters);
+					if (disparities[x] != expected)
+					{
+						std::cout << "WinnerTakesAll right mismatch (level " << static_cast<int>(level) << ", " << nrDisparities << " disparities, pixel " << x
+								  << "): " << disparities[x] << " instead of " << expected << std::endl;
+						success = false;
+						break;
+					}
+				}
+			}
+		}
+		return success;
+	}
+};
@@ -1,6 +1,32 @@
 #include "ImageLoader.h"
 
+#include <cstdlib>
+#include <cstring>
 
+namespace
+{
+size_t GetChannels(LodePNGColorType colorType)
+{
+	switch (colorType)
+	{
+	case LCT_GREY:
+		return 1;
+	case LCT_RGB:
+		return 3;
+	case LCT_RGBA:
+		return 4;
+	default:
+		throw new ThunderException("Images can only be decoded as LCT_GREY, LCT_RGB or LCT_RGBA");
+	}
+}
+
+std::vector<size_t> GetDimensions(size_t height, size_t width, size_t channels)
+{
+	if (channels == 1)
+		return {height, width};
+	return {height, width, channels};
+}
+} // namespace
 
 ImageLoader::ImageLoader()
 {
@@ -10,3 +36,68 @@ ImageLoader::ImageLoader()
 ImageLoader::~ImageLoader()
 {
 }
+
+void ImageLoader::LoadImage(const std::string &path, Tensor<uint8_t> &image, LodePNGColorType colorType)
+{
+	const size_t channels = GetChannels(colorType);
+	std::vector<unsigned char> file;
+	auto error = lodepng::load_file(file, path);
+	if (error)
+		throw new ThunderException("Image loading failed: " + std::string(lodepng_error_text(error)));
+
+	LodePNGState state;
+	lodepng_state_init(&state);
+	unsigned width, height;
+	error = lodepng_inspect(&width, &height, &state, file.data(), file.size());
+
+	// lodepng reduces colour to grey by taking the red channel, so colour images are averaged below
+	const bool average = !error && colorType == LCT_GREY && state.info_png.color.colortype != LCT_GREY && state.info_png.color.colortype != LCT_GREY_ALPHA;
+	state.info_raw.colortype = average ? LCT_RGB : colorType;
+	state.info_raw.bitdepth = 8;
+
+	unsigned char *decoded = nullptr;
+	if (!error)
+		error = lodepng_decode(&decoded, &width, &height, &state, file.data(), file.size());
+	lodepng_state_cleanup(&state);
+	if (error)
+	{
+		std::free(decoded);
+		throw new ThunderException("Image loading failed: " + std::string(lodepng_error_text(error)));
+	}
+
+	const std::vector<size_t> dimensions = GetDimensions(height, width, channels);
+	if (image.GetDimensions() != dimensions)
+		image.Resize(dimensions);
+	if (average)
+	{
+		uint8_t *out = image.Data();
+		for (size_t i = 0, in = 0; i < image.GetTotalSize(); i++, in += 3)
+			out[i] = static_cast<uint8_t>((decoded[in] + decoded[in + 1] + decoded[in + 2]) / 3);
+	}
+	else
+	{
+		std::memcpy(image.Data(), decoded, image.GetTotalSize());
+	}
+	std::free(decoded);
+}
+
+void ImageLoader::LoadImages(const std::vector<std::string> &paths, std::vector<Tensor<uint8_t>> &images, LodePNGColorType colorType, ThreadPool &pool)
+{
+	images.resize(paths.size());
+	pool.ParallelFor(0, static_cast<int64_t>(paths.size()), [&](int64_t begin, int64_t end, size_t) {
+		for (int64_t i = begin; i < end; i++)
+			LoadImage(paths[i], images[i], colorType);
+	});
+}
+
+void ImageLoader::SaveTensor(const Tensor<uint8_t> &tensor, std::string path)
+{
+	const size_t channels = tensor.GetRank() == 2 ? 1 : tensor.GetDimension(2);
+	if (tensor.GetRank() < 2 || tensor.GetRank() > 3 || (channels != 1 && channels != 3 && channels != 4))
+		throw new ThunderException("Only rank 2 tensors and tensors with 1, 3 or 4 channels can be saved as images");
+
+	const LodePNGColorType colorType = channels == 1 ? LCT_GREY : (channels == 3 ? LCT_RGB : LCT_RGBA);
+	auto error = lodepng_encode_file(path.c_str(), tensor.Data(), static_cast<unsigned>(tensor.GetDimension(1)), static_cast<unsigned>(tensor.GetDimension(0)), colorType, 8);
+	if (error)
+		throw new ThunderException("Tensor saving failed: " + std::string(lodepng_error_text(error)));
+}
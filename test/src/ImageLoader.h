@@ -6,8 +6,10 @@
 #include <algorithm>
 #include <iterator>
 #include <iostream>
+#include <vector>
 
 #include <Tensor.h>
+#include <ThreadPool.h>
 
 #include "lodepng.h"
 
@@ -19,30 +21,25 @@ class ImageLoader
 	ImageLoader();
 	~ImageLoader();
 
+	/**
+	* Decodes a PNG straight into the channel layout of colorType: LCT_GREY gives {height, width}, LCT_RGB
+	* {height, width, 3} and LCT_RGBA {height, width, 4}. image is only resized if its dimensions differ. Colour PNGs
+	* decoded as LCT_GREY are averaged like ColorspaceConversion::ConvertToGrayscale, lodepng would take the red channel.
+	*/
+	static void LoadImage(const std::string &path, Tensor<uint8_t> &image, LodePNGColorType colorType = LCT_RGB);
+
 	static Tensor<uint8_t> LoadImage(std::string path)
 	{
-		std::vector<unsigned char> image;
-		unsigned width, height;
-
-		auto error = lodepng::decode(image, width, height, path.c_str());
-		if (error)
-		{
-			throw new ThunderException("Image loading failed: " + std::string(lodepng_error_text(error)));
-		}
-
-		Tensor<uint8_t> result({height, width, 3});
-		size_t resCnt = 0;
-		for (size_t i = 0; i < width * height * 4; i += 4)
-		{
-			for (size_t j = 0; j < 3; j++)
-			{
-				result[resCnt] = image[i + j];
-				resCnt++;
-			}
-		}
+		Tensor<uint8_t> result;
+		LoadImage(path, result, LCT_RGB);
 		return result;
 	}
 
+	/**
+	* Decodes the files in parallel on pool, images[i] is the image of paths[i].
+	*/
+	static void LoadImages(const std::vector<std::string> &paths, std::vector<Tensor<uint8_t>> &images, LodePNGColorType colorType = LCT_RGB, ThreadPool &pool = ThreadPool::GetDefault());
+
 	static void SaveTensor(const Tensor<int> &tensor, std::string path)
 	{
 		const size_t channels = tensor.GetRank() == 2 ? 1 : tensor.GetDimension(2);
@@ -52,42 +49,10 @@ class ImageLoader
 		SaveTensor(result, path);
 	}
 
-	static void SaveTensor(const Tensor<uint8_t> &tensor, std::string path)
-	{
-		assert((tensor.GetRank() == 3 && (tensor.GetDimension(2) == 3 || tensor.GetDimension(2) == 1)) || tensor.GetRank() == 2);
-
-		bool singleChannel = (tensor.GetRank() == 2 || tensor.GetDimension(2) == 1);
-
-		auto width = tensor.GetDimension(1);
-		auto height = tensor.GetDimension(0);
-		std::vector<unsigned char> image(height * width * 4);
-
-		size_t resCnt = 0;
-		for (size_t i = 0; i < width * height * 4; i += 4)
-		{
-			if (singleChannel)
-			{
-				for (size_t j = 0; j < 3; j++)
-				{
-					image[i + j] = tensor[resCnt];
-				}
-				resCnt++;
-			}
-			else
-			{
-				for (size_t j = 0; j < 3; j++)
-				{
-					image[i + j] = tensor[resCnt];
-					resCnt++;
-				}
-			}
-			image[i + 3] = 255;
-		}
-
-		auto error = lodepng::encode(path.c_str(), image, static_cast<unsigned>(width), static_cast<unsigned>(height));
-		if (error)
-			throw new ThunderException("Tensor saving failed" + std::string(lodepng_error_text(error)));
-	}
+	/**
+	* Encodes rank 2 tensors and tensors with 1, 3 or 4 channels as grey, RGB or RGBA PNG directly from the tensor data.
+	*/
+	static void SaveTensor(const Tensor<uint8_t> &tensor, std::string path);
 
 	static void SaveTensorScaled(const Tensor<float> &tensor, std::string path)
 	{
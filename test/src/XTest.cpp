@@ -9,6 +9,7 @@
 #include <SemiGlobalMatching.h>
 #include <LaneDetection.h>
 #include <MedianFilter.h>
+#include <Profiler.h>
 
 #include "ImageLoader.h"
 #include "ChannelConverter.h"
@@ -22,19 +23,16 @@ int main()
 {
 	try
 	{
-		ColorspaceConversion conversion;
-
 		std::cout << "Starting ..." << std::endl;
-		auto leftImage = ImageLoader::LoadImage("path/to/left/img.png");
-		auto rightImage = ImageLoader::LoadImage("path/to/right/img.png");
+		auto leftRGB = ImageLoader::LoadImage("path/to/left/img.png");
+		auto rightRGB = ImageLoader::LoadImage("path/to/right/img.png");
 
+		Tensor<uint8_t> leftImage, rightImage;
 		auto startGrayscale = std::chrono::high_resolution_clock::now();
-		leftImage = conversion.ConvertToGrayscale<uint8_t>(leftImage);
-		leftImage.Squeeze();
-		rightImage = conversion.ConvertToGrayscale<uint8_t>(rightImage);
-		rightImage.Squeeze();
+		ColorspaceConversion::ConvertToGrayscale(leftRGB, leftImage);
+		ColorspaceConversion::ConvertToGrayscale(rightRGB, rightImage);
 		auto endGrayscale = std::chrono::high_resolution_clock::now();
-		std::cout << "Time for grayscale conversion (2x): " << std::chrono::duration_cast<std::chrono::milliseconds>(endGrayscale - startGrayscale).count() << "ms (" << std::chrono::duration_cast<std::chrono::microseconds>(endGrayscale - startGrayscale).count() << " \xE6s)" << std::endl;
+		std::cout << "Time for grayscale conversion (2x): " << std::chrono::duration_cast<std::chrono::milliseconds>(endGrayscale - startGrayscale).count() << "ms (" << std::chrono::duration_cast<std::chrono::microseconds>(endGrayscale - startGrayscale).count() << " us)" << std::endl;
 
 		SemiGlobalMatching sgm(64, false, AggregationDirections::Nr8);
 		sgm.Prepare(leftImage.GetDimension(1), leftImage.GetDimension(0));
@@ -44,7 +42,11 @@ int main()
 		auto disparities = sgm.ComputeDisparities(leftImage, rightImage);
 
 		auto end = std::chrono::high_resolution_clock::now();
-		std::cout << "Total SGM time: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms (" << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << " \xE6s)" << std::endl;
+		std::cout << "Total SGM time: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms (" << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << " us)" << std::endl;
+		for (const ProfileSummary &stage : Profiler::Summarize())
+		{
+			std::cout << "  " << stage.name << ": " << stage.total << "ms" << std::endl;
+		}
 
 		for (size_t i = 0; i < disparities.GetTotalSize(); i++)
 		{